@@ -0,0 +1,122 @@
+#include <QTest>
+
+#include "fuzzymatcher.h"
+
+using namespace FMH;
+
+typedef QVector<QPair<int, int>> RANGES;
+
+static QVector<int> rowsOf(const QVector<FuzzyMatcher::Result> &results)
+{
+    QVector<int> res;
+    for (const auto &result : results) {
+        res << result.row;
+    }
+    return res;
+}
+
+static QVector<int> scoresOf(const QVector<FuzzyMatcher::Result> &results)
+{
+    QVector<int> res;
+    for (const auto &result : results) {
+        res << result.score;
+    }
+    return res;
+}
+
+class FuzzyMatcherTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void matchText_data()
+    {
+        QTest::addColumn<QString>("pattern");
+        QTest::addColumn<QString>("text");
+        QTest::addColumn<bool>("matches");
+        QTest::addColumn<int>("score");
+        QTest::addColumn<RANGES>("ranges");
+
+        // word start counted twice for the first character, camel case hump, and a gap of two
+        QTest::newRow("camel") << QStringLiteral("fb") << QStringLiteral("FooBar") << true << 51 << RANGES {{0, 1}, {3, 1}};
+        QTest::newRow("no hump") << QStringLiteral("fb") << QStringLiteral("fab") << true << 45 << RANGES {{0, 1}, {2, 1}};
+        QTest::newRow("case") << QStringLiteral("FB") << QStringLiteral("foobar") << true << 44 << RANGES {{0, 1}, {3, 1}};
+        QTest::newRow("consecutive") << QStringLiteral("abc") << QStringLiteral("abcxyz") << true << 72 << RANGES {{0, 3}};
+        QTest::newRow("gaps") << QStringLiteral("abc") << QStringLiteral("axbxcx") << true << 58 << RANGES {{0, 1}, {2, 1}, {4, 1}};
+        // the window is shrunk from its end, so the closer pair is the one highlighted
+        QTest::newRow("shrunk") << QStringLiteral("ab") << QStringLiteral("a_xab") << true << 36 << RANGES {{3, 2}};
+        QTest::newRow("order") << QStringLiteral("ba") << QStringLiteral("ab") << false << 0 << RANGES();
+        QTest::newRow("missing") << QStringLiteral("abd") << QStringLiteral("abc") << false << 0 << RANGES();
+    }
+
+    void matchText()
+    {
+        QFETCH(QString, pattern);
+        QFETCH(QString, text);
+        QFETCH(bool, matches);
+        QFETCH(int, score);
+        QFETCH(RANGES, ranges);
+
+        int resScore = 0;
+        RANGES resRanges;
+        QCOMPARE(FuzzyMatcher::matchText(pattern, text, &resScore, &resRanges), matches);
+
+        if (matches) {
+            QCOMPARE(resScore, score);
+            QCOMPARE(resRanges, ranges);
+        }
+    }
+
+    void ranking()
+    {
+        FuzzyMatcher matcher;
+        matcher.append(QStringLiteral("fab"));
+        matcher.append(QStringLiteral("FooBar"));
+        matcher.append(QStringLiteral("xyz"));
+        matcher.append(QStringLiteral("foo_bar"));
+
+        // the ties keep the order the candidates were added in
+        const auto res = matcher.match(QStringLiteral("fb"));
+        QCOMPARE(rowsOf(res), QVector<int>({1, 3, 0}));
+        QCOMPARE(scoresOf(res), QVector<int>({51, 51, 45}));
+
+        QCOMPARE(rowsOf(matcher.match(QString())), QVector<int>({0, 1, 2, 3}));
+        QCOMPARE(scoresOf(matcher.match(QString())), QVector<int>({0, 0, 0, 0}));
+        QCOMPARE(rowsOf(matcher.match(QStringLiteral("fb"), {0, 2})), QVector<int>({0}));
+        QVERIFY(matcher.match(QStringLiteral("q")).isEmpty());
+    }
+
+    void highlight()
+    {
+        FuzzyMatcher matcher;
+        matcher.append(QStringLiteral("fab"));
+        matcher.append(QStringLiteral("FooBar"));
+
+        QCOMPARE(matcher.highlight(QStringLiteral("fb"), 1), RANGES({{0, 1}, {3, 1}}));
+        QCOMPARE(matcher.highlight(QStringLiteral("ab"), 0), RANGES({{1, 2}}));
+        QVERIFY(matcher.highlight(QStringLiteral("zz"), 1).isEmpty());
+        QVERIFY(matcher.highlight(QStringLiteral("fb"), 2).isEmpty());
+        QVERIFY(matcher.highlight(QString(), 0).isEmpty());
+    }
+
+    // past a chunk the candidates are matched in parallel, the order stays the same
+    void chunks()
+    {
+        FuzzyMatcher matcher;
+        QVector<int> expected;
+        for (int i = 0; i < 20000; i++) {
+            if (i % 1000 == 0) {
+                matcher.append(QStringLiteral("FooBar"));
+                expected << i;
+            } else {
+                matcher.append(QStringLiteral("xyz"));
+            }
+        }
+
+        QCOMPARE(rowsOf(matcher.match(QStringLiteral("fb"))), expected);
+    }
+};
+
+QTEST_GUILESS_MAIN(FuzzyMatcherTest)
+
+#include "fuzzymatchertest.moc"
@@ -0,0 +1,175 @@
+#include <QRandomGenerator>
+#include <QTest>
+
+// the find functions are private to the filter, so the test is built along with them
+#include "textfilter.cpp"
+
+// the SIMD find functions of this build that the processor can run
+static QVector<QPair<QByteArray, FindFunction>> simdFunctions()
+{
+    QVector<QPair<QByteArray, FindFunction>> res;
+
+#if defined(__SSE2__)
+    res << qMakePair(QByteArray("sse2"), &findSse2);
+#endif
+
+#if defined(TEXTFILTER_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        res << qMakePair(QByteArray("avx2"), &findAvx2);
+    }
+#endif
+
+    return res;
+}
+
+static QVector<ushort> toText(const QString &value)
+{
+    QVector<ushort> res(value.size());
+    std::copy(value.utf16(), value.utf16() + value.size(), res.begin());
+    return res;
+}
+
+class TextFilterTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // the query placed at every position of the text, so the match falls on and across the block boundaries and in the
+    // tail, for queries shorter and longer than a block. A near miss before it shares the first and last characters
+    void findAtEveryPosition()
+    {
+        const auto functions = simdFunctions();
+        if (functions.isEmpty()) {
+            QSKIP("no SIMD version of find in this build");
+        }
+
+        for (const auto length : {1, 2, 3, 7, 8, 9, 15, 16, 17, 24, 33}) {
+            auto query = QString(length, QLatin1Char('a'));
+            query[0] = QLatin1Char('b');
+            query[length - 1] = QLatin1Char('c');
+
+            for (int size = length; size <= 72; size++) {
+                for (int position = 0; position <= size - length; position++) {
+                    auto value = QString(size, QLatin1Char('x'));
+                    value.replace(position, length, query);
+
+                    if (length > 2 && position >= length) {
+                        auto miss = query;
+                        miss[length / 2] = QLatin1Char('z');
+                        value.replace(position - length, length, miss);
+                    }
+
+                    const auto text = toText(value);
+                    const auto pattern = toText(query);
+                    const auto expected = findScalar(text.constData(), 0, size, pattern.constData(), length);
+                    QCOMPARE(expected, position);
+
+                    for (const auto &function : functions) {
+                        const auto found = function.second(text.constData(), 0, size, pattern.constData(), length);
+                        QVERIFY2(found == expected, qPrintable(QStringLiteral("%1: query of %2 at %3 in %4, found at %5").arg(QString::fromLatin1(function.first)).arg(length).arg(position).arg(size).arg(found)));
+
+                        // the range ends right before the end of the match
+                        const auto cut = function.second(text.constData(), 0, position + length - 1, pattern.constData(), length);
+                        QVERIFY2(cut == findScalar(text.constData(), 0, position + length - 1, pattern.constData(), length), function.first.constData());
+                    }
+                }
+            }
+        }
+    }
+
+    // random text over a small alphabet so the first and the last characters match often, searched in random ranges
+    void findAgreesWithScalar()
+    {
+        const auto functions = simdFunctions();
+        if (functions.isEmpty()) {
+            QSKIP("no SIMD version of find in this build");
+        }
+
+        QRandomGenerator random(42);
+
+        for (int round = 0; round < 20000; round++) {
+            QVector<ushort> text(1 + random.bounded(90));
+            for (auto &c : text) {
+                c = static_cast<ushort>('a' + random.bounded(3));
+            }
+
+            const auto length = 1 + random.bounded(qMin(text.size(), 40));
+            QVector<ushort> query(length);
+            if (random.bounded(4) != 0) {
+                const auto at = random.bounded(text.size() - length + 1);
+                std::copy(text.constBegin() + at, text.constBegin() + at + length, query.begin());
+            } else {
+                for (auto &c : query) {
+                    c = static_cast<ushort>('a' + random.bounded(3));
+                }
+            }
+
+            const auto from = random.bounded(text.size());
+            const auto to = from + random.bounded(text.size() - from + 1);
+            const auto expected = findScalar(text.constData(), from, to, query.constData(), length);
+
+            for (const auto &function : functions) {
+                const auto found = function.second(text.constData(), from, to, query.constData(), length);
+                QVERIFY2(found == expected, qPrintable(QStringLiteral("%1: round %2, expected %3, found %4").arg(QString::fromLatin1(function.first)).arg(round).arg(expected).arg(found)));
+            }
+        }
+    }
+
+    // a match never spans two fields or two rows
+    void matchKeepsFieldsApart()
+    {
+        TextFilter filter;
+        filter.append({QStringLiteral("Report.pdf"), QStringLiteral("application/pdf")});
+        filter.append({QStringLiteral("xa"), QStringLiteral("bx")});
+        filter.append({QStringLiteral("notes"), QStringLiteral("text/plain")});
+        filter.append({QStringLiteral("ABBA"), QString()});
+
+        QCOMPARE(filter.count(), 4);
+        QCOMPARE(filter.match(QStringLiteral("ab")), QVector<int>({3}));
+        QCOMPARE(filter.match(QStringLiteral("PDF")), QVector<int>({0}));
+        QCOMPARE(filter.match(QStringLiteral("t")), QVector<int>({0, 2}));
+        QCOMPARE(filter.match(QStringLiteral("sr")), QVector<int>());
+        QCOMPARE(filter.match(QString()), QVector<int>({0, 1, 2, 3}));
+        QCOMPARE(filter.match(QStringLiteral("t"), QVector<int>({2, 3})), QVector<int>({2}));
+    }
+
+    void matchAgreesWithContains()
+    {
+        QRandomGenerator random(7);
+        QVector<QStringList> rows;
+        TextFilter filter;
+
+        for (int i = 0; i < 500; i++) {
+            QStringList fields;
+            for (int j = random.bounded(3); j >= 0; j--) {
+                QString field(random.bounded(40), Qt::Uninitialized);
+                for (auto &c : field) {
+                    c = QLatin1Char(static_cast<char>((random.bounded(2) ? 'a' : 'A') + random.bounded(4)));
+                }
+                fields << field;
+            }
+
+            rows << fields;
+            filter.append(fields);
+        }
+
+        for (const auto query : {"a", "ab", "Abc", "dcba", "abcdabcdabcdabcdab", "aaaaaaaaaaaaaaaaaaaaaaaaa"}) {
+            QVector<int> expected;
+            for (int i = 0; i < rows.size(); i++) {
+                for (const auto &field : rows.at(i)) {
+                    if (field.contains(QLatin1String(query), Qt::CaseInsensitive)) {
+                        expected << i;
+                        break;
+                    }
+                }
+            }
+
+            QCOMPARE(filter.match(QLatin1String(query)), expected);
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(TextFilterTest)
+
+#include "textfiltertest.moc"
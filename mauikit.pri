@@ -183,12 +183,23 @@ contains(DEFINES, COMPONENT_ACCOUNTS):{
 
 contains(DEFINES, COMPONENT_FM):{
     message("INCLUDING FM COMPONENT")
+    QT *= sql
     HEADERS += \
         $$PWD/src/utils/fm/fm.h \
         $$PWD/src/utils/fm/fmlist.h \
         $$PWD/src/utils/fm/placeslist.h \
         $$PWD/src/utils/fm/downloader.h \
         $$PWD/src/utils/fm/fileloader.h \
+        $$PWD/src/utils/fm/dirwatcher.h \
+        $$PWD/src/utils/fm/direnumerator.h \
+        $$PWD/src/utils/fm/dirwalker.h \
+        $$PWD/src/utils/fm/metadataresolver.h \
+        $$PWD/src/utils/fm/dirsnapshot.h \
+        $$PWD/src/utils/fm/fileindex.h \
+        $$PWD/src/utils/fm/mediacatalogue.h \
+        $$PWD/src/utils/fm/dirstats.h \
+        $$PWD/src/utils/fm/thumbnailcache.h \
+        $$PWD/src/utils/fm/imagethumbnailer.h \
         $$PWD/src/utils/fm/thumbnailer.h
 
 
@@ -198,6 +209,16 @@ contains(DEFINES, COMPONENT_FM):{
         $$PWD/src/utils/fm/placeslist.cpp \
         $$PWD/src/utils/fm/downloader.cpp \
         $$PWD/src/utils/fm/fileloader.cpp \
+        $$PWD/src/utils/fm/dirwatcher.cpp \
+        $$PWD/src/utils/fm/direnumerator.cpp \
+        $$PWD/src/utils/fm/dirwalker.cpp \
+        $$PWD/src/utils/fm/metadataresolver.cpp \
+        $$PWD/src/utils/fm/dirsnapshot.cpp \
+        $$PWD/src/utils/fm/fileindex.cpp \
+        $$PWD/src/utils/fm/mediacatalogue.cpp \
+        $$PWD/src/utils/fm/dirstats.cpp \
+        $$PWD/src/utils/fm/thumbnailcache.cpp \
+        $$PWD/src/utils/fm/imagethumbnailer.cpp \
         $$PWD/src/utils/fm/thumbnailer.cpp
 
     INCLUDEPATH += $$PWD/src/utils/fm
@@ -214,6 +235,12 @@ HEADERS += \
     $$PWD/src/utils/fmstatic.h \
     $$PWD/src/mauikit.h \
     $$PWD/src/utils/fmh.h \
+    $$PWD/src/utils/mimecache.h \
+    $$PWD/src/utils/textfilter.h \
+    $$PWD/src/utils/fuzzymatcher.h \
+    $$PWD/src/utils/filecopier.h \
+    $$PWD/src/utils/filejobqueue.h \
+    $$PWD/src/utils/dirconfcache.h \
     $$PWD/src/utils/model_template/mauimodel.h \
     $$PWD/src/utils/model_template/mauilist.h \
     $$PWD/src/utils/handy.h \
@@ -229,6 +256,12 @@ SOURCES += \
     $$PWD/src/utils/fmstatic.cpp \
     $$PWD/src/mauikit.cpp \
     $$PWD/src/utils/fmh.cpp \
+    $$PWD/src/utils/mimecache.cpp \
+    $$PWD/src/utils/textfilter.cpp \
+    $$PWD/src/utils/fuzzymatcher.cpp \
+    $$PWD/src/utils/filecopier.cpp \
+    $$PWD/src/utils/filejobqueue.cpp \
+    $$PWD/src/utils/dirconfcache.cpp \
     $$PWD/src/utils/model_template/mauimodel.cpp \
     $$PWD/src/utils/model_template/mauilist.cpp \
     $$PWD/src/utils/handy.cpp \
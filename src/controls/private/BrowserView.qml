@@ -98,6 +98,16 @@ Maui.Page
         }
     }
 
+    /**
+      * The thumbnails of the items made ahead of the visible ones, in the cache buffer of the views, are requested as a
+      * prefetch until they are first scrolled into view, so they wait for the visible ones
+      */
+    function thumbnailSource(thumbnail, seen)
+    {
+        var source = thumbnail ? String(thumbnail) : ""
+        return !seen && source.indexOf("image://thumbnailer/") === 0 ? source + "#prefetch" : source
+    }
+
     /**
       *
       */
@@ -271,6 +281,11 @@ Maui.Page
             {
                 id: delegate
                 readonly property string path : model.path
+                readonly property bool inView : y + height > ListView.view.contentY && y < ListView.view.contentY + ListView.view.height
+                property bool seen : false
+
+                onInViewChanged: if(inView) seen = true
+                Component.onCompleted: seen = inView
 
                 width: ListView.view.width
                 height: control.listItemSize
@@ -287,7 +302,7 @@ Maui.Page
                 tooltipText: model.path
 
                 checkable: _listViewBrowser.checkable
-                imageSource: settings.showThumbnails ? model.thumbnail : ""
+                imageSource: settings.showThumbnails ? control.thumbnailSource(model.thumbnail, seen) : ""
                 checked: selectionBar ? selectionBar.contains(model.path) : false
                 opacity: model.hidden == "true" ? 0.5 : 1
                 draggable: true
@@ -442,6 +457,12 @@ Maui.Page
             {
 
                 property bool isCurrentItem : GridView.isCurrentItem
+                readonly property bool inView : y + height > GridView.view.contentY && y < GridView.view.contentY + GridView.view.height
+                property bool seen : false
+
+                onInViewChanged: if(inView) seen = true
+                Component.onCompleted: seen = inView
+
                 height: _gridViewBrowser.cellHeight
                 width: _gridViewBrowser.cellWidth
 
@@ -459,7 +480,7 @@ Maui.Page
                     readonly property string path : model.path
 
                     iconSizeHint: height * 0.4
-                    imageSource: settings.showThumbnails ? model.thumbnail : ""
+                    imageSource: settings.showThumbnails ? control.thumbnailSource(model.thumbnail, parent.seen) : ""
                     template.fillMode: Image.PreserveAspectFit
                     iconSource: model.icon
                     label1.text: model.label
@@ -753,6 +774,11 @@ Maui.Page
                         {
                             id: delegate
                             readonly property string path : model.path
+                            readonly property bool inView : y + height > ListView.view.contentY && y < ListView.view.contentY + ListView.view.height
+                            property bool seen : false
+
+                            onInViewChanged: if(inView) seen = true
+                            Component.onCompleted: seen = inView
 
                             width: ListView.view.width
                             height: implicitHeight
@@ -767,7 +793,7 @@ Maui.Page
 
                             iconSizeHint : Maui.Style.iconSizes.medium
                             imageSizeHint : height * 0.8
-                            imageSource: settings.showThumbnails ? model.thumbnail : ""
+                            imageSource: settings.showThumbnails ? control.thumbnailSource(model.thumbnail, seen) : ""
 
                             checkable: _millerListView.checkable
                             checked: selectionBar ? selectionBar.contains(model.path) : false
@@ -24,6 +24,7 @@
 
 #include "appsettings.h"
 #include "appview.h"
+#include "filejobqueue.h"
 #include "fmstatic.h"
 #include "handy.h"
 #include "mauiapp.h"
@@ -39,6 +40,7 @@
 #include "fm.h"
 #include "fmlist.h"
 #include "placeslist.h"
+#include "thumbnailcache.h"
 #include "thumbnailer.h"
 #endif
 
@@ -176,6 +178,13 @@ void MauiKit::registerTypes(const char *uri)
         return platform;
     });
 
+    qmlRegisterSingletonType<FMH::FileJobQueue>(uri, 1, 3, "FileJobs", [](QQmlEngine *engine, QJSEngine *scriptEngine) -> QObject * {
+        Q_UNUSED(scriptEngine)
+        auto queue = FMH::FileJobQueue::instance();
+        engine->setObjectOwnership(queue, QQmlEngine::CppOwnership);
+        return queue;
+    });
+
     /** Experimental **/
 #ifdef Q_OS_WIN32
     qmlRegisterType(componentUrl(QStringLiteral("labs/WindowControlsWindows.qml")), uri, 1, 1, "WindowControls");
@@ -205,6 +214,13 @@ void MauiKit::registerTypes(const char *uri)
     qmlRegisterType(componentUrl(QStringLiteral("FileBrowser.qml")), uri, 1, 0, "FileBrowser");
     qmlRegisterType(componentUrl(QStringLiteral("PlacesListBrowser.qml")), uri, 1, 0, "PlacesListBrowser");
     qmlRegisterType(componentUrl(QStringLiteral("FileDialog.qml")), uri, 1, 0, "FileDialog");
+
+    qmlRegisterSingletonType<FMH::ThumbnailCache>(uri, 1, 3, "Thumbnails", [](QQmlEngine *engine, QJSEngine *scriptEngine) -> QObject * {
+        Q_UNUSED(scriptEngine)
+        auto cache = FMH::ThumbnailCache::instance();
+        engine->setObjectOwnership(cache, QQmlEngine::CppOwnership);
+        return cache;
+    });
 #endif
 
 #ifdef COMPONENT_EDITOR
@@ -0,0 +1,261 @@
+#include "dirconfcache.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSettings>
+#include <QTimer>
+#include <QtConcurrent>
+
+#if !(defined Q_OS_ANDROID || defined Q_OS_WIN32 || defined Q_OS_MACOS || defined Q_OS_IOS)
+#include <KConfig>
+#include <KConfigGroup>
+#endif
+
+namespace FMH
+{
+static const int MAX_ENTRIES = 2000;
+static const int WRITE_DELAY = 500; // ms, the writes in between go together
+
+namespace
+{
+struct Key {
+    qint64 modified = -1; // ms, -1 when there is no file
+    qint64 size = -1;
+
+    bool operator==(const Key &other) const
+    {
+        return modified == other.modified && size == other.size;
+    }
+
+    bool operator!=(const Key &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+struct Entry {
+    Key key;
+    DirConfCache::Groups groups; // as parsed from the file
+    QHash<QString, QHash<QString, QVariant>> pending; // written to the cache but not to the file yet
+};
+
+/**
+ * Holds the timer that writes the pending changes, in the application thread
+ */
+class Writer : public QObject
+{
+public:
+    static Writer *instance()
+    {
+        static Writer *writer = []() -> Writer * {
+            const auto app = QCoreApplication::instance();
+            if (!app) {
+                return nullptr;
+            }
+
+            auto res = new Writer;
+            res->moveToThread(app->thread());
+            QObject::connect(app, &QCoreApplication::aboutToQuit, res, &DirConfCache::flush, Qt::DirectConnection);
+            return res;
+        }();
+
+        return writer;
+    }
+
+    void schedule()
+    {
+        QMetaObject::invokeMethod(this, [this]() {
+            if (!m_timer->isActive()) {
+                m_timer->start();
+            }
+        }, Qt::AutoConnection);
+    }
+
+private:
+    Writer()
+        : m_timer(new QTimer(this))
+    {
+        m_timer->setSingleShot(true);
+        m_timer->setInterval(WRITE_DELAY);
+        QObject::connect(m_timer, &QTimer::timeout, this, []() {
+            QtConcurrent::run(&DirConfCache::flush);
+        });
+    }
+
+    QTimer *m_timer;
+};
+}
+
+static QMutex mutex;
+static QMutex writeMutex; // one flush at a time, so the same file is never written twice at once
+static QHash<QString, Entry> cache;
+
+static Key keyOf(const QString &path)
+{
+    const QFileInfo info(path);
+    if (!info.exists()) {
+        return {};
+    }
+
+    return {info.lastModified().toMSecsSinceEpoch(), info.size()};
+}
+
+static DirConfCache::Groups parse(const QString &path)
+{
+    DirConfCache::Groups res;
+
+#if defined Q_OS_ANDROID || defined Q_OS_WIN32 || defined Q_OS_MACOS || defined Q_OS_IOS
+    QSettings file(path, QSettings::Format::IniFormat);
+    const auto groups = file.childGroups();
+    for (const auto &group : groups) {
+        file.beginGroup(group);
+        auto &values = res[group];
+        const auto keys = file.childKeys();
+        for (const auto &key : keys) {
+            values.insert(key, file.value(key).toString());
+        }
+        file.endGroup();
+    }
+#else
+    const KConfig file(path, KConfig::SimpleConfig);
+    const auto groups = file.groupList();
+    for (const auto &group : groups) {
+        const auto entries = file.entryMap(group);
+        auto &values = res[group];
+        for (auto it = entries.constBegin(); it != entries.constEnd(); it++) {
+            values.insert(it.key(), it.value());
+        }
+    }
+#endif
+
+    return res;
+}
+
+static DirConfCache::Groups withPending(const Entry &entry)
+{
+    auto res = entry.groups;
+    for (auto group = entry.pending.constBegin(); group != entry.pending.constEnd(); group++) {
+        auto &values = res[group.key()];
+        for (auto it = group.value().constBegin(); it != group.value().constEnd(); it++) {
+            values.insert(it.key(), it.value().toString());
+        }
+    }
+
+    return res;
+}
+
+// drops the entries with nothing pending, once there are too many
+static void trim()
+{
+    if (cache.size() < MAX_ENTRIES) {
+        return;
+    }
+
+    for (auto it = cache.begin(); it != cache.end();) {
+        it = it->pending.isEmpty() ? cache.erase(it) : it + 1;
+    }
+}
+
+DirConfCache::Groups DirConfCache::read(const QString &path)
+{
+    const auto key = keyOf(path);
+
+    {
+        QMutexLocker locker(&mutex);
+        const auto entry = cache.constFind(path);
+        if (entry != cache.constEnd() && entry->key == key) {
+            return withPending(entry.value());
+        }
+    }
+
+    const auto groups = key.modified < 0 ? Groups() : parse(path);
+
+    QMutexLocker locker(&mutex);
+    trim();
+    auto &entry = cache[path];
+    entry.key = key;
+    entry.groups = groups;
+    return withPending(entry);
+}
+
+QVector<DirConfCache::Groups> DirConfCache::readAll(const QStringList &paths)
+{
+    return QtConcurrent::blockingMapped<QVector<Groups>>(paths, &DirConfCache::read);
+}
+
+void DirConfCache::write(const QString &path, const QString &group, const QString &key, const QVariant &value)
+{
+    {
+        QMutexLocker locker(&mutex);
+        cache[path].pending[group].insert(key, value);
+    }
+
+    if (const auto writer = Writer::instance()) {
+        writer->schedule();
+    } else {
+        flush();
+    }
+}
+
+void DirConfCache::flush()
+{
+    QMutexLocker writeLocker(&writeMutex);
+
+    QHash<QString, QHash<QString, QHash<QString, QVariant>>> pending;
+    {
+        QMutexLocker locker(&mutex);
+        for (auto it = cache.begin(); it != cache.end(); it++) {
+            if (!it->pending.isEmpty()) {
+                pending.insert(it.key(), it->pending);
+            }
+        }
+    }
+
+    for (auto file = pending.constBegin(); file != pending.constEnd(); file++) {
+#if defined Q_OS_ANDROID || defined Q_OS_WIN32 || defined Q_OS_MACOS || defined Q_OS_IOS
+        QSettings settings(file.key(), QSettings::Format::IniFormat);
+        for (auto group = file->constBegin(); group != file->constEnd(); group++) {
+            settings.beginGroup(group.key());
+            for (auto it = group->constBegin(); it != group->constEnd(); it++) {
+                settings.setValue(it.key(), it.value());
+            }
+            settings.endGroup();
+        }
+        settings.sync();
+#else
+        KConfig config(file.key(), KConfig::SimpleConfig);
+        for (auto group = file->constBegin(); group != file->constEnd(); group++) {
+            auto kgroup = config.group(group.key());
+            for (auto it = group->constBegin(); it != group->constEnd(); it++) {
+                kgroup.writeEntry(it.key(), it.value());
+            }
+        }
+        config.sync();
+#endif
+
+        // the written values become part of the parsed ones, and the new time of the file keeps them valid
+        const auto key = keyOf(file.key());
+        QMutexLocker locker(&mutex);
+        auto &entry = cache[file.key()];
+        for (auto group = file->constBegin(); group != file->constEnd(); group++) {
+            auto &values = entry.groups[group.key()];
+            auto &written = entry.pending[group.key()];
+            for (auto it = group->constBegin(); it != group->constEnd(); it++) {
+                values.insert(it.key(), it.value().toString());
+
+                // unless it was written again meanwhile
+                if (written.value(it.key()) == it.value()) {
+                    written.remove(it.key());
+                }
+            }
+
+            if (written.isEmpty()) {
+                entry.pending.remove(group.key());
+            }
+        }
+        entry.key = key;
+    }
+}
+}
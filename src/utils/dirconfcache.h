@@ -0,0 +1,63 @@
+#ifndef DIRCONFCACHE_H
+#define DIRCONFCACHE_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+#include "mauikit_export.h"
+
+namespace FMH
+{
+/**
+ * @brief The DirConfCache class
+ * Cache of the parsed .directory files holding the configuration of the folders. Each file is parsed once and then
+ * served from memory for as long as its modification time and size stay the same.
+ * The writes are applied to the cache right away and written to the files a moment later, all the keys written to
+ * the same file in the meantime go in a single write.
+ */
+class MAUIKIT_EXPORT DirConfCache
+{
+public:
+    typedef QHash<QString, QHash<QString, QString>> Groups; // values by key, by group
+
+    /**
+     * @brief read
+     * It can be called from any thread
+     * @param path
+     * Local path of the .directory file
+     * @return
+     * The groups of the file along with the writes still pending, empty if there is no file
+     */
+    static Groups read(const QString &path);
+
+    /**
+     * @brief readAll
+     * Same as above for many files at once, the ones not cached are parsed in parallel
+     * @param paths
+     * @return
+     * The groups of each file, in the same order
+     */
+    static QVector<Groups> readAll(const QStringList &paths);
+
+    /**
+     * @brief write
+     * @param path
+     * Local path of the .directory file, it is created if needed
+     * @param group
+     * @param key
+     * @param value
+     */
+    static void write(const QString &path, const QString &group, const QString &key, const QVariant &value);
+
+    /**
+     * @brief flush
+     * Writes the pending changes now. It is done on its own when the application quits
+     */
+    static void flush();
+};
+}
+
+#endif // DIRCONFCACHE_H
@@ -0,0 +1,522 @@
+#include "filecopier.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QPointer>
+#include <QTimer>
+#include <QtConcurrent>
+
+#include <atomic>
+#include <cerrno>
+#include <functional>
+#include <vector>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace FMH;
+
+static const qint64 SMALL_FILE = 1024 * 1024; // files up to this size are copied in parallel
+static const qint64 KERNEL_CHUNK = 8 * 1024 * 1024; // bytes copied by the kernel between two progress reports
+static const qint64 BUFFER_SIZE = 1024 * 1024;
+static const int PROGRESS_INTERVAL = 250; // ms
+
+namespace FMH
+{
+struct CopyEntry {
+    QString source;
+    QString destination;
+    qint64 size = 0;
+    bool dir = false;
+    bool link = false;
+    bool done = false;
+};
+
+struct CopyState {
+    QList<QUrl> urls;
+    QString destination;
+
+    bool planned = false;
+    std::vector<CopyEntry> entries; // the folders go before their content
+    QStringList moved; // sources to remove once they are copied, when moving across filesystems
+    QHash<QString, QString> targets; // source to the destination picked for it, guarded by the mutex
+
+    std::atomic<qint64> total {0};
+    std::atomic<qint64> processed {0};
+
+    mutable QMutex mutex;
+    QStringList errors;
+
+    void addError(const QString &message)
+    {
+        QMutexLocker locker(&mutex);
+        errors << message;
+    }
+};
+}
+
+// a name not taken yet in the folder, in the way of "name (1).ext"
+static QString freeName(const QString &dir, const QString &name)
+{
+    const auto res = dir + "/" + name;
+    if (!QFileInfo::exists(res)) {
+        return res;
+    }
+
+    const QFileInfo info(name);
+    const auto base = info.completeBaseName().isEmpty() ? name : info.completeBaseName();
+    const auto suffix = info.completeBaseName().isEmpty() || info.suffix().isEmpty() ? QString() : "." + info.suffix();
+
+    for (int i = 1;; i++) {
+        const auto candidate = QString("%1/%2 (%3)%4").arg(dir, base, QString::number(i), suffix);
+        if (!QFileInfo::exists(candidate)) {
+            return candidate;
+        }
+    }
+}
+
+static void copyTimes(const QString &source, const QString &destination)
+{
+#ifdef Q_OS_UNIX
+    struct stat info;
+    if (::lstat(QFile::encodeName(source).constData(), &info) != 0) {
+        return;
+    }
+
+    struct timespec times[2];
+#if defined Q_OS_MACOS || defined Q_OS_IOS
+    times[0] = info.st_atimespec;
+    times[1] = info.st_mtimespec;
+#else
+    times[0] = info.st_atim;
+    times[1] = info.st_mtim;
+#endif
+    ::utimensat(AT_FDCWD, QFile::encodeName(destination).constData(), times, AT_SYMLINK_NOFOLLOW);
+#else
+    const QFileInfo info(source);
+    if (info.isDir()) {
+        return;
+    }
+
+    QFile file(destination);
+    if (file.open(QIODevice::ReadWrite)) {
+        file.setFileTime(info.lastRead(), QFileDevice::FileAccessTime);
+        file.setFileTime(info.lastModified(), QFileDevice::FileModificationTime);
+    }
+#endif
+}
+
+/**
+ * Copies the data of the source from the offset on, in the fastest way the files allow: a reflink, then
+ * copy_file_range, then sendfile, and last reading and writing large blocks. Each way picks up where the previous one
+ * stopped, so a filesystem that only supports part of them still gets the best of what it has.
+ */
+static bool copyData(QFile &in, QFile &out, const qint64 &offset, const qint64 &size, const std::function<void(qint64)> &onCopied, const CancelToken &token)
+{
+    qint64 position = offset;
+
+#ifdef Q_OS_LINUX
+    const auto inFd = in.handle();
+    const auto outFd = out.handle();
+
+#ifdef FICLONE
+    if (position == 0 && ::ioctl(outFd, FICLONE, inFd) == 0) {
+        onCopied(size);
+        return true;
+    }
+#endif
+
+#ifdef SYS_copy_file_range
+    while (position < size) {
+        if (token.isCancelled()) {
+            return false;
+        }
+
+        loff_t inOffset = position;
+        loff_t outOffset = position;
+        const auto res = ::syscall(SYS_copy_file_range, inFd, &inOffset, outFd, &outOffset, static_cast<size_t>(qMin(size - position, KERNEL_CHUNK)), 0u);
+        if (res > 0) {
+            position += res;
+            onCopied(res);
+            continue;
+        }
+
+        if (res < 0 && errno == EINTR) {
+            continue;
+        }
+
+        break; // not supported between these files, or the source got shorter
+    }
+#endif
+
+    // sendfile writes at the current position of the output
+    if (position < size && ::lseek(outFd, position, SEEK_SET) == position) {
+        while (position < size) {
+            if (token.isCancelled()) {
+                return false;
+            }
+
+            off_t inOffset = position;
+            const auto res = ::sendfile(outFd, inFd, &inOffset, static_cast<size_t>(qMin(size - position, KERNEL_CHUNK)));
+            if (res > 0) {
+                position += res;
+                onCopied(res);
+                continue;
+            }
+
+            if (res < 0 && errno == EINTR) {
+                continue;
+            }
+
+            break;
+        }
+    }
+#endif
+
+    if (position < size) {
+        if (!in.seek(position) || !out.seek(position)) {
+            return false;
+        }
+
+        QByteArray buffer(static_cast<int>(BUFFER_SIZE), Qt::Uninitialized);
+        while (position < size) {
+            if (token.isCancelled()) {
+                return false;
+            }
+
+            const auto read = in.read(buffer.data(), qMin(size - position, BUFFER_SIZE));
+            if (read <= 0) {
+                return false;
+            }
+
+            if (out.write(buffer.constData(), read) != read) {
+                return false;
+            }
+
+            position += read;
+            onCopied(read);
+        }
+    }
+
+    return true;
+}
+
+static void copyFile(CopyState &state, CopyEntry &entry, const CancelToken &token)
+{
+    if (entry.done || token.isCancelled()) {
+        return;
+    }
+
+    const QFileInfo source(entry.source);
+    const QFileInfo destination(entry.destination);
+
+    // left by a previous run: complete files already got the time of the source, the others are continued
+    qint64 offset = 0;
+    if (destination.exists()) {
+        if (destination.size() == entry.size && destination.lastModified() == source.lastModified()) {
+            state.processed += entry.size;
+            entry.done = true;
+            return;
+        }
+
+        offset = destination.size() < entry.size ? destination.size() : 0;
+    }
+
+    QFile in(entry.source);
+    if (!in.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        state.addError(QString("Could not read %1: %2").arg(entry.source, in.errorString()));
+        return;
+    }
+
+    QFile out(entry.destination);
+    if (!out.open(offset > 0 ? QIODevice::ReadWrite | QIODevice::Unbuffered : QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        state.addError(QString("Could not write %1: %2").arg(entry.destination, out.errorString()));
+        return;
+    }
+
+    state.processed += offset;
+    const auto copied = copyData(in, out, offset, entry.size, [&state](qint64 count) {
+        state.processed += count;
+    }, token);
+
+    out.close();
+
+    if (!copied) {
+        if (!token.isCancelled()) {
+            state.addError(QString("Could not copy %1 to %2").arg(entry.source, entry.destination));
+        }
+        return;
+    }
+
+    QFile::setPermissions(entry.destination, in.permissions());
+    copyTimes(entry.source, entry.destination);
+    entry.done = true;
+}
+
+// walks the sources and picks the destination of every item, the moves within a filesystem are done right away
+static void plan(CopyState &state, const FileCopier::MODE &mode)
+{
+    for (const auto &url : qAsConst(state.urls)) {
+        const auto sourcePath = url.toLocalFile();
+        const QFileInfo source(sourcePath);
+        if (!source.exists() && !source.isSymLink()) {
+            state.addError(QString("%1 does not exist").arg(sourcePath));
+            continue;
+        }
+
+        const auto destinationPath = freeName(state.destination, source.fileName());
+        {
+            QMutexLocker locker(&state.mutex);
+            state.targets.insert(sourcePath, destinationPath);
+        }
+
+        if (mode == FileCopier::MODE::MOVE) {
+            if (QDir().rename(sourcePath, destinationPath)) {
+                continue;
+            }
+
+            state.moved << sourcePath;
+        }
+
+        CopyEntry root;
+        root.source = sourcePath;
+        root.destination = destinationPath;
+        root.link = source.isSymLink();
+        root.dir = source.isDir() && !root.link;
+        root.size = root.dir || root.link ? 0 : source.size();
+        state.entries.push_back(root);
+
+        if (!root.dir) {
+            continue;
+        }
+
+        const QDir sourceDir(sourcePath);
+        QDirIterator it(sourcePath, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            it.next();
+            const auto info = it.fileInfo();
+
+            CopyEntry entry;
+            entry.source = info.filePath();
+            entry.destination = destinationPath + "/" + sourceDir.relativeFilePath(info.filePath());
+            entry.link = info.isSymLink();
+            entry.dir = info.isDir() && !entry.link;
+            entry.size = entry.dir || entry.link ? 0 : info.size();
+            state.entries.push_back(entry);
+        }
+    }
+
+    qint64 total = 0;
+    for (const auto &entry : state.entries) {
+        total += entry.size;
+    }
+
+    state.total = total;
+    state.planned = true;
+}
+
+static bool copyAll(CopyState &state, const FileCopier::MODE &mode, const CancelToken &token)
+{
+    if (!state.planned) {
+        plan(state, mode);
+    }
+
+    qint64 processed = 0;
+    for (const auto &entry : state.entries) {
+        processed += entry.done ? entry.size : 0;
+    }
+    state.processed = processed;
+
+    QVector<CopyEntry *> small;
+    QVector<CopyEntry *> big;
+
+    for (auto &entry : state.entries) {
+        if (entry.done) {
+            continue;
+        }
+
+        if (entry.dir) {
+            if (!QDir().mkpath(entry.destination)) {
+                state.addError(QString("Could not create %1").arg(entry.destination));
+            }
+        } else if (entry.link) {
+            if (QFileInfo(entry.destination).isSymLink() || QFile::link(QFileInfo(entry.source).symLinkTarget(), entry.destination)) {
+                entry.done = true;
+            } else {
+                state.addError(QString("Could not create the link %1").arg(entry.destination));
+            }
+        } else if (entry.size <= SMALL_FILE) {
+            small << &entry;
+        } else {
+            big << &entry;
+        }
+    }
+
+    // the small files are bound by the metadata work, so they go at once, and the big ones by the disk
+    QtConcurrent::blockingMap(small, [&state, &token](CopyEntry *entry) {
+        copyFile(state, *entry, token);
+    });
+
+    for (const auto &entry : qAsConst(big)) {
+        copyFile(state, *entry, token);
+    }
+
+    if (token.isCancelled()) {
+        return false;
+    }
+
+    // the folders get their times back once nothing else is written in them
+    for (auto it = state.entries.rbegin(); it != state.entries.rend(); it++) {
+        if (it->dir && !it->done && QFileInfo(it->destination).isDir()) {
+            copyTimes(it->source, it->destination);
+            it->done = true;
+        }
+    }
+
+    QMutexLocker locker(&state.mutex);
+    if (!state.errors.isEmpty()) {
+        return false;
+    }
+
+    for (const auto &source : qAsConst(state.moved)) {
+        const QFileInfo info(source);
+        const auto removed = info.isDir() && !info.isSymLink() ? QDir(source).removeRecursively() : QFile::remove(source);
+        if (!removed) {
+            state.errors << QString("Could not remove %1").arg(source);
+        }
+    }
+    state.moved.clear();
+
+    return state.errors.isEmpty();
+}
+
+FileCopier::FileCopier(const QList<QUrl> &urls, const QUrl &destinationDir, const MODE &mode, QObject *parent)
+    : QObject(parent)
+    , m_state(std::make_shared<CopyState>())
+    , m_mode(mode)
+    , m_timer(new QTimer(this))
+{
+    this->m_state->urls = urls;
+    this->m_state->destination = destinationDir.toLocalFile();
+
+    this->m_timer->setInterval(PROGRESS_INTERVAL);
+    connect(this->m_timer, &QTimer::timeout, this, &FileCopier::progressChanged);
+}
+
+FileCopier::~FileCopier()
+{
+    // the work keeps its own state alive and stops at the next block
+    this->m_token.cancel();
+}
+
+qint64 FileCopier::totalBytes() const
+{
+    return this->m_state->total;
+}
+
+qint64 FileCopier::processedBytes() const
+{
+    return this->m_state->processed;
+}
+
+int FileCopier::percent() const
+{
+    const qint64 total = this->m_state->total;
+    if (total <= 0) {
+        return this->m_state->planned && !this->m_running ? 100 : 0;
+    }
+
+    return static_cast<int>(this->m_state->processed * 100 / total);
+}
+
+int FileCopier::eta() const
+{
+    const auto elapsed = this->m_elapsed.isValid() ? this->m_elapsed.elapsed() : 0;
+    const auto copied = this->m_state->processed - this->m_startBytes;
+    if (!this->m_running || elapsed < PROGRESS_INTERVAL || copied <= 0) {
+        return -1;
+    }
+
+    const auto left = this->m_state->total - this->m_state->processed;
+    return static_cast<int>(left * elapsed / copied / 1000);
+}
+
+bool FileCopier::isRunning() const
+{
+    return this->m_running;
+}
+
+QStringList FileCopier::errors() const
+{
+    QMutexLocker locker(&this->m_state->mutex);
+    return this->m_state->errors;
+}
+
+QUrl FileCopier::destinationOf(const QUrl &url) const
+{
+    QMutexLocker locker(&this->m_state->mutex);
+    const auto path = this->m_state->targets.value(url.toLocalFile());
+    return path.isEmpty() ? QUrl() : QUrl::fromLocalFile(path);
+}
+
+void FileCopier::start()
+{
+    if (this->m_running) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&this->m_state->mutex);
+        this->m_state->errors.clear();
+    }
+
+    this->m_token = CancelToken();
+    this->m_running = true;
+    this->m_startBytes = this->m_state->processed;
+    this->m_elapsed.start();
+    this->m_timer->start();
+    emit this->runningChanged();
+
+    const auto state = this->m_state;
+    const auto token = this->m_token;
+    const auto mode = this->m_mode;
+    const QPointer<FileCopier> self(this);
+    QtConcurrent::run([self, state, token, mode]() {
+        const auto success = copyAll(*state, mode, token);
+        if (!self) {
+            return;
+        }
+
+        QMetaObject::invokeMethod(self, [self, success]() {
+            if (!self) {
+                return;
+            }
+
+            const auto copier = self.data();
+            copier->m_running = false;
+            copier->m_timer->stop();
+            emit copier->runningChanged();
+            emit copier->progressChanged();
+            emit copier->finished(success);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void FileCopier::cancel()
+{
+    this->m_token.cancel();
+}
@@ -0,0 +1,140 @@
+#ifndef FILECOPIER_H
+#define FILECOPIER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+#include <QUrl>
+
+#include <memory>
+
+#include "fmh.h"
+#include "mauikit_export.h"
+
+class QTimer;
+
+namespace FMH
+{
+struct CopyState;
+
+/**
+ * @brief The FileCopier class
+ * Copies or moves local files and folders into a destination folder without KIO.
+ * The data is cloned with a reflink when the filesystem supports it, and otherwise copied inside the kernel with
+ * copy_file_range or sendfile, falling back to reading and writing large blocks. The small files are copied in
+ * parallel and the big ones one after the other. The timestamps and permissions of the sources are kept.
+ * A cancelled copy can be started again, the files already copied are skipped and a file left half way is
+ * continued from where it stopped.
+ */
+class MAUIKIT_EXPORT FileCopier : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(qint64 totalBytes READ totalBytes NOTIFY progressChanged)
+    Q_PROPERTY(qint64 processedBytes READ processedBytes NOTIFY progressChanged)
+    Q_PROPERTY(int percent READ percent NOTIFY progressChanged)
+    Q_PROPERTY(int eta READ eta NOTIFY progressChanged)
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
+
+public:
+    enum MODE : quint8 {
+        COPY,
+        MOVE // the sources are renamed when possible, and otherwise copied and then removed
+    };
+    Q_ENUM(MODE)
+
+    /**
+     * @brief FileCopier
+     * @param urls
+     * Local files and folders to copy
+     * @param destinationDir
+     * Folder to copy them into, an item with a name already taken there gets a new one
+     * @param mode
+     * @param parent
+     */
+    FileCopier(const QList<QUrl> &urls, const QUrl &destinationDir, const MODE &mode = MODE::COPY, QObject *parent = nullptr);
+    ~FileCopier();
+
+    /**
+     * @brief totalBytes
+     * @return
+     * Size of all the data to copy, known once the sources have been walked
+     */
+    qint64 totalBytes() const;
+
+    /**
+     * @brief processedBytes
+     * @return
+     */
+    qint64 processedBytes() const;
+
+    /**
+     * @brief percent
+     * @return
+     */
+    int percent() const;
+
+    /**
+     * @brief eta
+     * @return
+     * Estimated number of seconds left, -1 while unknown
+     */
+    int eta() const;
+
+    bool isRunning() const;
+
+    /**
+     * @brief errors
+     * @return
+     * A message for every item that could not be copied
+     */
+    QStringList errors() const;
+
+    /**
+     * @brief destinationOf
+     * Where a source goes, which is not its own name when that was already taken in the destination folder
+     * @param url
+     * One of the urls the copier was given
+     * @return
+     * Empty until the copy has started, or if the source did not exist
+     */
+    Q_INVOKABLE QUrl destinationOf(const QUrl &url) const;
+
+public slots:
+    /**
+     * @brief start
+     * Starts the copy, or resumes it after it was cancelled
+     */
+    void start();
+
+    /**
+     * @brief cancel
+     * Stops the copy at the next block, it can be resumed later with start
+     */
+    void cancel();
+
+signals:
+    void progressChanged();
+    void runningChanged();
+
+    /**
+     * @brief finished
+     * @param success
+     * False if the copy was cancelled or some item failed
+     */
+    void finished(bool success);
+
+private:
+    std::shared_ptr<CopyState> m_state; // shared with the work, which may outlive the copier
+
+    MODE m_mode;
+    bool m_running = false;
+    CancelToken m_token;
+
+    QTimer *m_timer;
+    QElapsedTimer m_elapsed;
+    qint64 m_startBytes = 0; // processed bytes when the current run started, for the speed
+};
+}
+
+#endif // FILECOPIER_H
@@ -0,0 +1,290 @@
+#include "filejobqueue.h"
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QStorageInfo>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+using namespace FMH;
+
+static const int PROGRESS_INTERVAL = 250; // ms
+static const int MIN_THREADS = 4; // the jobs mostly wait on the disks, not on the processor
+
+// mount point holding the url, looked up on the closest existing parent for the paths not created yet
+static QString deviceOf(const QUrl &url)
+{
+    if (!url.isLocalFile()) {
+        return url.scheme() + "://" + url.host();
+    }
+
+    auto path = url.toLocalFile();
+    while (!QFileInfo::exists(path)) {
+        const auto parent = QFileInfo(path).path();
+        if (parent == path) {
+            break;
+        }
+        path = parent;
+    }
+
+    const QStorageInfo storage(path);
+    return storage.isValid() ? storage.rootPath() : QString();
+}
+
+FileJobQueue *FileJobQueue::instance()
+{
+    static FileJobQueue *queue = []() -> FileJobQueue * {
+        const auto app = QCoreApplication::instance();
+        if (!app) {
+            return nullptr;
+        }
+
+        auto res = new FileJobQueue;
+        res->moveToThread(app->thread());
+        return res;
+    }();
+
+    return queue;
+}
+
+FileJobQueue::FileJobQueue(QObject *parent)
+    : QObject(parent)
+    , m_pool(new QThreadPool(this))
+    , m_timer(new QTimer(this))
+{
+    this->m_pool->setMaxThreadCount(qMax(MIN_THREADS, QThread::idealThreadCount()));
+
+    this->m_timer->setInterval(PROGRESS_INTERVAL);
+    connect(this->m_timer, &QTimer::timeout, this, &FileJobQueue::changed);
+}
+
+uint FileJobQueue::enqueue(const QString &kind, const QList<QUrl> &urls, const Operation &operation, const PRIORITY &priority)
+{
+    const uint id = ++this->m_lastId;
+
+    if (urls.isEmpty()) {
+        QMetaObject::invokeMethod(this, [this, id]() {
+            emit this->jobFinished(id, true, {});
+        }, Qt::QueuedConnection);
+        return id;
+    }
+
+    Job job;
+    job.kind = kind;
+    job.priority = priority;
+    job.device = deviceOf(urls.first());
+    job.urls = urls;
+    job.owners.fill(id, urls.size());
+    job.tokens.fill(CancelToken(), urls.size());
+    job.operation = operation;
+
+    if (QThread::currentThread() == this->thread()) {
+        this->add(job);
+    } else {
+        QMetaObject::invokeMethod(this, [this, job]() {
+            this->add(job);
+        }, Qt::QueuedConnection);
+    }
+
+    return id;
+}
+
+void FileJobQueue::add(const Job &job)
+{
+    if (!this->m_timer->isActive()) {
+        this->m_timer->start();
+    }
+
+    const auto batch = std::find_if(this->m_queue.begin(), this->m_queue.end(), [&job](const Job &queued) {
+        return !job.kind.isEmpty() && queued.kind == job.kind && queued.priority == job.priority && queued.device == job.device;
+    });
+
+    if (batch != this->m_queue.end()) {
+        batch->urls << job.urls;
+        batch->owners << job.owners;
+        batch->tokens << job.tokens;
+    } else {
+        // after the jobs of the same or a higher priority
+        auto index = this->m_queue.size();
+        while (index > 0 && this->m_queue.at(index - 1).priority < job.priority) {
+            index--;
+        }
+        this->m_queue.insert(index, job);
+    }
+
+    this->schedule();
+    emit this->changed();
+}
+
+void FileJobQueue::schedule()
+{
+    for (int i = 0; i < this->m_queue.size();) {
+        if (this->m_deviceJobs.value(this->m_queue.at(i).device) >= this->m_deviceLimit) {
+            i++;
+            continue;
+        }
+
+        this->run(this->m_queue.takeAt(i));
+    }
+}
+
+void FileJobQueue::run(const Job &job)
+{
+    const auto key = job.owners.first();
+
+    auto running = job;
+    running.done = std::make_shared<std::atomic<int>>(0);
+    this->m_running.insert(key, running);
+    this->m_deviceJobs[job.device]++;
+
+    const auto urls = running.urls;
+    const auto operation = running.operation;
+    const auto tokens = running.tokens;
+    const auto done = running.done;
+
+    // the queue is never destroyed, so it can be reached from the work
+    QtConcurrent::run(this->m_pool, [this, key, urls, operation, tokens, done]() {
+        QVector<int> failed;
+        for (int i = 0; i < urls.size(); i++) {
+            // only the urls of the cancelled owner are skipped, the rest of the batch goes on
+            if (tokens.at(i).isCancelled()) {
+                failed << i;
+                continue;
+            }
+
+            if (!operation(urls.at(i))) {
+                failed << i;
+            }
+            (*done)++;
+        }
+
+        QMetaObject::invokeMethod(this, [this, key, failed]() {
+            this->finish(key, failed);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void FileJobQueue::finish(const uint &key, const QVector<int> &failed)
+{
+    const auto job = this->m_running.take(key);
+
+    if (--this->m_deviceJobs[job.device] <= 0) {
+        this->m_deviceJobs.remove(job.device);
+    }
+
+    this->m_finishedUrls += job.urls.size();
+    this->schedule();
+
+    if (this->m_queue.isEmpty() && this->m_running.isEmpty()) {
+        this->m_timer->stop();
+        this->m_finishedUrls = 0;
+    }
+
+    emit this->changed();
+
+    QHash<uint, QStringList> failures;
+    for (const auto &index : failed) {
+        failures[job.owners.at(index)] << job.urls.at(index).toString();
+    }
+
+    QVector<uint> ids;
+    for (const auto &id : job.owners) {
+        if (ids.isEmpty() || ids.last() != id) {
+            ids << id;
+        }
+    }
+
+    for (const auto &id : qAsConst(ids)) {
+        emit this->jobFinished(id, !failures.contains(id), failures.value(id));
+    }
+}
+
+void FileJobQueue::cancel(const uint &id)
+{
+    for (int i = 0; i < this->m_queue.size(); i++) {
+        auto &job = this->m_queue[i];
+        if (!job.owners.contains(id)) {
+            continue;
+        }
+
+        for (int j = job.owners.size() - 1; j >= 0; j--) {
+            if (job.owners.at(j) == id) {
+                job.owners.removeAt(j);
+                job.tokens.removeAt(j);
+                job.urls.removeAt(j);
+            }
+        }
+
+        if (job.urls.isEmpty()) {
+            this->m_queue.removeAt(i);
+        }
+
+        emit this->changed();
+        emit this->jobFinished(id, false, {});
+        return;
+    }
+
+    for (const auto &job : qAsConst(this->m_running)) {
+        const auto index = job.owners.indexOf(id);
+        if (index >= 0) {
+            job.tokens.at(index).cancel();
+            return;
+        }
+    }
+}
+
+bool FileJobQueue::isBusy() const
+{
+    return !this->m_queue.isEmpty() || !this->m_running.isEmpty();
+}
+
+int FileJobQueue::pending() const
+{
+    int res = 0;
+    for (const auto &job : this->m_queue) {
+        res += job.urls.size();
+    }
+
+    for (const auto &job : this->m_running) {
+        res += job.urls.size() - *job.done;
+    }
+
+    return res;
+}
+
+int FileJobQueue::percent() const
+{
+    int total = this->m_finishedUrls;
+    int done = this->m_finishedUrls;
+    for (const auto &job : this->m_queue) {
+        total += job.urls.size();
+    }
+
+    for (const auto &job : this->m_running) {
+        total += job.urls.size();
+        done += *job.done;
+    }
+
+    return total > 0 ? done * 100 / total : 100;
+}
+
+int FileJobQueue::deviceLimit() const
+{
+    return this->m_deviceLimit;
+}
+
+void FileJobQueue::setDeviceLimit(const int &value)
+{
+    const auto limit = qMax(1, value);
+    if (this->m_deviceLimit == limit) {
+        return;
+    }
+
+    this->m_deviceLimit = limit;
+    emit this->deviceLimitChanged();
+    this->schedule();
+}
@@ -0,0 +1,148 @@
+#ifndef FILEJOBQUEUE_H
+#define FILEJOBQUEUE_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+#include <QUrl>
+#include <QVector>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "fmh.h"
+#include "mauikit_export.h"
+
+class QThreadPool;
+class QTimer;
+
+namespace FMH
+{
+/**
+ * @brief The FileJobQueue class
+ * Runs the file operations, such as removing, renaming or creating files, on worker threads so the caller never waits
+ * for them. Each job applies one operation to a list of urls. The jobs started by the user go before the background
+ * ones, and only a few of them run at once on the same device, so a slow disk does not hold the others.
+ * Jobs of the same kind queued for the same device are batched into a single one while they wait.
+ * The progress of all the jobs is merged into a single percent, to be shown in QML.
+ */
+class MAUIKIT_EXPORT FileJobQueue : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool busy READ isBusy NOTIFY changed)
+    Q_PROPERTY(int pending READ pending NOTIFY changed)
+    Q_PROPERTY(int percent READ percent NOTIFY changed)
+    Q_PROPERTY(int deviceLimit READ deviceLimit WRITE setDeviceLimit NOTIFY deviceLimitChanged)
+
+public:
+    enum PRIORITY : quint8 {
+        BACKGROUND,
+        USER // started by the user, goes first
+    };
+    Q_ENUM(PRIORITY)
+
+    /**
+     * Applied to every url of a job on a worker thread, returns if it succeeded
+     */
+    typedef std::function<bool(const QUrl &url)> Operation;
+
+    /**
+     * @brief instance
+     * The queue lives in the application thread, the jobs can be queued from any thread
+     * @return
+     */
+    static FileJobQueue *instance();
+
+    /**
+     * @brief enqueue
+     * @param kind
+     * Name of the operation. Queued jobs of the same kind, priority and device are batched together, so the same kind
+     * must always mean the same operation. An empty kind is never batched
+     * @param urls
+     * @param operation
+     * @param priority
+     * @return
+     * Id of the job, it is reported by jobFinished even when it gets batched with others
+     */
+    uint enqueue(const QString &kind, const QList<QUrl> &urls, const Operation &operation, const PRIORITY &priority = PRIORITY::USER);
+
+    bool isBusy() const;
+
+    /**
+     * @brief pending
+     * @return
+     * Number of urls left, running or queued
+     */
+    int pending() const;
+
+    /**
+     * @brief percent
+     * @return
+     * Merged progress of the jobs since the queue was last idle
+     */
+    int percent() const;
+
+    /**
+     * @brief deviceLimit
+     * @return
+     * Maximum number of jobs running at once on the same device
+     */
+    int deviceLimit() const;
+    void setDeviceLimit(const int &value);
+
+public slots:
+    /**
+     * @brief cancel
+     * A queued job is dropped. A running one stops before its next url, the jobs it was batched with go on
+     * @param id
+     */
+    void cancel(const uint &id);
+
+signals:
+    void changed();
+    void deviceLimitChanged();
+
+    /**
+     * @brief jobFinished
+     * @param id
+     * @param success
+     * @param failed
+     * Urls the operation failed on
+     */
+    void jobFinished(uint id, bool success, QStringList failed);
+
+private:
+    FileJobQueue(QObject *parent = nullptr);
+
+    struct Job {
+        QString kind;
+        PRIORITY priority = PRIORITY::USER;
+        QString device;
+        QList<QUrl> urls;
+        QVector<uint> owners; // id of the job each url was queued with
+        QVector<CancelToken> tokens; // token of the owner of each url
+        Operation operation;
+        std::shared_ptr<std::atomic<int>> done; // urls processed so far, written by the worker
+    };
+
+    QList<Job> m_queue; // waiting, the user jobs first
+    QHash<uint, Job> m_running; // by the id of the first url
+    QHash<QString, int> m_deviceJobs; // running jobs per device
+
+    QThreadPool *m_pool;
+    QTimer *m_timer;
+
+    std::atomic<uint> m_lastId {0};
+    int m_deviceLimit = 2;
+    int m_finishedUrls = 0; // since the queue was last idle, for the merged progress
+
+    void add(const Job &job);
+    void schedule();
+    void run(const Job &job);
+    void finish(const uint &key, const QVector<int> &failed);
+};
+}
+
+#endif // FILEJOBQUEUE_H
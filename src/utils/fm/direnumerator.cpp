@@ -0,0 +1,404 @@
+#include "direnumerator.h"
+#include "mimecache.h"
+
+#include <QFile>
+#include <QMimeDatabase>
+#include <QUrl>
+
+#if defined Q_OS_LINUX
+#include <fcntl.h>
+#include <dirent.h>
+#include <grp.h>
+#include <limits.h>
+#include <pwd.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+#if defined STATX_TYPE && !defined Q_OS_ANDROID
+#define MAUI_HAVE_STATX
+#endif
+
+/**
+ * Record layout returned by the getdents64 system call
+ */
+struct DirEntry64 {
+    quint64 d_ino;
+    qint64 d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+static const int BUFFER_SIZE = 64 * 1024;
+static const int COUNT_BUFFER_SIZE = 16 * 1024;
+
+static inline bool isDotOrDotDot(const char *name)
+{
+    return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+static inline QString joinPath(const QString &dirPath, const QString &name)
+{
+    return dirPath.endsWith(QLatin1Char('/')) ? dirPath + name : dirPath + QLatin1Char('/') + name;
+}
+
+/**
+ * Number of visible entries of a directory, the same as QDir(path).count() - 2 but without building the entry list
+ */
+static int countEntries(const int &dirfd, const char *name)
+{
+    const int fd = openat(dirfd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return 0;
+    }
+
+    char buffer[COUNT_BUFFER_SIZE];
+    int count = 0;
+    forever {
+        const auto length = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+
+        for (long offset = 0; offset < length;) {
+            const auto entry = reinterpret_cast<const DirEntry64 *>(buffer + offset);
+            offset += entry->d_reclen;
+
+            if (entry->d_name[0] != '.') {
+                count++;
+            }
+        }
+    }
+
+    ::close(fd);
+    return count;
+}
+#endif
+
+using namespace FMH;
+
+DirEnumerator::DirEnumerator(const QStringList &nameFilters, const QDir::Filters &filters, const bool &recursive)
+    : m_filters(filters)
+    , m_recursive(recursive)
+    , m_mimeDatabase(new QMimeDatabase)
+{
+    for (const auto &filter : nameFilters) {
+        m_nameFilters << QRegExp(filter, Qt::CaseInsensitive, QRegExp::Wildcard);
+    }
+}
+
+DirEnumerator::~DirEnumerator()
+{
+    delete m_mimeDatabase;
+}
+
+bool DirEnumerator::isSupported()
+{
+#if defined Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool DirEnumerator::matchesName(const QString &name) const
+{
+    if (m_nameFilters.isEmpty()) {
+        return true;
+    }
+
+    for (const auto &filter : m_nameFilters) {
+        if (filter.exactMatch(name)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void DirEnumerator::setMatcher(const std::function<bool(const QString &name)> &matcher)
+{
+    m_matcher = matcher;
+}
+
+void DirEnumerator::setLazy(const bool &lazy)
+{
+    m_lazy = lazy;
+}
+
+FileItem DirEnumerator::fileItem(const QString &path)
+{
+#if defined Q_OS_LINUX
+    const auto index = path.lastIndexOf(QLatin1Char('/'));
+    if (index < 0) {
+        return FileItem();
+    }
+
+    const auto dirPath = index == 0 ? QStringLiteral("/") : path.left(index);
+    const auto name = QFile::encodeName(path.mid(index + 1));
+
+    const int fd = ::open(QFile::encodeName(dirPath).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return FileItem();
+    }
+
+    struct stat st;
+    const bool isLink = fstatat(fd, name.constData(), &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISLNK(st.st_mode);
+
+    const auto item = this->fileItem(fd, dirPath, name, isLink);
+
+    ::close(fd);
+    return item;
+#else
+    return getFileItem(QUrl::fromLocalFile(path));
+#endif
+}
+
+bool DirEnumerator::enumerate(const QString &path, const std::function<bool(const FileItem &item)> &callback)
+{
+    QStringList pending {path};
+    bool root = true;
+
+    while (!pending.isEmpty()) {
+        const auto status = this->enumerateDir(pending.takeLast(), callback, m_recursive ? &pending : nullptr);
+
+        if (status == STATUS::FAILED && root) {
+            return false;
+        }
+
+        if (status == STATUS::STOPPED) {
+            break;
+        }
+
+        root = false;
+    }
+
+    return true;
+}
+
+DirEnumerator::STATUS DirEnumerator::enumerateDir(const QString &path, const std::function<bool(const FileItem &item)> &callback, QStringList *subdirs)
+{
+#if defined Q_OS_LINUX
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return STATUS::FAILED;
+    }
+
+    QByteArray buffer(BUFFER_SIZE, Qt::Uninitialized);
+    bool stop = false;
+
+    forever {
+        const auto length = syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+        if (length <= 0) {
+            break;
+        }
+
+        for (long offset = 0; offset < length && !stop;) {
+            const auto entry = reinterpret_cast<const DirEntry64 *>(buffer.constData() + offset);
+            offset += entry->d_reclen;
+
+            const char *cname = entry->d_name;
+            if (isDotOrDotDot(cname)) {
+                continue;
+            }
+
+            if (cname[0] == '.' && !(m_filters & QDir::Hidden)) {
+                continue;
+            }
+
+            // d_type is enough most of the time, only symbolic links and some file systems need a stat
+            bool isDir = entry->d_type == DT_DIR;
+            if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK) {
+                struct stat st;
+                isDir = fstatat(fd, cname, &st, 0) == 0 && S_ISDIR(st.st_mode);
+            }
+
+            const auto name = QFile::decodeName(cname);
+
+            // like QDirIterator, do not follow symbolic links into other directories
+            if (isDir && subdirs && entry->d_type != DT_LNK) {
+                subdirs->append(joinPath(path, name));
+            }
+
+            const bool accepted = isDir ? (m_filters & QDir::AllDirs) || ((m_filters & QDir::Dirs) && this->matchesName(name)) : (m_filters & QDir::Files) && this->matchesName(name);
+            if (!accepted || (m_matcher && !m_matcher(name))) {
+                continue;
+            }
+
+            const auto item = this->fileItem(fd, path, QByteArray(cname), entry->d_type == DT_LNK);
+            if (item.isEmpty()) {
+                continue;
+            }
+
+            stop = !callback(item);
+        }
+
+        if (stop) {
+            break;
+        }
+    }
+
+    ::close(fd);
+    return stop ? STATUS::STOPPED : STATUS::DONE;
+#else
+    Q_UNUSED(path)
+    Q_UNUSED(callback)
+    Q_UNUSED(subdirs)
+    return STATUS::FAILED;
+#endif
+}
+
+FileItem DirEnumerator::fileItem(const int &dirfd, const QString &dirPath, const QByteArray &name, const bool &isLink)
+{
+    FileItem item;
+#if defined Q_OS_LINUX
+    quint32 mode = 0;
+    uint uid = 0, gid = 0;
+    MimeCache::Key key;
+
+#if defined MAUI_HAVE_STATX
+    struct statx st;
+    const unsigned int mask = STATX_TYPE | STATX_MODE | STATX_INO | STATX_UID | STATX_GID | STATX_SIZE | STATX_ATIME | STATX_MTIME | STATX_BTIME;
+    // a broken symbolic link can only be described by itself
+    if (statx(dirfd, name.constData(), AT_STATX_SYNC_AS_STAT, mask, &st) != 0 && statx(dirfd, name.constData(), AT_STATX_SYNC_AS_STAT | AT_SYMLINK_NOFOLLOW, mask, &st) != 0) {
+        return item;
+    }
+
+    mode = st.stx_mode;
+    uid = st.stx_uid;
+    gid = st.stx_gid;
+    item.size = static_cast<qint64>(st.stx_size);
+    item.modified = st.stx_mtime.tv_sec;
+    item.lastRead = st.stx_atime.tv_sec;
+    item.created = st.stx_mask & STATX_BTIME ? st.stx_btime.tv_sec : 0;
+    key.device = makedev(st.stx_dev_major, st.stx_dev_minor);
+    key.inode = st.stx_ino;
+#else
+    struct stat st;
+    if (fstatat(dirfd, name.constData(), &st, 0) != 0 && fstatat(dirfd, name.constData(), &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        return item;
+    }
+
+    mode = st.st_mode;
+    uid = st.st_uid;
+    gid = st.st_gid;
+    item.size = st.st_size;
+    item.modified = st.st_mtime;
+    item.lastRead = st.st_atime;
+    key.device = st.st_dev;
+    key.inode = st.st_ino;
+#endif
+    key.modified = item.modified;
+    key.size = item.size;
+
+    const auto filePath = joinPath(dirPath, QFile::decodeName(name));
+    const auto url = QUrl::fromLocalFile(filePath);
+    const bool isDir = S_ISDIR(mode);
+
+    item.url = url.toString();
+    item.label = QFile::decodeName(name);
+    item.owner = internString(this->userName(uid));
+    item.group = internString(this->groupName(gid));
+
+    if (isLink && !m_lazy) {
+        char target[PATH_MAX];
+        const auto length = readlinkat(dirfd, name.constData(), target, sizeof(target) - 1);
+        if (length > 0) {
+            item.symlink = QDir(dirPath).absoluteFilePath(QFile::decodeName(QByteArray(target, static_cast<int>(length))));
+        }
+    }
+
+    const auto euid = geteuid();
+    const auto permissions = euid == 0 ? 07 : uid == euid ? (mode >> 6) & 07 : gid == getegid() ? (mode >> 3) & 07 : mode & 07;
+
+    item.setFlag(FileItem::IS_DIR, isDir);
+    item.setFlag(FileItem::IS_FILE, S_ISREG(mode));
+    item.setFlag(FileItem::IS_SYMLINK, isLink);
+    item.setFlag(FileItem::HIDDEN, name.startsWith('.'));
+    item.setFlag(FileItem::READABLE, permissions & 04);
+    item.setFlag(FileItem::WRITABLE, permissions & 02);
+    item.setFlag(FileItem::EXECUTABLE, item.label.endsWith(QStringLiteral(".desktop")));
+
+    item.setFlag(FileItem::PARTIAL, m_lazy);
+
+    if (isDir) {
+        item.mime = internString(QStringLiteral("inode/directory"));
+        item.icon = internString(m_lazy ? QStringLiteral("folder") : getIconName(url));
+        item.count = m_lazy ? 0 : countEntries(dirfd, name.constData());
+    } else {
+        // the name is enough for most files, only look into the content when it is ambiguous
+        const auto types = m_mimeDatabase->mimeTypesForFileName(item.label);
+        if (types.size() == 1) {
+            item.mime = internString(types.first().name());
+            item.icon = internString(types.first().iconName());
+        } else if (!m_lazy) {
+            const auto type = MimeCache::lookup(filePath, key);
+            item.mime = internString(type.name);
+            item.icon = internString(type.icon);
+        } else { // the best guess until the item gets resolved
+            const auto type = types.isEmpty() ? m_mimeDatabase->mimeTypeForName(QStringLiteral("application/octet-stream")) : types.first();
+            item.mime = internString(type.name());
+            item.icon = internString(type.iconName());
+        }
+    }
+
+    item.thumbnail = thumbnailUrl(url, item.mime).toString();
+#else
+    Q_UNUSED(dirfd)
+    Q_UNUSED(dirPath)
+    Q_UNUSED(name)
+    Q_UNUSED(isLink)
+#endif
+    return item;
+}
+
+QString DirEnumerator::userName(const uint &uid)
+{
+#if defined Q_OS_LINUX
+    const auto it = m_users.constFind(uid);
+    if (it != m_users.constEnd()) {
+        return it.value();
+    }
+
+    QString res;
+    struct passwd pwd;
+    struct passwd *result = nullptr;
+    char buffer[1024];
+    if (getpwuid_r(uid, &pwd, buffer, sizeof(buffer), &result) == 0 && result) {
+        res = QFile::decodeName(pwd.pw_name);
+    }
+
+    m_users.insert(uid, res);
+    return res;
+#else
+    Q_UNUSED(uid)
+    return QString();
+#endif
+}
+
+QString DirEnumerator::groupName(const uint &gid)
+{
+#if defined Q_OS_LINUX
+    const auto it = m_groups.constFind(gid);
+    if (it != m_groups.constEnd()) {
+        return it.value();
+    }
+
+    QString res;
+    struct group grp;
+    struct group *result = nullptr;
+    char buffer[4096];
+    if (getgrgid_r(gid, &grp, buffer, sizeof(buffer), &result) == 0 && result) {
+        res = QFile::decodeName(grp.gr_name);
+    }
+
+    m_groups.insert(gid, res);
+    return res;
+#else
+    Q_UNUSED(gid)
+    return QString();
+#endif
+}
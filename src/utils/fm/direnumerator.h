@@ -0,0 +1,123 @@
+#ifndef DIRENUMERATOR_H
+#define DIRENUMERATOR_H
+
+#include <QDir>
+#include <QHash>
+#include <QRegExp>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <functional>
+
+#include "fmh.h"
+#include "mauikit_export.h"
+
+class QMimeDatabase;
+
+namespace FMH
+{
+/**
+ * @brief The DirEnumerator class
+ * Lists local directories straight from the kernel on Linux: the entries are read in large getdents64 buffers and
+ * the information of each one is filled with a single statx call, relative to the already open directory.
+ * The entries are packed into FileItems as they are read, so there is no need to stat them again afterwards.
+ * On other systems isSupported() returns false and the caller should fall back to QDirIterator.
+ */
+class MAUIKIT_EXPORT DirEnumerator
+{
+public:
+    enum STATUS : uint8_t {
+        FAILED, // the directory could not be opened
+        DONE,
+        STOPPED // the callback asked to stop
+    };
+
+    /**
+     * @brief DirEnumerator
+     * @param nameFilters
+     * Wildcard filters matched against the file names, the same as for QDirIterator
+     * @param filters
+     * Supported flags are Files, Dirs, AllDirs and Hidden
+     * @param recursive
+     * If the subdirectories should also be listed
+     */
+    DirEnumerator(const QStringList &nameFilters = {}, const QDir::Filters &filters = QDir::Files, const bool &recursive = false);
+    ~DirEnumerator();
+
+    /**
+     * @brief isSupported
+     * @return
+     * If the native enumeration is available in this system
+     */
+    static bool isSupported();
+
+    /**
+     * @brief enumerate
+     * Lists the given local directory
+     * @param path
+     * Local path of the directory
+     * @param callback
+     * Called for every accepted entry, returning false stops the enumeration
+     * @return
+     * False if the directory could not be opened
+     */
+    bool enumerate(const QString &path, const std::function<bool(const FileItem &item)> &callback);
+
+    /**
+     * @brief enumerateDir
+     * Lists a single directory
+     * @param path
+     * Local path of the directory
+     * @param callback
+     * Called for every accepted entry, returning false stops the enumeration
+     * @param subdirs
+     * If given, the subdirectories found are appended to it so the caller can decide how to walk them
+     * @return
+     */
+    STATUS enumerateDir(const QString &path, const std::function<bool(const FileItem &item)> &callback, QStringList *subdirs = nullptr);
+
+    /**
+     * @brief setMatcher
+     * Extra check on the entry names, run before any information of the entry is read
+     * @param matcher
+     */
+    void setMatcher(const std::function<bool(const QString &name)> &matcher);
+
+    /**
+     * @brief setLazy
+     * In lazy mode the entries only get what a single stat and the file name can tell: the symbolic link targets,
+     * the folder icons and item counts are skipped and the mime type is guessed from the name. Such items are marked
+     * as FileItem::PARTIAL and can be completed later with fileItem()
+     * @param lazy
+     */
+    void setLazy(const bool &lazy);
+
+    /**
+     * @brief fileItem
+     * Reads a single local file the same way the listed entries are read, so it should not be lazy to complete them
+     * @param path
+     * Local path of the file
+     * @return
+     */
+    FileItem fileItem(const QString &path);
+
+private:
+    QVector<QRegExp> m_nameFilters;
+    QDir::Filters m_filters;
+    bool m_recursive;
+    bool m_lazy = false;
+    std::function<bool(const QString &name)> m_matcher = nullptr;
+
+    QMimeDatabase *m_mimeDatabase;
+    QHash<uint, QString> m_users;
+    QHash<uint, QString> m_groups;
+
+    bool matchesName(const QString &name) const;
+    FileItem fileItem(const int &dirfd, const QString &dirPath, const QByteArray &name, const bool &isLink);
+    QString userName(const uint &uid);
+    QString groupName(const uint &gid);
+};
+}
+
+#endif // DIRENUMERATOR_H
@@ -0,0 +1,162 @@
+#include "dirsnapshot.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <atomic>
+
+using namespace FMH;
+
+static const quint32 MAGIC = 0x4d534e50; // "MSNP"
+static const quint32 VERSION = 1;
+static const qint64 MIN_ITEM_BYTES = 74; // an item with empty strings and no extra keys
+
+static QMutex mutex; // serializes the writes and the eviction
+static std::atomic<qint64> maxSize {64 * 1024 * 1024};
+
+static QString cacheDir()
+{
+    static const QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/dirsnapshots/");
+    return dir;
+}
+
+static qint64 dirModified(const QString &path)
+{
+    const QFileInfo info(path);
+    return info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+}
+
+QString DirSnapshot::filePath(const QUrl &url, const QString &options)
+{
+    const auto key = QCryptographicHash::hash((url.toString() + QLatin1Char('\n') + options).toUtf8(), QCryptographicHash::Sha1);
+    return cacheDir() + QString::fromLatin1(key.toHex()) + QStringLiteral(".snap");
+}
+
+bool DirSnapshot::load(const QUrl &url, const QString &options, FILE_LIST &items, bool *fresh)
+{
+    if (!url.isLocalFile()) {
+        return false;
+    }
+
+    QFile file(DirSnapshot::filePath(url, options));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const auto size = file.size();
+    uchar *data = file.map(0, size);
+    if (!data) {
+        return false;
+    }
+
+    const auto raw = QByteArray::fromRawData(reinterpret_cast<const char *>(data), static_cast<int>(size));
+    QDataStream in(raw);
+    in.setVersion(QDataStream::Qt_5_10);
+
+    quint32 magic = 0, version = 0;
+    qint64 modified = 0;
+    qint32 count = 0;
+    in >> magic >> version >> modified >> count;
+
+    bool res = false;
+    if (magic == MAGIC && version == VERSION && count >= 0) {
+        FILE_LIST snapshot;
+
+        // the count is not trusted further than what the file can hold
+        snapshot.reserve(static_cast<int>(qMin<qint64>(count, size / MIN_ITEM_BYTES)));
+        for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+            FileItem item;
+            in >> item;
+            snapshot << item;
+        }
+
+        if (in.status() == QDataStream::Ok) {
+            items = snapshot;
+            res = true;
+
+            if (fresh) {
+                *fresh = modified == dirModified(url.toLocalFile());
+            }
+        }
+    }
+
+    file.unmap(data);
+
+    if (res) {
+        // the modification time of the snapshot is what the eviction goes by
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    } else {
+        file.remove();
+    }
+
+    return res;
+}
+
+void DirSnapshot::store(const QUrl &url, const QString &options, const FILE_LIST &items)
+{
+    if (!url.isLocalFile()) {
+        return;
+    }
+
+    const auto modified = dirModified(url.toLocalFile());
+    if (modified < 0) {
+        return;
+    }
+
+    QByteArray data;
+    {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_5_10);
+        out << MAGIC << VERSION << modified << static_cast<qint32>(items.size());
+
+        for (const auto &item : items) {
+            out << item;
+        }
+    }
+
+    QMutexLocker locker(&mutex);
+    QDir().mkpath(cacheDir());
+
+    // written aside and then renamed, so a reader never maps a half written snapshot
+    QSaveFile file(DirSnapshot::filePath(url, options));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    file.write(data);
+    if (file.commit()) {
+        DirSnapshot::evict();
+    }
+}
+
+void DirSnapshot::remove(const QUrl &url, const QString &options)
+{
+    QMutexLocker locker(&mutex);
+    QFile::remove(DirSnapshot::filePath(url, options));
+}
+
+void DirSnapshot::setMaxSize(const qint64 &bytes)
+{
+    maxSize = bytes;
+}
+
+void DirSnapshot::evict()
+{
+    // most recently used first
+    const auto snapshots = QDir(cacheDir()).entryInfoList({QStringLiteral("*.snap")}, QDir::Files, QDir::Time);
+
+    qint64 total = 0;
+    for (const auto &snapshot : snapshots) {
+        total += snapshot.size();
+        if (total > maxSize) {
+            QFile::remove(snapshot.absoluteFilePath());
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef DIRSNAPSHOT_H
+#define DIRSNAPSHOT_H
+
+#include <QString>
+#include <QUrl>
+
+#include "fmh.h"
+#include "mauikit_export.h"
+
+namespace FMH
+{
+/**
+ * @brief The DirSnapshot class
+ * On-disk store of the most recent directory listings, so a folder can be shown right away when it is opened again
+ * while the real listing revalidates it.
+ * Each snapshot is a file in the cache location holding the packed items and the modification time of the
+ * directory. Snapshots are read through a memory map. The store has a size cap, and the least recently used
+ * snapshots are evicted first. All the methods are thread safe.
+ */
+class MAUIKIT_EXPORT DirSnapshot
+{
+public:
+    /**
+     * @brief load
+     * @param url
+     * Local directory
+     * @param options
+     * Anything that changes the listing, like the filters, so each combination gets its own snapshot
+     * @param items
+     * Filled with the stored items
+     * @param fresh
+     * If given, set to whether the directory has not been modified since the snapshot was taken
+     * @return
+     * False if there is no usable snapshot
+     */
+    static bool load(const QUrl &url, const QString &options, FILE_LIST &items, bool *fresh = nullptr);
+
+    /**
+     * @brief store
+     * Takes a snapshot of a listing, replacing the previous one and evicting the oldest ones over the cap
+     * @param url
+     * @param options
+     * @param items
+     */
+    static void store(const QUrl &url, const QString &options, const FILE_LIST &items);
+
+    /**
+     * @brief remove
+     * @param url
+     * @param options
+     */
+    static void remove(const QUrl &url, const QString &options);
+
+    /**
+     * @brief setMaxSize
+     * Size cap of the whole store, 64 MiB by default
+     * @param bytes
+     */
+    static void setMaxSize(const qint64 &bytes);
+
+private:
+    static QString filePath(const QUrl &url, const QString &options);
+    static void evict();
+};
+}
+
+#endif // DIRSNAPSHOT_H
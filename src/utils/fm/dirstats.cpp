@@ -0,0 +1,176 @@
+#include "dirstats.h"
+#include "fileindex.h"
+
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+using namespace FMH;
+
+static const int MAX_THREADS = 4;
+static const int MAX_CACHE = 100000; // directories, the cache is dropped whole past it
+
+// inode and modification time of a directory, false if it is not one
+static bool identity(const QString &path, quint64 *inode, qint64 *modified)
+{
+#ifdef Q_OS_UNIX
+    struct stat info;
+    if (::stat(QFile::encodeName(path).constData(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+        return false;
+    }
+
+    *inode = static_cast<quint64>(info.st_ino);
+#if defined Q_OS_MACOS || defined Q_OS_IOS
+    *modified = static_cast<qint64>(info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+    *modified = static_cast<qint64>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+    return true;
+#else
+    const QFileInfo info(path);
+    if (!info.isDir()) {
+        return false;
+    }
+
+    *inode = 0;
+    *modified = info.lastModified().toMSecsSinceEpoch() * 1000000;
+    return true;
+#endif
+}
+
+DirStats *DirStats::instance()
+{
+    static DirStats *stats = []() -> DirStats * {
+        const auto app = QCoreApplication::instance();
+        if (!app) {
+            return nullptr;
+        }
+
+        auto res = new DirStats;
+        res->moveToThread(app->thread());
+        return res;
+    }();
+
+    return stats;
+}
+
+DirStats::DirStats(QObject *parent)
+    : QObject(parent)
+    , m_pool(new QThreadPool(this))
+{
+    this->m_pool->setMaxThreadCount(MAX_THREADS);
+
+    if (const auto index = FileIndex::instance()) {
+        connect(index, &FileIndex::entryChanged, this, &DirStats::invalidate);
+    }
+}
+
+void DirStats::request(const QString &path)
+{
+    if (this->m_pending.contains(path)) {
+        return;
+    }
+
+    this->m_pending.insert(path);
+
+    // the cached totals of a parent are only dropped by the changes the index reports
+    if (const auto index = FileIndex::instance()) {
+        index->activate();
+    }
+
+    // the service is never destroyed, so it can be reached from the work
+    QtConcurrent::run(this->m_pool, [this, path]() {
+        const auto totals = this->compute(path);
+
+        QMetaObject::invokeMethod(this, [this, path, totals]() {
+            this->m_pending.remove(path);
+            emit this->ready(path, totals.count, totals.size, totals.files);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void DirStats::invalidate(const QString &path)
+{
+    QStringList dropped;
+
+    {
+        QMutexLocker locker(&this->m_mutex);
+        auto dir = path;
+        forever {
+            if (this->m_cache.remove(dir)) {
+                dropped << dir;
+            }
+
+            const auto parent = QFileInfo(dir).path();
+            if (parent == dir || parent.isEmpty()) {
+                break;
+            }
+            dir = parent;
+        }
+    }
+
+    for (const auto &dir : qAsConst(dropped)) {
+        emit this->changed(dir);
+    }
+}
+
+DirStats::Totals DirStats::compute(const QString &path)
+{
+    Totals res;
+    if (!identity(path, &res.inode, &res.modified)) {
+        return res;
+    }
+
+    {
+        QMutexLocker locker(&this->m_mutex);
+        const auto cached = this->m_cache.constFind(path);
+        if (cached != this->m_cache.constEnd() && cached->inode == res.inode && cached->modified == res.modified) {
+            return cached.value();
+        }
+    }
+
+    QDirIterator it(path, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System);
+    while (it.hasNext()) {
+        it.next();
+        const auto info = it.fileInfo();
+
+        if (!info.fileName().startsWith(QLatin1Char('.'))) {
+            res.count++;
+        }
+
+        // the links are not followed, what they point to is counted where it lives
+        if (info.isSymLink()) {
+            continue;
+        }
+
+        if (info.isDir()) {
+            const auto sub = this->compute(info.filePath());
+            res.size += sub.size;
+            res.files += sub.files;
+        } else {
+            res.size += info.size();
+            res.files++;
+        }
+    }
+
+    // the totals are only kept where the index reports the changes deep down the tree, a directory only tells about
+    // its direct entries
+    const auto index = FileIndex::instance();
+    if (!index || !index->covers(path)) {
+        return res;
+    }
+
+    QMutexLocker locker(&this->m_mutex);
+    if (this->m_cache.size() >= MAX_CACHE) {
+        this->m_cache.clear();
+    }
+    this->m_cache.insert(path, res);
+
+    return res;
+}
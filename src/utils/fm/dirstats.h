@@ -0,0 +1,94 @@
+#ifndef DIRSTATS_H
+#define DIRSTATS_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+#include "mauikit_export.h"
+
+class QThreadPool;
+
+namespace FMH
+{
+/**
+ * @brief The DirStats class
+ * Computes the number of visible children of a directory and the total size and number of files under it, on a pool
+ * of worker threads. The totals of the directories covered by the FileIndex are cached along with their inode and
+ * modification time, so walking a parent again only goes into the subdirectories that changed. The changes reported by
+ * the FileIndex, and the ones given to invalidate, drop the cached totals of the changed directory and of all its parents.
+ * Elsewhere nothing would report a change deep down the tree, so the totals are walked every time.
+ */
+class MAUIKIT_EXPORT DirStats : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief instance
+     * The service lives in the application thread
+     * @return
+     * Null when there is no application
+     */
+    static DirStats *instance();
+
+    /**
+     * @brief request
+     * Queues a directory to be measured, the result comes with the ready signal. A request for a directory being
+     * measured already is ignored
+     * @param path
+     * Local path of the directory
+     */
+    void request(const QString &path);
+
+    /**
+     * @brief invalidate
+     * Drops the cached totals of the directory holding the entry and of its parents
+     * @param path
+     * Local path of the entry that changed
+     */
+    void invalidate(const QString &path);
+
+signals:
+    /**
+     * @brief ready
+     * @param path
+     * @param count
+     * Number of visible children
+     * @param size
+     * Total size in bytes of the files under the directory, hidden ones included
+     * @param files
+     * Number of files under the directory
+     */
+    void ready(QString path, int count, qint64 size, qint64 files);
+
+    /**
+     * @brief changed
+     * The cached totals of the directory were dropped, they need to be requested again
+     * @param path
+     */
+    void changed(QString path);
+
+private:
+    DirStats(QObject *parent = nullptr);
+
+    struct Totals {
+        quint64 inode = 0;
+        qint64 modified = 0; // ns
+        int count = 0;
+        qint64 size = 0;
+        qint64 files = 0;
+    };
+
+    QThreadPool *m_pool;
+    QSet<QString> m_pending;
+
+    mutable QMutex m_mutex;
+    QHash<QString, Totals> m_cache;
+
+    Totals compute(const QString &path);
+};
+}
+
+#endif // DIRSTATS_H
@@ -0,0 +1,275 @@
+#include "dirwalker.h"
+#include "direnumerator.h"
+
+#include <QDirIterator>
+#include <QMutex>
+#include <QThread>
+#include <QThreadPool>
+#include <QUrl>
+#include <QWaitCondition>
+#include <QtConcurrent>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+using namespace FMH;
+
+static const unsigned long IDLE_WAIT = 50; // ms, an idle worker still notices a cancellation from outside
+
+/**
+ * Pending subdirectories of a worker. The owner takes the most recent ones, which are likely still cached,
+ * while the other workers steal the oldest ones, which tend to hold the biggest subtrees.
+ */
+struct WorkQueue {
+    QMutex mutex;
+    std::deque<QString> dirs;
+};
+
+DirWalker::DirWalker(const QStringList &nameFilters, const QDir::Filters &filters)
+    : m_nameFilters(nameFilters)
+    , m_filters(filters)
+    , m_threadCount(qBound(1, QThread::idealThreadCount(), 8))
+{
+}
+
+void DirWalker::setMatcher(const std::function<bool(const QString &name)> &matcher)
+{
+    m_matcher = matcher;
+}
+
+void DirWalker::setLimit(const uint &limit)
+{
+    m_limit = limit;
+}
+
+void DirWalker::setBatchCount(const uint &count)
+{
+    m_batchCount = qMax(1u, count);
+}
+
+void DirWalker::setThreadCount(const int &count)
+{
+    m_threadCount = qMax(1, count);
+}
+
+void DirWalker::setCancelToken(const CancelToken &token)
+{
+    m_token = token;
+}
+
+void DirWalker::cancel()
+{
+    m_cancelled = true;
+}
+
+bool DirWalker::stopped() const
+{
+    return m_cancelled || m_token.isCancelled();
+}
+
+uint DirWalker::walk(const QStringList &paths, const std::function<void(const FILE_LIST &batch)> &onBatch)
+{
+    m_cancelled = false;
+
+    const int workers = m_threadCount;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    for (int i = 0; i < workers; i++) {
+        queues.emplace_back(new WorkQueue);
+    }
+
+    std::atomic<int> pending {0}; // directories queued or being listed
+    std::atomic<uint> found {0};
+
+    for (int i = 0; i < paths.size(); i++) {
+        queues[i % workers]->dirs.push_back(paths.at(i));
+        pending++;
+    }
+
+    QMutex idleMutex;
+    QWaitCondition workReady; // more subdirectories were queued, or all of them are done
+
+    QMutex resultsMutex;
+    QWaitCondition resultsReady;
+    QVector<FILE_LIST> results;
+    int running = workers;
+
+    const auto take = [&](const int &worker, QString &dir) -> bool {
+        {
+            auto &own = *queues[worker];
+            QMutexLocker locker(&own.mutex);
+            if (!own.dirs.empty()) {
+                dir = own.dirs.back();
+                own.dirs.pop_back();
+                return true;
+            }
+        }
+
+        for (int i = 1; i < workers; i++) {
+            auto &other = *queues[(worker + i) % workers];
+            QMutexLocker locker(&other.mutex);
+            if (!other.dirs.empty()) {
+                dir = other.dirs.front();
+                other.dirs.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    };
+
+    const auto deliver = [&](FILE_LIST &buffer) {
+        if (buffer.isEmpty()) {
+            return;
+        }
+
+        QMutexLocker locker(&resultsMutex);
+        results << buffer;
+        buffer.clear();
+        resultsReady.wakeOne();
+    };
+
+    const auto work = [&](const int &worker) {
+        DirEnumerator enumerator(m_nameFilters, m_filters);
+        enumerator.setMatcher(m_matcher);
+
+        FILE_LIST buffer;
+        QStringList subdirs;
+        QString dir;
+
+        const auto collect = [&](const FileItem &item) -> bool {
+            if (m_limit > 0) {
+                const auto count = found.fetch_add(1);
+                if (count >= m_limit) {
+                    m_cancelled = true;
+                    return false;
+                }
+
+                if (count + 1 == m_limit) {
+                    m_cancelled = true;
+                }
+            } else {
+                found++;
+            }
+
+            buffer << item;
+            if (static_cast<uint>(buffer.size()) >= m_batchCount) {
+                deliver(buffer);
+            }
+
+            return !this->stopped();
+        };
+
+        while (!this->stopped()) {
+            if (!take(worker, dir)) {
+                // some other worker is still listing and may find more subdirectories. Checked again under the lock
+                // the others wake us with, so a push made in between is not missed
+                QMutexLocker locker(&idleMutex);
+                if (!take(worker, dir)) {
+                    if (pending == 0) {
+                        break;
+                    }
+
+                    workReady.wait(&idleMutex, IDLE_WAIT);
+                    continue;
+                }
+            }
+
+            subdirs.clear();
+
+            if (DirEnumerator::isSupported()) {
+                enumerator.enumerateDir(dir, collect, &subdirs);
+            } else {
+                QDirIterator subdirsIt(dir, QDir::Dirs | QDir::NoDotAndDotDot | (m_filters & QDir::Hidden));
+                while (subdirsIt.hasNext() && !this->stopped()) {
+                    const auto path = subdirsIt.next();
+                    if (!subdirsIt.fileInfo().isSymLink()) {
+                        subdirs << path;
+                    }
+                }
+
+                QDirIterator it(dir, m_nameFilters, m_filters);
+                while (it.hasNext() && !this->stopped()) {
+                    const auto path = it.next();
+                    if (m_matcher && !m_matcher(it.fileName())) {
+                        continue;
+                    }
+
+                    const auto item = FMH::getFileItem(QUrl::fromLocalFile(path));
+                    if (!item.isEmpty() && !collect(item)) {
+                        break;
+                    }
+                }
+            }
+
+            if (!subdirs.isEmpty()) {
+                auto &own = *queues[worker];
+                QMutexLocker locker(&own.mutex);
+                for (const auto &subdir : qAsConst(subdirs)) {
+                    own.dirs.push_back(subdir);
+                }
+                pending += subdirs.size();
+                locker.unlock();
+
+                QMutexLocker idleLocker(&idleMutex);
+                workReady.wakeAll();
+            }
+
+            if (--pending == 0) {
+                QMutexLocker locker(&idleMutex);
+                workReady.wakeAll();
+            }
+        }
+
+        // the others stop as well, no need for them to wait until the next check
+        if (this->stopped()) {
+            QMutexLocker locker(&idleMutex);
+            workReady.wakeAll();
+        }
+
+        deliver(buffer);
+
+        QMutexLocker locker(&resultsMutex);
+        running--;
+        resultsReady.wakeAll();
+    };
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    for (int i = 0; i < workers; i++) {
+        QtConcurrent::run(&pool, [&work, i]() {
+            work(i);
+        });
+    }
+
+    // hand the batches back from the calling thread while the workers go on
+    forever {
+        QVector<FILE_LIST> ready;
+        {
+            QMutexLocker locker(&resultsMutex);
+            while (results.isEmpty() && running > 0) {
+                resultsReady.wait(&resultsMutex);
+            }
+
+            if (results.isEmpty() && running == 0) {
+                break;
+            }
+
+            ready.swap(results);
+        }
+
+        // the results of a superseded request are of no use to anyone
+        if (m_token.isCancelled()) {
+            continue;
+        }
+
+        for (const auto &batch : qAsConst(ready)) {
+            onBatch(batch);
+        }
+    }
+
+    pool.waitForDone();
+
+    const uint count = found;
+    return m_limit > 0 ? qMin(count, m_limit) : count;
+}
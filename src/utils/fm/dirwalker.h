@@ -0,0 +1,102 @@
+#ifndef DIRWALKER_H
+#define DIRWALKER_H
+
+#include <QDir>
+#include <QStringList>
+
+#include <atomic>
+#include <functional>
+
+#include "fmh.h"
+#include "mauikit_export.h"
+
+namespace FMH
+{
+/**
+ * @brief The DirWalker class
+ * Walks directory trees in parallel. Every worker of a bounded thread pool keeps its own queue of pending
+ * subdirectories and, once it runs out of them, steals work from the other queues, so deep and wide trees keep all
+ * the workers busy. Each worker fills its own buffer of results, which are handed back in batches to the thread
+ * that called walk(), so the results can be safely emitted from there.
+ */
+class MAUIKIT_EXPORT DirWalker
+{
+public:
+    /**
+     * @brief DirWalker
+     * @param nameFilters
+     * Wildcard filters matched against the file names
+     * @param filters
+     * Supported flags are Files, Dirs, AllDirs and Hidden
+     */
+    DirWalker(const QStringList &nameFilters = {}, const QDir::Filters &filters = QDir::Files);
+
+    /**
+     * @brief setMatcher
+     * Extra check on the entry names, run before any information of the entry is read
+     * @param matcher
+     */
+    void setMatcher(const std::function<bool(const QString &name)> &matcher);
+
+    /**
+     * @brief setLimit
+     * Maximum number of entries to collect
+     * @param limit
+     */
+    void setLimit(const uint &limit);
+
+    /**
+     * @brief setBatchCount
+     * Number of entries a worker collects before handing them back
+     * @param count
+     */
+    void setBatchCount(const uint &count);
+
+    /**
+     * @brief setThreadCount
+     * By default it is the ideal thread count, up to 8
+     * @param count
+     */
+    void setThreadCount(const int &count);
+
+    /**
+     * @brief setCancelToken
+     * Token of the request the walk belongs to, the workers stop as soon as it is cancelled
+     * @param token
+     */
+    void setCancelToken(const CancelToken &token);
+
+    /**
+     * @brief walk
+     * Walks the given local directories and all their subdirectories. It blocks until the walk is done
+     * @param paths
+     * @param onBatch
+     * Called from the calling thread with each batch of results
+     * @return
+     * Number of entries found
+     */
+    uint walk(const QStringList &paths, const std::function<void(const FILE_LIST &batch)> &onBatch);
+
+    /**
+     * @brief cancel
+     * Stops an ongoing walk, it can be called from any thread
+     */
+    void cancel();
+
+private:
+    QStringList m_nameFilters;
+    QDir::Filters m_filters;
+    std::function<bool(const QString &name)> m_matcher = nullptr;
+
+    uint m_limit = 0;
+    uint m_batchCount = 500;
+    int m_threadCount;
+
+    CancelToken m_token;
+    std::atomic<bool> m_cancelled {false};
+
+    bool stopped() const;
+};
+}
+
+#endif // DIRWALKER_H
@@ -0,0 +1,219 @@
+#include "dirwatcher.h"
+
+#include <QTimer>
+#include <QDebug>
+
+#if defined Q_OS_LINUX
+#include <QSocketNotifier>
+#include <QFile>
+
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#else
+#include <QFileSystemWatcher>
+#include <QFileInfo>
+#endif
+
+using namespace FMH;
+
+static const int COALESCE_INTERVAL = 150; // ms
+
+DirWatcher::DirWatcher(QObject *parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+#if !defined Q_OS_LINUX
+    , m_watcher(new QFileSystemWatcher(this))
+#endif
+{
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(COALESCE_INTERVAL);
+    connect(m_timer, &QTimer::timeout, this, &DirWatcher::flush);
+
+#if !defined Q_OS_LINUX
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &DirWatcher::rescanNeeded);
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, [this](const QString &path) {
+        this->queue(QFileInfo(path).fileName(), CHANGE::MODIFIED);
+    });
+#endif
+}
+
+DirWatcher::~DirWatcher()
+{
+    this->stop();
+}
+
+bool DirWatcher::watch(const QString &path)
+{
+    this->stop();
+    m_path = path;
+
+#if defined Q_OS_LINUX
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        qWarning() << "Could not initialize inotify" << strerror(errno);
+        return false;
+    }
+
+    const uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+    m_wd = inotify_add_watch(m_fd, QFile::encodeName(path).constData(), mask);
+    if (m_wd < 0) {
+        qWarning() << "Could not watch directory" << path << strerror(errno);
+        this->stop();
+        return false;
+    }
+
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &DirWatcher::readEvents);
+    return true;
+#else
+    return m_watcher->addPath(path);
+#endif
+}
+
+void DirWatcher::stop()
+{
+    m_timer->stop();
+    m_pending.clear();
+
+#if defined Q_OS_LINUX
+    if (m_notifier) {
+        m_notifier->setEnabled(false);
+        m_notifier->deleteLater();
+        m_notifier = nullptr;
+    }
+
+    if (m_fd >= 0) {
+        // closing the descriptor also drops the watch
+        ::close(m_fd);
+        m_fd = -1;
+        m_wd = -1;
+    }
+#else
+    const auto paths = QStringList() << m_watcher->directories() << m_watcher->files();
+    if (!paths.isEmpty()) {
+        m_watcher->removePaths(paths);
+    }
+#endif
+}
+
+void DirWatcher::addFile(const QString &path)
+{
+#if defined Q_OS_LINUX
+    Q_UNUSED(path)
+#else
+    m_watcher->addPath(path);
+#endif
+}
+
+void DirWatcher::removeFile(const QString &path)
+{
+#if defined Q_OS_LINUX
+    Q_UNUSED(path)
+#else
+    m_watcher->removePath(path);
+#endif
+}
+
+QString DirWatcher::path() const
+{
+    return m_path;
+}
+
+#if defined Q_OS_LINUX
+void DirWatcher::readEvents()
+{
+    alignas(struct inotify_event) char buffer[4096];
+    bool rescan = false;
+
+    forever {
+        const auto length = ::read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break; // EAGAIN, the queue has been drained
+        }
+
+        for (char *ptr = buffer; ptr < buffer + length;) {
+            const auto event = reinterpret_cast<const struct inotify_event *>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & (IN_Q_OVERFLOW | IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                rescan = true;
+                continue;
+            }
+
+            if (event->len == 0) {
+                continue;
+            }
+
+            const auto name = QFile::decodeName(event->name);
+
+            if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                this->queue(name, CHANGE::ADDED);
+            } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                this->queue(name, CHANGE::REMOVED);
+            } else if (event->mask & (IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE)) {
+                this->queue(name, CHANGE::MODIFIED);
+            }
+        }
+    }
+
+    if (rescan) {
+        m_timer->stop();
+        m_pending.clear();
+        emit this->rescanNeeded();
+    }
+}
+#endif
+
+void DirWatcher::queue(const QString &name, const CHANGE &change)
+{
+    const auto it = m_pending.find(name);
+
+    if (it == m_pending.end()) {
+        m_pending.insert(name, change);
+    } else {
+        switch (change) {
+        case CHANGE::ADDED: // removed and created again means it was replaced
+            it.value() = it.value() == CHANGE::REMOVED ? CHANGE::MODIFIED : CHANGE::ADDED;
+            break;
+        case CHANGE::REMOVED: // an entry created and removed within the same burst was never seen
+            if (it.value() == CHANGE::ADDED) {
+                m_pending.erase(it);
+            } else {
+                it.value() = CHANGE::REMOVED;
+            }
+            break;
+        case CHANGE::MODIFIED: // an added entry is read once it is flushed anyway
+            break;
+        }
+    }
+
+    if (!m_timer->isActive()) {
+        m_timer->start();
+    }
+}
+
+void DirWatcher::flush()
+{
+    QStringList added, removed, modified;
+    for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it) {
+        switch (it.value()) {
+        case CHANGE::ADDED:
+            added << it.key();
+            break;
+        case CHANGE::REMOVED:
+            removed << it.key();
+            break;
+        case CHANGE::MODIFIED:
+            modified << it.key();
+            break;
+        }
+    }
+
+    m_pending.clear();
+
+    if (!added.isEmpty() || !removed.isEmpty() || !modified.isEmpty()) {
+        emit this->changed(added, removed, modified);
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef DIRWATCHER_H
+#define DIRWATCHER_H
+
+#include <QObject>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+#include "mauikit_export.h"
+
+class QTimer;
+
+#if defined Q_OS_LINUX
+class QSocketNotifier;
+#else
+class QFileSystemWatcher;
+#endif
+
+namespace FMH
+{
+/**
+ * @brief The DirWatcher class
+ * Watches the entries of a single directory and reports what changed in it.
+ * On Linux it uses one inotify watch for the directory, so the number of watches does not grow with the number of files.
+ * Bursts of events are coalesced and delivered together, already reduced to their final effect.
+ * On other systems it falls back to QFileSystemWatcher, which can only tell that the directory changed.
+ */
+class MAUIKIT_EXPORT DirWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DirWatcher(QObject *parent = nullptr);
+    ~DirWatcher();
+
+    /**
+     * @brief watch
+     * Starts watching the given local directory, any previous watch is dropped
+     * @param path
+     * Local path of the directory
+     * @return
+     * If the watch could be set
+     */
+    bool watch(const QString &path);
+
+    /**
+     * @brief stop
+     * Stops watching and drops any pending change
+     */
+    void stop();
+
+    /**
+     * @brief addFile
+     * Files are covered by the directory watch when the backend supports it, otherwise the file is watched on its own
+     * @param path
+     */
+    void addFile(const QString &path);
+
+    /**
+     * @brief removeFile
+     * @param path
+     */
+    void removeFile(const QString &path);
+
+    /**
+     * @brief path
+     * @return
+     */
+    QString path() const;
+
+signals:
+    /**
+     * @brief changed
+     * Coalesced changes of the directory entries, given as file names
+     * @param added
+     * @param removed
+     * @param modified
+     */
+    void changed(QStringList added, QStringList removed, QStringList modified);
+
+    /**
+     * @brief rescanNeeded
+     * The changes could not be tracked, for example the event queue overflowed, so the directory needs to be listed again
+     */
+    void rescanNeeded();
+
+private:
+    enum CHANGE : uint8_t { ADDED, REMOVED, MODIFIED };
+
+    QString m_path;
+    QHash<QString, CHANGE> m_pending;
+    QTimer *m_timer;
+
+#if defined Q_OS_LINUX
+    int m_fd = -1;
+    int m_wd = -1;
+    QSocketNotifier *m_notifier = nullptr;
+
+    void readEvents();
+#else
+    QFileSystemWatcher *m_watcher;
+#endif
+
+    void queue(const QString &name, const CHANGE &change);
+    void flush();
+};
+}
+
+#endif // DIRWATCHER_H
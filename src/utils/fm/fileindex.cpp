@@ -0,0 +1,740 @@
+#include "fileindex.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#if defined Q_OS_LINUX
+#include <QSocketNotifier>
+
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+using namespace FMH;
+
+static const quint32 NO_PARENT = std::numeric_limits<quint32>::max();
+static const int MAX_ENTRIES = 4000000;
+static const int SAVE_INTERVAL = 30 * 1000; // ms
+
+static const quint32 MAGIC = 0x4d464958; // "MFIX"
+static const quint32 VERSION = 1;
+static const qint64 MIN_ENTRY_BYTES = 9; // parent, flags and an empty name
+static const qint64 MIN_POSTING_BYTES = 12; // trigram and an empty list
+
+#if defined Q_OS_LINUX
+static const uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ONLYDIR;
+#endif
+
+FileIndex *FileIndex::instance()
+{
+    static FileIndex *index = []() -> FileIndex * {
+        const auto app = QCoreApplication::instance();
+        if (!app) {
+            return nullptr;
+        }
+
+        auto res = new FileIndex;
+        res->moveToThread(app->thread());
+        return res;
+    }();
+
+    return index;
+}
+
+FileIndex::FileIndex(QObject *parent)
+    : QObject(parent)
+    , m_saveTimer(new QTimer(this))
+{
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(SAVE_INTERVAL);
+    connect(m_saveTimer, &QTimer::timeout, this, &FileIndex::save);
+}
+
+FileIndex::~FileIndex()
+{
+#if defined Q_OS_LINUX
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+#endif
+}
+
+void FileIndex::activate()
+{
+    if (!m_activated.exchange(true)) {
+        QMetaObject::invokeMethod(this, "start", Qt::QueuedConnection);
+    }
+}
+
+void FileIndex::start()
+{
+#if defined Q_OS_LINUX
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        qWarning() << "Could not initialize inotify, the file index is disabled" << strerror(errno);
+        return;
+    }
+
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &FileIndex::readEvents);
+
+    // the saved index answers right away, but only a scan can tell what changed while nobody was watching
+    m_ready = this->load();
+    m_scanning = true;
+    QtConcurrent::run([this]() {
+        this->scan();
+    });
+#endif
+}
+
+QStringList FileIndex::defaultRoots()
+{
+    QStringList roots;
+    for (const auto &url : FMH::defaultPaths) {
+        const auto path = QUrl(url).toLocalFile();
+        if (!path.isEmpty() && QFileInfo(path).isDir()) {
+            roots << QDir::cleanPath(path);
+        }
+    }
+
+    // the places inside home are already covered by it
+    roots.removeDuplicates();
+    std::sort(roots.begin(), roots.end());
+    QStringList res;
+    for (const auto &root : qAsConst(roots)) {
+        if (res.isEmpty() || !(root == res.last() || root.startsWith(res.last() + QLatin1Char('/')))) {
+            res << root;
+        }
+    }
+
+    return res;
+}
+
+QString FileIndex::filePath()
+{
+    // shared by all the applications, they index the same places
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/mauikit/fileindex");
+}
+
+QVector<quint64> FileIndex::trigrams(const QString &name)
+{
+    QVector<quint64> res;
+    const auto folded = name.toCaseFolded();
+    const auto chars = folded.utf16();
+
+    for (int i = 0; i + 2 < folded.size(); i++) {
+        res << ((static_cast<quint64>(chars[i]) << 32) | (static_cast<quint64>(chars[i + 1]) << 16) | chars[i + 2]);
+    }
+
+    std::sort(res.begin(), res.end());
+    res.erase(std::unique(res.begin(), res.end()), res.end());
+    return res;
+}
+
+quint32 FileIndex::add(Data &data, const quint32 &parent, const QString &name, const bool &isDir)
+{
+    const auto id = static_cast<quint32>(data.entries.size());
+    data.entries << Entry {parent, static_cast<quint8>(isDir ? DIR : 0), name};
+
+    // ids only grow, so the lists stay sorted
+    for (const auto &trigram : trigrams(name)) {
+        data.postings[trigram] << id;
+    }
+
+    return id;
+}
+
+void FileIndex::remove(Data &data, const QString &path)
+{
+    const auto parent = data.dirs.constFind(path.left(path.lastIndexOf(QLatin1Char('/'))));
+    if (parent == data.dirs.constEnd()) {
+        return;
+    }
+
+    const auto name = path.mid(path.lastIndexOf(QLatin1Char('/')) + 1);
+    const auto dir = data.dirs.constFind(path);
+
+    if (dir != data.dirs.constEnd()) {
+        // the children are dropped along with it, see pathOf
+        data.entries[dir.value()].flags |= REMOVED;
+
+        const auto prefix = path + QLatin1Char('/');
+        for (auto it = data.dirs.begin(); it != data.dirs.end();) {
+            it = it.key() == path || it.key().startsWith(prefix) ? data.dirs.erase(it) : std::next(it);
+        }
+        return;
+    }
+
+    // a file, there can be more than one entry for it if it was indexed twice
+    for (auto id = FileIndex::find(data, parent.value(), name); id != NO_PARENT; id = FileIndex::find(data, parent.value(), name)) {
+        data.entries[id].flags |= REMOVED;
+    }
+}
+
+quint32 FileIndex::find(const Data &data, const quint32 &parent, const QString &name)
+{
+    const auto matches = [&](const quint32 &id) -> bool {
+        const auto &entry = data.entries.at(id);
+        return entry.parent == parent && entry.name == name && !(entry.flags & REMOVED);
+    };
+
+    // looked up through the postings of its name, or among all the entries when it is too short to have trigrams
+    const auto grams = trigrams(name);
+    if (grams.isEmpty()) {
+        for (int i = 0; i < data.entries.size(); i++) {
+            if (matches(static_cast<quint32>(i))) {
+                return static_cast<quint32>(i);
+            }
+        }
+        return NO_PARENT;
+    }
+
+    for (const auto &id : data.postings.value(grams.first())) {
+        if (matches(id)) {
+            return id;
+        }
+    }
+
+    return NO_PARENT;
+}
+
+QString FileIndex::pathOf(const Data &data, quint32 id)
+{
+    QStringList parts;
+    while (id != NO_PARENT) {
+        const auto &entry = data.entries.at(id);
+        if (entry.flags & REMOVED) {
+            return QString();
+        }
+
+        parts.prepend(entry.name);
+        id = entry.parent;
+    }
+
+    return parts.join(QLatin1Char('/'));
+}
+
+void FileIndex::walk(Data &data, const QString &root, const std::function<void(const QString &dir)> &onDir)
+{
+    // neither hidden entries nor symbolic links to directories are followed
+    QDirIterator it(root, QDir::AllEntries | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext() && data.entries.size() < MAX_ENTRIES) {
+        const auto path = it.next();
+        const auto info = it.fileInfo();
+
+        const auto parent = data.dirs.constFind(info.path());
+        if (parent == data.dirs.constEnd()) {
+            continue;
+        }
+
+        const bool isDir = info.isDir() && !info.isSymLink();
+        const auto id = FileIndex::add(data, parent.value(), info.fileName(), isDir);
+
+        if (isDir) {
+            data.dirs.insert(path, id);
+            onDir(path);
+        }
+    }
+}
+
+void FileIndex::watch(const QString &path)
+{
+#if defined Q_OS_LINUX
+    const auto wd = inotify_add_watch(m_fd, QFile::encodeName(path).constData(), WATCH_MASK);
+    if (wd < 0) {
+        // most likely out of watches, the index can not be trusted anymore
+        if (!m_unwatched.exchange(true)) {
+            qWarning() << "Could not watch" << path << strerror(errno) << ", the file index is disabled";
+        }
+        m_ready = false;
+        return;
+    }
+
+    QWriteLocker locker(&m_lock);
+    m_watches.insert(wd, path);
+#else
+    Q_UNUSED(path)
+#endif
+}
+
+void FileIndex::scan()
+{
+    Data data;
+    data.roots = FileIndex::defaultRoots();
+    m_unwatched = false;
+
+    for (const auto &root : qAsConst(data.roots)) {
+        data.dirs.insert(root, FileIndex::add(data, NO_PARENT, root, true));
+        this->watch(root);
+
+        FileIndex::walk(data, root, [this](const QString &dir) {
+            this->watch(dir);
+        });
+    }
+
+    const bool complete = data.entries.size() < MAX_ENTRIES;
+    if (!complete) {
+        qWarning() << "Too many files to index, the file index is disabled";
+    }
+
+    // the changes made during the scan were applied to the previous data, they are replayed on the new one. The
+    // directories the walk missed get their trees indexed once it is published
+    QStringList trees;
+    {
+        QWriteLocker locker(&m_lock);
+        for (const auto &change : qAsConst(m_journal)) {
+            const auto path = change.dir + QLatin1Char('/') + change.name;
+            if (change.removed) {
+                FileIndex::remove(data, path);
+                continue;
+            }
+
+            const auto parent = data.dirs.constFind(change.dir);
+            if (parent == data.dirs.constEnd() || FileIndex::find(data, parent.value(), change.name) != NO_PARENT) {
+                continue;
+            }
+
+            const auto id = FileIndex::add(data, parent.value(), change.name, change.isDir);
+            if (change.isDir) {
+                data.dirs.insert(path, id);
+                trees << path;
+            }
+        }
+
+        m_journal.clear();
+        m_data = data;
+        m_scanning = false;
+    }
+
+    m_ready = complete && !m_unwatched;
+
+    for (const auto &tree : qAsConst(trees)) {
+        this->indexTree(tree);
+    }
+
+    QMetaObject::invokeMethod(this, "save", Qt::QueuedConnection);
+}
+
+void FileIndex::indexTree(const QString &path)
+{
+    // walked on its own, with the directory as root, so the searches and events are not held for the whole walk
+    Data tree;
+    tree.dirs.insert(path, FileIndex::add(tree, NO_PARENT, path, true));
+
+    QStringList dirs;
+    FileIndex::walk(tree, path, [&dirs](const QString &dir) {
+        dirs << dir;
+    });
+
+    {
+        QWriteLocker locker(&m_lock);
+        FileIndex::merge(m_data, tree, path);
+    }
+
+    for (const auto &dir : qAsConst(dirs)) {
+        this->watch(dir);
+    }
+}
+
+void FileIndex::merge(Data &data, const Data &tree, const QString &path)
+{
+    const auto dir = data.dirs.constFind(path);
+    if (dir == data.dirs.constEnd() || data.entries.size() + tree.entries.size() > MAX_ENTRIES) {
+        return;
+    }
+
+    // the root of the tree is the directory already indexed, the rest go after the last entry in the same order
+    const auto base = static_cast<quint32>(data.entries.size()) - 1;
+    const auto idOf = [&](const quint32 &id) -> quint32 {
+        return id == 0 ? dir.value() : base + id;
+    };
+
+    data.entries.reserve(data.entries.size() + tree.entries.size() - 1);
+    for (int i = 1; i < tree.entries.size(); i++) {
+        const auto &entry = tree.entries.at(i);
+        data.entries << Entry {idOf(entry.parent), entry.flags, entry.name};
+    }
+
+    // the new ids are larger than any other, so the lists stay sorted. The root has its trigrams already
+    for (auto it = tree.postings.constBegin(); it != tree.postings.constEnd(); ++it) {
+        auto &list = data.postings[it.key()];
+        for (const auto &id : it.value()) {
+            if (id != 0) {
+                list << idOf(id);
+            }
+        }
+    }
+
+    for (auto it = tree.dirs.constBegin(); it != tree.dirs.constEnd(); ++it) {
+        if (it.value() != 0) {
+            data.dirs.insert(it.key(), idOf(it.value()));
+        }
+    }
+}
+
+void FileIndex::readEvents()
+{
+#if defined Q_OS_LINUX
+    alignas(struct inotify_event) char buffer[4096];
+    bool changed = false;
+
+    forever {
+        const auto length = ::read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+
+        for (char *ptr = buffer; ptr < buffer + length;) {
+            const auto event = reinterpret_cast<const struct inotify_event *>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // events were lost, only a new scan can bring the index back
+                m_ready = false;
+                if (!m_scanning.exchange(true)) {
+                    QtConcurrent::run([this]() {
+                        this->scan();
+                    });
+                }
+                continue;
+            }
+
+            if (event->mask & IN_IGNORED) {
+                QWriteLocker locker(&m_lock);
+                m_watches.remove(event->wd);
+                continue;
+            }
+
+            if (event->len == 0 || event->name[0] == '.') {
+                continue;
+            }
+
+            QString dir;
+            {
+                QReadLocker locker(&m_lock);
+                dir = m_watches.value(event->wd);
+            }
+
+            if (dir.isEmpty()) {
+                continue;
+            }
+
+            const auto path = dir + QLatin1Char('/') + QFile::decodeName(event->name);
+            const bool isDir = event->mask & IN_ISDIR;
+            emit this->entryChanged(path);
+
+            // the names are the same, only the listeners care about the contents
+            if (event->mask & IN_CLOSE_WRITE) {
+                continue;
+            }
+
+            changed = true;
+
+            const bool removed = event->mask & (IN_DELETE | IN_MOVED_FROM);
+            if (m_scanning && (removed || (event->mask & (IN_CREATE | IN_MOVED_TO)))) {
+                QWriteLocker locker(&m_lock);
+                // checked again under the lock, the scan clears it when it publishes its data
+                if (m_scanning) {
+                    m_journal << Change {removed, isDir, dir, QFile::decodeName(event->name)};
+                }
+            }
+
+            if (removed) {
+                QWriteLocker locker(&m_lock);
+                FileIndex::remove(m_data, path);
+            } else if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                {
+                    QWriteLocker locker(&m_lock);
+                    const auto parent = m_data.dirs.constFind(dir);
+                    if (parent == m_data.dirs.constEnd()) {
+                        continue;
+                    }
+
+                    const auto id = FileIndex::add(m_data, parent.value(), QFile::decodeName(event->name), isDir);
+                    if (isDir) {
+                        m_data.dirs.insert(path, id);
+                    }
+                }
+
+                if (isDir) {
+                    this->watch(path);
+                    // a directory moved in can hold a whole tree
+                    QtConcurrent::run([this, path]() {
+                        this->indexTree(path);
+                    });
+                }
+            }
+        }
+    }
+
+    if (changed && !m_saveTimer->isActive()) {
+        m_saveTimer->start();
+    }
+#endif
+}
+
+bool FileIndex::covers(const QString &path) const
+{
+    if (!m_ready) {
+        return false;
+    }
+
+    const auto clean = QDir::cleanPath(path);
+
+    QReadLocker locker(&m_lock);
+    for (const auto &root : m_data.roots) {
+        if (clean == root) {
+            return true;
+        }
+
+        if (clean.startsWith(root + QLatin1Char('/'))) {
+            // hidden directories are not indexed
+            return !clean.mid(root.size()).contains(QStringLiteral("/."));
+        }
+    }
+
+    return false;
+}
+
+QStringList FileIndex::query(const QString &path, const QString &text, const bool &onlyDirs, const uint &limit, const CancelToken &token) const
+{
+    QStringList res;
+    QSet<QString> paths; // a directory created and filled quickly can have its entries indexed twice
+
+    QReadLocker locker(&m_lock);
+    const auto base = m_data.dirs.constFind(QDir::cleanPath(path));
+    if (base == m_data.dirs.constEnd()) {
+        return res;
+    }
+
+    // the entries holding every trigram of the text, starting from the rarest one
+    QVector<quint32> candidates;
+    const auto grams = trigrams(text);
+    if (!grams.isEmpty()) {
+        QVector<const QVector<quint32> *> lists;
+        for (const auto &gram : grams) {
+            const auto it = m_data.postings.constFind(gram);
+            if (it == m_data.postings.constEnd()) {
+                return res;
+            }
+            lists << &it.value();
+        }
+
+        std::sort(lists.begin(), lists.end(), [](const QVector<quint32> *a, const QVector<quint32> *b) {
+            return a->size() < b->size();
+        });
+
+        candidates = *lists.first();
+        for (int i = 1; i < lists.size() && !candidates.isEmpty(); i++) {
+            QVector<quint32> intersection;
+            std::set_intersection(candidates.constBegin(), candidates.constEnd(), lists.at(i)->constBegin(), lists.at(i)->constEnd(), std::back_inserter(intersection));
+            candidates.swap(intersection);
+        }
+    } else {
+        // too short to have trigrams, every name has to be checked
+        candidates.resize(m_data.entries.size());
+        std::iota(candidates.begin(), candidates.end(), 0);
+    }
+
+    for (int i = 0; i < candidates.size(); i++) {
+        if (i % 1024 == 0 && token.isCancelled()) {
+            break;
+        }
+
+        const auto id = candidates.at(i);
+        const auto &entry = m_data.entries.at(id);
+
+        if (entry.parent == NO_PARENT || (entry.flags & REMOVED) || (onlyDirs && !(entry.flags & DIR))) {
+            continue;
+        }
+
+        // the trigrams can match in a different order
+        if (!entry.name.contains(text, Qt::CaseInsensitive)) {
+            continue;
+        }
+
+        // inside the searched directory, and none of the directories in between removed
+        bool inside = false;
+        for (auto parent = entry.parent; parent != NO_PARENT; parent = m_data.entries.at(parent).parent) {
+            if (m_data.entries.at(parent).flags & REMOVED) {
+                break;
+            }
+
+            if (parent == base.value()) {
+                inside = true;
+                break;
+            }
+        }
+
+        if (!inside) {
+            continue;
+        }
+
+        const auto entryPath = FileIndex::pathOf(m_data, id);
+        if (entryPath.isEmpty() || paths.contains(entryPath)) {
+            continue;
+        }
+
+        paths.insert(entryPath);
+
+        res << entryPath;
+        if (limit > 0 && static_cast<uint>(res.size()) >= limit) {
+            break;
+        }
+    }
+
+    return res;
+}
+
+QStringList FileIndex::roots() const
+{
+    QReadLocker locker(&m_lock);
+    return m_data.roots;
+}
+
+int FileIndex::count() const
+{
+    QReadLocker locker(&m_lock);
+    return m_data.entries.size();
+}
+
+void FileIndex::save()
+{
+    if (m_scanning) {
+        return; // the scan saves once it is done
+    }
+
+    Data data;
+    {
+        QReadLocker locker(&m_lock);
+        data = m_data; // implicitly shared, the copy is cheap
+    }
+
+    QtConcurrent::run([data]() {
+        // leave the removed entries out and renumber the rest, the parents always come before their children
+        QVector<quint32> ids(data.entries.size(), NO_PARENT);
+        QVector<Entry> entries;
+        entries.reserve(data.entries.size());
+
+        for (int i = 0; i < data.entries.size(); i++) {
+            const auto &entry = data.entries.at(i);
+            if ((entry.flags & REMOVED) || (entry.parent != NO_PARENT && ids.at(entry.parent) == NO_PARENT)) {
+                continue;
+            }
+
+            ids[i] = static_cast<quint32>(entries.size());
+            entries << Entry {entry.parent == NO_PARENT ? NO_PARENT : ids.at(entry.parent), entry.flags, entry.name};
+        }
+
+        QSaveFile file(FileIndex::filePath());
+        QDir().mkpath(QFileInfo(file.fileName()).path());
+        if (!file.open(QIODevice::WriteOnly)) {
+            return;
+        }
+
+        QDataStream out(&file);
+        out.setVersion(QDataStream::Qt_5_10);
+        out << MAGIC << VERSION << data.roots << static_cast<qint32>(entries.size());
+        for (const auto &entry : qAsConst(entries)) {
+            out << entry.parent << entry.flags << entry.name;
+        }
+
+        out << static_cast<qint32>(data.postings.size());
+        for (auto it = data.postings.constBegin(); it != data.postings.constEnd(); ++it) {
+            QVector<quint32> list;
+            list.reserve(it.value().size());
+            for (const auto &id : it.value()) {
+                if (ids.at(id) != NO_PARENT) {
+                    list << ids.at(id);
+                }
+            }
+
+            out << it.key() << list;
+        }
+
+        file.commit();
+    });
+}
+
+bool FileIndex::load()
+{
+    QFile file(FileIndex::filePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const auto size = file.size();
+    uchar *map = file.map(0, size);
+    if (!map) {
+        return false;
+    }
+
+    const auto raw = QByteArray::fromRawData(reinterpret_cast<const char *>(map), static_cast<int>(size));
+    QDataStream in(raw);
+    in.setVersion(QDataStream::Qt_5_10);
+
+    Data data;
+    quint32 magic = 0, version = 0;
+    qint32 count = 0;
+    in >> magic >> version >> data.roots >> count;
+
+    // the places may have moved since
+    bool res = magic == MAGIC && version == VERSION && data.roots == FileIndex::defaultRoots() && count >= 0;
+
+    if (res) {
+        // the counts are not trusted further than what the file can hold
+        data.entries.reserve(static_cast<int>(qMin<qint64>(count, size / MIN_ENTRY_BYTES)));
+        // the paths are walked up through the parents and the postings index the entries, a file not written by save
+        // could send those out of bounds or round in circles
+        for (qint32 i = 0; i < count && in.status() == QDataStream::Ok && res; i++) {
+            Entry entry;
+            in >> entry.parent >> entry.flags >> entry.name;
+            res = entry.parent == NO_PARENT || entry.parent < static_cast<quint32>(i);
+            data.entries << entry;
+        }
+
+        qint32 postings = 0;
+        in >> postings;
+        data.postings.reserve(static_cast<int>(qBound<qint64>(0, postings, size / MIN_POSTING_BYTES)));
+        for (qint32 i = 0; i < postings && in.status() == QDataStream::Ok && res; i++) {
+            quint64 key;
+            QVector<quint32> list;
+            in >> key >> list;
+            res = std::is_sorted(list.constBegin(), list.constEnd()) && (list.isEmpty() || list.last() < static_cast<quint32>(data.entries.size()));
+            data.postings.insert(key, list);
+        }
+
+        res = res && in.status() == QDataStream::Ok;
+    }
+
+    file.unmap(map);
+
+    if (!res) {
+        return false;
+    }
+
+    for (int i = 0; i < data.entries.size(); i++) {
+        if (data.entries.at(i).flags & DIR) {
+            data.dirs.insert(FileIndex::pathOf(data, static_cast<quint32>(i)), static_cast<quint32>(i));
+        }
+    }
+
+    QWriteLocker locker(&m_lock);
+    m_data = data;
+    return true;
+}
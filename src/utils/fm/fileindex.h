@@ -0,0 +1,167 @@
+#ifndef FILEINDEX_H
+#define FILEINDEX_H
+
+#include <QHash>
+#include <QObject>
+#include <QReadWriteLock>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <atomic>
+#include <functional>
+
+#include "fmh.h"
+#include "mauikit_export.h"
+
+class QSocketNotifier;
+class QTimer;
+
+namespace FMH
+{
+/**
+ * @brief The FileIndex class
+ * Index of the file names under the default places, used to answer substring searches without walking the trees.
+ * Every name is split into the trigrams of its case folded form, and each trigram keeps the sorted list of the
+ * entries holding it. A query intersects the lists of its trigrams and only checks the names left.
+ * Hidden entries are not indexed. The index is kept current with inotify. It is saved to the cache location, shared by
+ * all the applications, and loaded back through a memory map on the next start, while a fresh scan runs in the
+ * background. Walking the trees and watching every directory is not cheap, so nothing is done until the index is
+ * activated by the first one that needs it.
+ * It is only available on Linux; elsewhere covers() is always false.
+ */
+class MAUIKIT_EXPORT FileIndex : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief instance
+     * The index lives in the application thread, it does nothing until activated
+     * @return
+     * Null when there is no application
+     */
+    static FileIndex *instance();
+
+    /**
+     * @brief activate
+     * Loads the saved index and starts the scan and the watches, only the first call does something. It can be
+     * called from any thread
+     */
+    void activate();
+
+    /**
+     * @brief covers
+     * @param path
+     * Local path
+     * @return
+     * If the index is ready and the path is inside one of its roots, and not inside a hidden directory
+     */
+    bool covers(const QString &path) const;
+
+    /**
+     * @brief query
+     * Finds the entries under a path whose name contains the given text, ignoring the case
+     * @param path
+     * Local path, it should be covered by the index
+     * @param text
+     * @param onlyDirs
+     * @param limit
+     * Maximum number of results, 0 for no limit
+     * @param token
+     * @return
+     * Local paths of the entries found. They are not checked against the disk
+     */
+    QStringList query(const QString &path, const QString &text, const bool &onlyDirs = false, const uint &limit = 0, const CancelToken &token = CancelToken()) const;
+
+    /**
+     * @brief roots
+     * @return
+     * Local paths of the indexed trees
+     */
+    QStringList roots() const;
+
+    /**
+     * @brief count
+     * @return
+     * Number of indexed entries, including the ones removed since the last scan
+     */
+    int count() const;
+
+    /**
+     * @brief defaultRoots
+     * @return
+     * Local paths of the trees to index: the default places that exist, without the ones inside another
+     */
+    static QStringList defaultRoots();
+
+signals:
+    /**
+     * @brief entryChanged
+     * An entry under the indexed trees was created, removed, moved or written
+     * @param path
+     * Local path of the entry, it may not exist anymore
+     */
+    void entryChanged(const QString &path);
+
+private:
+    enum FLAG : quint8 {
+        DIR = 1 << 0,
+        REMOVED = 1 << 1
+    };
+
+    struct Entry {
+        quint32 parent; // entry of the containing directory, NO_PARENT for the roots
+        quint8 flags;
+        QString name; // the full path for the roots
+    };
+
+    struct Change {
+        bool removed;
+        bool isDir;
+        QString dir;
+        QString name;
+    };
+
+    struct Data {
+        QStringList roots;
+        QVector<Entry> entries;
+        QHash<quint64, QVector<quint32>> postings; // trigram to sorted entry ids
+        QHash<QString, quint32> dirs; // path to entry id of every directory
+    };
+
+    explicit FileIndex(QObject *parent = nullptr);
+    ~FileIndex();
+
+    mutable QReadWriteLock m_lock;
+    Data m_data;
+    QHash<int, QString> m_watches; // inotify watch descriptor to directory path
+    QVector<Change> m_journal; // the changes seen while scanning, replayed on the scanned data
+    std::atomic<bool> m_activated {false};
+    std::atomic<bool> m_ready {false};
+    std::atomic<bool> m_scanning {false};
+    std::atomic<bool> m_unwatched {false}; // some directory could not be watched
+
+    int m_fd = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    QTimer *m_saveTimer;
+
+    Q_INVOKABLE void start();
+    Q_INVOKABLE void save();
+    void scan();
+    bool load();
+    void readEvents();
+    void watch(const QString &path);
+    void indexTree(const QString &path);
+
+    static QString filePath();
+    static QVector<quint64> trigrams(const QString &name);
+    static quint32 add(Data &data, const quint32 &parent, const QString &name, const bool &isDir);
+    static void remove(Data &data, const QString &path);
+    static quint32 find(const Data &data, const quint32 &parent, const QString &name);
+    static void merge(Data &data, const Data &tree, const QString &path);
+    static QString pathOf(const Data &data, quint32 id);
+    static void walk(Data &data, const QString &root, const std::function<void(const QString &dir)> &onDir);
+};
+}
+
+#endif // FILEINDEX_H
@@ -1,8 +1,13 @@
 #include "fileloader.h"
+#include "direnumerator.h"
+#include "dirwalker.h"
+
+#include <QMetaMethod>
 
 using namespace FMH;
 
-std::function<FMH::MODEL(const QUrl &url)> FileLoader::informer =  &FMH::getFileInfoModel;
+std::function<FMH::FileItem(const QUrl &url)> FileLoader::itemInformer = nullptr;
+std::function<FMH::MODEL(const QUrl &url)> FileLoader::informer = nullptr;
 
 FileLoader::FileLoader(QObject *parent) : QObject(parent)
     ,m_thread ( new QThread )
@@ -10,6 +15,9 @@ FileLoader::FileLoader(QObject *parent) : QObject(parent)
     qRegisterMetaType<QDir::Filters>("QDir::Filters");
     qRegisterMetaType<FMH::MODEL>("FMH::MODEL");
     qRegisterMetaType<FMH::MODEL_LIST>("FMH::MODEL_LIST");
+    qRegisterMetaType<FMH::FileItem>("FMH::FileItem");
+    qRegisterMetaType<FMH::FILE_LIST>("FMH::FILE_LIST");
+    qRegisterMetaType<FMH::CancelToken>("FMH::CancelToken");
     this->moveToThread(m_thread);
     connect(m_thread, &QThread::finished, m_thread, &QObject::deleteLater);
     connect(this, &FileLoader::start, this, &FileLoader::getFiles);
@@ -18,6 +26,7 @@ FileLoader::FileLoader(QObject *parent) : QObject(parent)
 
 FileLoader::~FileLoader()
 {
+    m_token.cancel();
     m_thread->quit();
     m_thread->wait();
 }
@@ -32,54 +41,166 @@ uint FileLoader::batchCount() const
     return m_batchCount;
 }
 
+void FileLoader::setLazy(const bool &lazy)
+{
+    m_lazy = lazy;
+}
+
 void FileLoader::requestPath(const QList<QUrl> &urls, const bool &recursive, const QStringList &nameFilters, const QDir::Filters &filters, const uint &limit)
 {
-    emit this->start(urls, recursive, nameFilters, filters, limit);
+    m_token.cancel();
+    m_token = CancelToken(++m_generation);
+    emit this->start(urls, recursive, nameFilters, filters, limit, m_token);
 }
 
-void FileLoader::getFiles(QList<QUrl> paths, bool recursive, const QStringList &nameFilters, const QDir::Filters &filters, uint limit)
+void FileLoader::cancel()
 {
+    m_token.cancel();
+}
+
+void FileLoader::getFiles(QList<QUrl> paths, bool recursive, const QStringList &nameFilters, const QDir::Filters &filters, uint limit, FMH::CancelToken token)
+{
+    // superseded while waiting in the queue
+    if (token.isCancelled()) {
+        return;
+    }
+
     uint count = 0; //total count
     uint i = 0; //count per batch
     uint batch = 0; //batches count
-    MODEL_LIST res;
-    MODEL_LIST res_batch;
+    FILE_LIST res;
+    FILE_LIST res_batch;
 
-    for (const auto &path : paths) {
-        if (QFileInfo(path.toLocalFile()).isDir() && path.isLocalFile() && fileExists(path)) {
-            QDirIterator it(path.toLocalFile(), nameFilters, filters, recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+    // the model based signals are only packed for whoever still listens to them
+    const bool models = this->isSignalConnected(QMetaMethod::fromSignal(&FileLoader::itemReady))
+        || this->isSignalConnected(QMetaMethod::fromSignal(&FileLoader::itemsReady))
+        || this->isSignalConnected(QMetaMethod::fromSignal(&FileLoader::finished));
+    MODEL_LIST models_res;
+    MODEL_LIST models_batch;
 
-            while (it.hasNext()) {
-                const auto url = QUrl::fromLocalFile(it.next());
-                MODEL map = FileLoader::informer(url);
+    const auto sendBatch = [&]() {
+        emit fileItemsReady(res_batch, paths);
+        if (models) {
+            emit itemsReady(models_batch, paths);
+            models_batch.clear();
+        }
+        res_batch.clear();
+    };
 
-                if (map.isEmpty()) {
-                    continue;
-                }
+    const auto sendFinished = [&]() {
+        emit fileItemsFinished(res, paths);
+        if (models) {
+            emit finished(models_res, paths);
+        }
+    };
+
+    // returns false once the limit has been reached or the request has been superseded. The model is the one of the
+    // informer, if any
+    const auto collect = [&](const FileItem &item, const MODEL &model) -> bool {
+        if (token.isCancelled()) {
+            return false;
+        }
+
+        emit fileItemReady(item, paths);
+        res << item;
+        res_batch << item;
+
+        if (models) {
+            const auto data = model.isEmpty() ? item.toModel() : model;
+            emit itemReady(data, paths);
+            models_res << data;
+            models_batch << data;
+        }
+
+        i++;
+        count++;
+
+        if (i == m_batchCount) { //send a batch
+            sendBatch();
+            batch++;
+            i = 0;
+        }
 
-                emit itemReady(map, paths);
-                res << map;
-                res_batch << map;
-                i++;
-                count++;
-
-                if (i == m_batchCount) { //send a batch
-                    emit itemsReady(res_batch, paths);
-                    res_batch.clear ();
-                    batch++;
-                    i = 0;
+        return count != limit;
+    };
+
+    // without a custom informer the entries can be listed and packed in one go
+    const bool native = !FileLoader::informer && !FileLoader::itemInformer && DirEnumerator::isSupported();
+
+    if (native && recursive) {
+        QStringList dirs;
+        for (const auto &path : paths) {
+            if (path.isLocalFile() && QFileInfo(path.toLocalFile()).isDir()) {
+                dirs << path.toLocalFile();
+            }
+        }
+
+        DirWalker walker(nameFilters, filters);
+        walker.setLimit(limit);
+        walker.setBatchCount(m_batchCount);
+        walker.setCancelToken(token);
+        walker.walk(dirs, [&](const FILE_LIST &items) {
+            for (const auto &item : items) {
+                emit fileItemReady(item, paths);
+            }
+
+            res << items;
+            emit fileItemsReady(items, paths);
+
+            if (models) {
+                const auto data = FMH::toModelList(items);
+                for (const auto &model : data) {
+                    emit itemReady(model, paths);
                 }
 
-                if (count == limit) {
-                    break;
+                models_res << data;
+                emit itemsReady(data, paths);
+            }
+        });
+
+        if (!token.isCancelled()) {
+            sendFinished();
+        }
+        return;
+    }
+
+    DirEnumerator enumerator(nameFilters, filters, recursive);
+    enumerator.setLazy(m_lazy);
+
+    for (const auto &path : paths) {
+        if (QFileInfo(path.toLocalFile()).isDir() && path.isLocalFile() && fileExists(path)) {
+            if (native) {
+                enumerator.enumerate(path.toLocalFile(), [&](const FileItem &item) {
+                    return collect(item, MODEL());
+                });
+            } else {
+                QDirIterator it(path.toLocalFile(), nameFilters, filters, recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+
+                while (it.hasNext()) {
+                    const auto url = QUrl::fromLocalFile(it.next());
+                    const auto model = FileLoader::informer ? FileLoader::informer(url) : MODEL();
+                    const FileItem item = FileLoader::informer ? FileItem::fromModel(model) : FileLoader::itemInformer ? FileLoader::itemInformer(url) : FMH::getFileItem(url);
+
+                    if (item.isEmpty()) {
+                        continue;
+                    }
+
+                    if (!collect(item, model)) {
+                        break;
+                    }
                 }
             }
         }
 
-        if (count == limit) {
+        if (count == limit || token.isCancelled()) {
             break;
         }
     }
-    emit itemsReady(res_batch, paths);
-    emit finished(res, paths);
+
+    if (token.isCancelled()) {
+        return;
+    }
+
+    sendBatch();
+    sendFinished();
 }
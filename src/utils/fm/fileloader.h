@@ -26,6 +26,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDir>
 #include <QUrl>
 
+#include <atomic>
+
 #include "fmh.h"
 #include "mauikit_export.h"
 
@@ -45,6 +47,13 @@ public:
     void setBatchCount(const uint &count);
     uint batchCount() const;
 
+    /**
+     * @brief setLazy
+     * Lists the directories in lazy mode, see DirEnumerator::setLazy. It only applies to the native enumeration
+     * @param lazy
+     */
+    void setLazy(const bool &lazy);
+
     /**
      * @brief requestPath
      * @param urls
@@ -55,6 +64,24 @@ public:
      */
     void requestPath(const QList<QUrl> &urls, const bool &recursive, const QStringList &nameFilters = {}, const QDir::Filters &filters = QDir::Files, const uint &limit = 99999);
 
+    /**
+     * @brief cancel
+     * Stops the ongoing request within one batch and drops its results. A new request also cancels the previous one
+     */
+    void cancel();
+
+    /**
+     * @brief itemInformer
+     * Function used to pack the information of each file found. When neither it nor informer is set the entries are
+     * listed and packed by the native DirEnumerator where available, otherwise by FMH::getFileItem
+     */
+    static std::function<FMH::FileItem(const QUrl &url)> itemInformer;
+
+    /**
+     * @brief informer
+     * Model based version of itemInformer, it goes first when both are set. The models it packs are given as they are
+     * to the model based signals, with their own keys. It is not set by default
+     */
     static std::function<FMH::MODEL(const QUrl &url)> informer;
 
 private slots:
@@ -65,12 +92,20 @@ private slots:
      * @param nameFilters
      * @param filters
      * @param limit
+     * @param token
      */
-    void getFiles(QList<QUrl> paths, bool recursive, const QStringList &nameFilters, const QDir::Filters &filters, uint limit);
+    void getFiles(QList<QUrl> paths, bool recursive, const QStringList &nameFilters, const QDir::Filters &filters, uint limit, FMH::CancelToken token);
 
 signals:
+    /**
+     * @brief fileItemsFinished
+     * @param items
+     */
+    void fileItemsFinished(FMH::FILE_LIST items, QList<QUrl> &urls);
+
     /**
      * @brief finished
+     * Model based version of fileItemsFinished. The model based signals are only packed when something is connected to them
      * @param items
      */
     void finished(FMH::MODEL_LIST items, QList<QUrl> &urls);
@@ -82,17 +117,32 @@ signals:
      * @param nameFilters
      * @param filters
      * @param limit
+     * @param token
+     */
+    void start(QList<QUrl> urls, bool recursive, const QStringList &nameFilters, const QDir::Filters &filters, uint limit, FMH::CancelToken token);
+
+    /**
+     * @brief fileItemsReady
+     * @param items
+     */
+    void fileItemsReady(FMH::FILE_LIST items, QList<QUrl> &urls);
+
+    /**
+     * @brief fileItemReady
+     * @param item
      */
-    void start(QList<QUrl> urls, bool recursive, const QStringList &nameFilters, const QDir::Filters &filters, uint limit);
+    void fileItemReady(FMH::FileItem item, QList<QUrl> &urls);
 
     /**
      * @brief itemsReady
+     * Model based version of fileItemsReady
      * @param items
      */
     void itemsReady(FMH::MODEL_LIST items, QList<QUrl> &urls);
 
     /**
      * @brief itemReady
+     * Model based version of fileItemReady
      * @param item
      */
     void itemReady(FMH::MODEL item, QList<QUrl> &urls);
@@ -100,6 +150,10 @@ signals:
 private:
     QThread *m_thread;
     uint m_batchCount = 1500;
+    std::atomic<bool> m_lazy {false};
+
+    quint64 m_generation = 0;
+    CancelToken m_token;
 
 };
 }
@@ -19,6 +19,7 @@
  */
 
 #include "fm.h"
+#include "dirstats.h"
 
 #ifdef COMPONENT_TAGGING
 #include "tagging.h"
@@ -50,45 +51,135 @@
 
 #if defined(Q_OS_ANDROID) || defined(Q_OS_WIN) || defined(Q_OS_MACOS)
 #include "fileloader.h"
+#include "dirwatcher.h"
 
-#include <QFileSystemWatcher>
+#include <QDir>
+#include <QSet>
 
 QDirLister::QDirLister(QObject *parent)
     : QObject(parent)
     , m_loader(new FMH::FileLoader)
-    , m_watcher(new QFileSystemWatcher(this))
+    , m_watcher(new FMH::DirWatcher(this))
 {
     m_loader->setBatchCount(20);
-    m_loader->informer = &FMH::getFileInfoModel;
-    connect(m_loader, &FMH::FileLoader::itemsReady, [this](FMH::MODEL_LIST items, QList<QUrl> urls) {
+    m_loader->setLazy(true); // the details of the items are resolved once they are shown
+    connect(m_loader, &FMH::FileLoader::fileItemsReady, [this](FMH::FILE_LIST items, QList<QUrl> urls) {
         emit this->itemsReady(items, urls.first());
     });
 
-    connect(m_loader, &FMH::FileLoader::itemReady, [this](FMH::MODEL item, QList<QUrl> urls) {
+    connect(m_loader, &FMH::FileLoader::fileItemReady, [this](FMH::FileItem item, QList<QUrl> urls) {
+        this->m_index.insert(item.url, this->m_list.size());
         this->m_list << item;
-        this->m_watcher->addPath(QUrl(item[FMH::MODEL_KEY::URL]).toLocalFile());
+        this->m_watcher->addFile(QUrl(item.url).toLocalFile());
         emit this->itemReady(item, urls.first());
     });
 
-    connect(m_loader, &FMH::FileLoader::finished, [this](FMH::MODEL_LIST, QList<QUrl> urls) {
+    connect(m_loader, &FMH::FileLoader::fileItemsFinished, [this](FMH::FILE_LIST, QList<QUrl> urls) {
         emit this->completed(urls.first());
     });
 
-    connect(this->m_watcher, &QFileSystemWatcher::directoryChanged, [&](const QString &path) {
-        if (path == this->m_url.toLocalFile()) {
-            this->reviewChanges();
-        }
+    connect(this->m_watcher, &FMH::DirWatcher::rescanNeeded, [&]() {
+        this->reviewChanges();
     });
 
-    connect(this->m_watcher, &QFileSystemWatcher::fileChanged, [&](const QString &path) {
+    connect(this->m_watcher, &FMH::DirWatcher::changed, this, &QDirLister::applyChanges);
+}
+
+bool QDirLister::accepts(const QFileInfo &file) const
+{
+    if (!m_showDotFiles && file.isHidden()) {
+        return false;
+    }
+
+    if (file.isDir()) {
+        return true;
+    }
+
+    if (m_dirOnly) {
+        return false;
+    }
 
-        const auto fileUrl = QUrl::fromLocalFile(path);
-        if (this->includes(fileUrl)) {
+    return m_nameFilters.isEmpty() || QDir::match(m_nameFilters.split(" "), file.fileName());
+}
+
+void QDirLister::applyChanges(const QStringList &added, const QStringList &removed, const QStringList &modified)
+{
+    const QDir dir(this->m_url.toLocalFile());
+
+    FMH::FILE_LIST newItems;
+    QVector<QPair<FMH::FileItem, FMH::FileItem>> changedItems;
+
+    // entries that show up again or that were not listed because they did not exist yet are handled the same way
+    for (const auto &name : added + modified) {
+        const auto fileUrl = QUrl::fromLocalFile(dir.filePath(name));
+        const auto index = this->indexOf(fileUrl.toString());
+
+        if (index >= 0) {
             if (FMH::fileExists(fileUrl)) {
-                emit this->refreshItems({{this->m_list.at(this->indexOf(FMH::MODEL_KEY::URL, fileUrl.toString())), FMH::getFileInfoModel(fileUrl)}}, this->m_url);
+                const auto item = FMH::getFileItem(fileUrl);
+                changedItems << QPair<FMH::FileItem, FMH::FileItem> {this->m_list.at(index), item};
+                this->m_list[index] = item;
             }
+            continue;
         }
-    });
+
+        const QFileInfo file(fileUrl.toLocalFile());
+        if (!file.exists() || !this->accepts(file)) {
+            continue;
+        }
+
+        const auto item = FMH::getFileItem(fileUrl);
+        if (item.isEmpty()) {
+            continue;
+        }
+
+        newItems << item;
+        this->m_index.insert(item.url, this->m_list.size());
+        this->m_list << item;
+        this->m_watcher->addFile(fileUrl.toLocalFile());
+    }
+
+    FMH::FILE_LIST removedItems;
+    for (const auto &name : removed) {
+        const auto fileUrl = QUrl::fromLocalFile(dir.filePath(name));
+        const auto index = this->indexOf(fileUrl.toString());
+
+        if (index >= 0) {
+            removedItems << this->m_list.at(index);
+            this->m_watcher->removeFile(fileUrl.toLocalFile());
+        }
+    }
+
+    if (!removedItems.isEmpty()) {
+        QSet<QString> removedUrls;
+        for (const auto &item : qAsConst(removedItems)) {
+            removedUrls << item.url;
+        }
+
+        FMH::FILE_LIST keptItems;
+        keptItems.reserve(this->m_list.size() - removedItems.size());
+        for (const auto &item : qAsConst(this->m_list)) {
+            if (!removedUrls.contains(item.url)) {
+                keptItems << item;
+            }
+        }
+
+        this->m_list = keptItems;
+        this->m_index.clear();
+        for (auto i = 0; i < this->m_list.size(); i++) {
+            this->m_index.insert(this->m_list.at(i).url, i);
+        }
+
+        emit this->itemsDeleted(removedItems, this->m_url);
+    }
+
+    if (!newItems.isEmpty()) {
+        emit this->itemsAdded(newItems, this->m_url);
+    }
+
+    if (!changedItems.isEmpty()) {
+        emit this->refreshItems(changedItems, this->m_url);
+    }
 }
 
 void QDirLister::reviewChanges()
@@ -99,38 +190,43 @@ void QDirLister::reviewChanges()
 
     this->m_checking = true;
     auto checkLoader = new FMH::FileLoader;
-    checkLoader->informer = &FMH::getFileInfoModel;
 
-    FMH::MODEL_LIST removedItems;
-    const auto mlist = this->m_list; //use a copy to not affect the list indexes on the iterations
-    for (const auto &item : qAsConst(mlist)) {
-        const auto fileUrl = QUrl(item[FMH::MODEL_KEY::URL]);
+    // drop the missing items in a single pass and reindex the remaining ones
+    FMH::FILE_LIST removedItems;
+    FMH::FILE_LIST keptItems;
+    keptItems.reserve(this->m_list.size());
+    for (const auto &item : qAsConst(this->m_list)) {
+        const auto fileUrl = QUrl(item.url);
 
         if (!FMH::fileExists(fileUrl)) {
-            const auto index = this->indexOf(FMH::MODEL_KEY::URL, fileUrl.toString());
-
-            if (index < this->m_list.count() && index >= 0) {
-                removedItems << item;
-                this->m_list.remove(index);
-                this->m_watcher->removePath(fileUrl.toLocalFile());
-            }
+            removedItems << item;
+            this->m_watcher->removeFile(fileUrl.toLocalFile());
+        } else {
+            keptItems << item;
         }
     }
 
     if (!removedItems.isEmpty()) {
+        this->m_list = keptItems;
+        this->m_index.clear();
+        for (auto i = 0; i < this->m_list.size(); i++) {
+            this->m_index.insert(this->m_list.at(i).url, i);
+        }
+
         emit this->itemsDeleted(removedItems, this->m_url);
     }
 
-    connect(checkLoader, &FMH::FileLoader::itemsReady, [=](FMH::MODEL_LIST items, QList<QUrl> urls) {
+    connect(checkLoader, &FMH::FileLoader::itemsReady, [=](FMH::FILE_LIST items, QList<QUrl> urls) {
         if (urls.first() == this->m_url) {
-            FMH::MODEL_LIST newItems;
+            FMH::FILE_LIST newItems;
             for (const auto &item : qAsConst(items)) {
-                const auto fileUrl = QUrl(item[FMH::MODEL_KEY::URL]);
+                const auto fileUrl = QUrl(item.url);
                 if (!this->includes(fileUrl)) {
                     newItems << item;
 
+                    this->m_index.insert(item.url, this->m_list.size());
                     this->m_list << item;
-                    this->m_watcher->addPath(fileUrl.toLocalFile());
+                    this->m_watcher->addFile(fileUrl.toLocalFile());
                 }
             }
 
@@ -144,7 +240,7 @@ void QDirLister::reviewChanges()
 
     });
 
-    connect(checkLoader, &FMH::FileLoader::finished, [=](FMH::MODEL_LIST, QList<QUrl>) {
+    connect(checkLoader, &FMH::FileLoader::finished, [=](FMH::FILE_LIST, QList<QUrl>) {
         checkLoader->deleteLater();
         this->m_checking = false;
     });
@@ -160,19 +256,12 @@ void QDirLister::reviewChanges()
 
 bool QDirLister::includes(const QUrl &url)
 {
-    return this->indexOf(FMH::MODEL_KEY::URL, url.toString()) >= 0;
+    return this->indexOf(url.toString()) >= 0;
 }
 
-int QDirLister::indexOf(const FMH::MODEL_KEY &key, const QString &value) const
+int QDirLister::indexOf(const QString &url) const
 {
-    const auto items = this->m_list;
-    const auto it = std::find_if(items.constBegin(), items.constEnd(), [&](const FMH::MODEL &item) -> bool { return item[key] == value; });
-
-    if (it != items.constEnd()) {
-        return std::distance(items.constBegin(), it);
-    } else {
-        return -1;
-    }
+    return this->m_index.value(url, -1);
 }
 
 bool QDirLister::openUrl(const QUrl &url)
@@ -182,11 +271,12 @@ bool QDirLister::openUrl(const QUrl &url)
 
     this->m_url = url;
     this->m_list.clear();
-    this->m_watcher->removePaths(QStringList() << this->m_watcher->directories() << this->m_watcher->files());
+    this->m_index.clear();
+    this->m_watcher->stop();
 
     if (FMStatic::isDir(this->m_url)) {
 
-        this->m_watcher->addPath(this->m_url.toLocalFile());
+        this->m_watcher->watch(this->m_url.toLocalFile());
 
         QDir::Filters dirFilter = (m_dirOnly ? QDir::AllDirs | QDir::NoDotDot | QDir::NoDot : QDir::Files | QDir::AllDirs | QDir::NoDotDot | QDir::NoDot);
 
@@ -203,6 +293,11 @@ bool QDirLister::openUrl(const QUrl &url)
     return true;
 }
 
+void QDirLister::stop()
+{
+    m_loader->cancel();
+}
+
 void QDirLister::setDirOnlyMode(bool value)
 {
     m_dirOnly = value;
@@ -240,14 +335,16 @@ FM::FM(QObject *parent)
 #if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
     this->dirLister->setAutoUpdate(true);
 
-    const static auto packItems = [](const KFileItemList &items) -> FMH::MODEL_LIST {
-        return std::accumulate(items.constBegin(), items.constEnd(), FMH::MODEL_LIST(), [](FMH::MODEL_LIST &res, const KFileItem &item) -> FMH::MODEL_LIST {
-            if (FMH::getFileInfo(item).size() > 0)
-            {
-                res << FMH::getFileInfo(item);
+    const static auto packItems = [](const KFileItemList &items) -> FMH::FILE_LIST {
+        FMH::FILE_LIST res;
+        res.reserve(items.size());
+        for (const auto &kitem : items) {
+            const auto item = FMH::getFileItem(kitem);
+            if (!item.isEmpty()) {
+                res << item;
             }
-            return res;
-        });
+        }
+        return res;
     };
 
     connect(dirLister, static_cast<void (KCoreDirLister::*)(const QUrl &)>(&KCoreDirLister::completed), this, [&](QUrl url) {
@@ -265,15 +362,15 @@ FM::FM(QObject *parent)
     connect(dirLister, static_cast<void (KCoreDirLister::*)(const QList<QPair<KFileItem, KFileItem>> &items)>(&KCoreDirLister::refreshItems), this, [&](QList<QPair<KFileItem, KFileItem>> items) {
 
         const auto res = std::accumulate(
-        items.constBegin(), items.constEnd(), QVector<QPair<FMH::MODEL, FMH::MODEL>>(), [](QVector<QPair<FMH::MODEL, FMH::MODEL>> &list, const QPair<KFileItem, KFileItem> &pair) -> QVector<QPair<FMH::MODEL, FMH::MODEL>> {
-            list << QPair<FMH::MODEL, FMH::MODEL> {FMH::getFileInfo(pair.first), FMH::getFileInfo(pair.second)};
+        items.constBegin(), items.constEnd(), QVector<QPair<FMH::FileItem, FMH::FileItem>>(), [](QVector<QPair<FMH::FileItem, FMH::FileItem>> &list, const QPair<KFileItem, KFileItem> &pair) -> QVector<QPair<FMH::FileItem, FMH::FileItem>> {
+            list << QPair<FMH::FileItem, FMH::FileItem> {FMH::getFileItem(pair.first), FMH::getFileItem(pair.second)};
             return list;
         });
 
         emit this->pathContentItemsChanged(res);
     });
 #else
-    connect(dirLister, &QDirLister::itemsReady, this, [&](FMH::MODEL_LIST items, QUrl url) {
+    connect(dirLister, &QDirLister::itemsReady, this, [&](FMH::FILE_LIST items, QUrl url) {
         emit this->pathContentItemsReady({url, items});
     });
 
@@ -281,15 +378,15 @@ FM::FM(QObject *parent)
         emit this->pathContentReady(url);
     });
 
-    connect(dirLister, &QDirLister::refreshItems, this, [&](QVector<QPair<FMH::MODEL, FMH::MODEL>> items, QUrl) {
+    connect(dirLister, &QDirLister::refreshItems, this, [&](QVector<QPair<FMH::FileItem, FMH::FileItem>> items, QUrl) {
         emit this->pathContentItemsChanged(items);
     });
 
-    connect(dirLister, &QDirLister::itemsAdded, this, [&](FMH::MODEL_LIST items, QUrl url) {
+    connect(dirLister, &QDirLister::itemsAdded, this, [&](FMH::FILE_LIST items, QUrl url) {
         emit this->pathContentItemsReady({url, items});
     });
 
-    connect(dirLister, &QDirLister::itemsDeleted, this, [&](FMH::MODEL_LIST items, QUrl url) {
+    connect(dirLister, &QDirLister::itemsDeleted, this, [&](FMH::FILE_LIST items, QUrl url) {
         emit this->pathContentItemsRemoved({url, items});
     });
 
@@ -341,6 +438,24 @@ FM::FM(QObject *parent)
         emit this->newItem(item, url);
     });
 #endif
+
+    // the index may report a change later than the lister, the totals of what the lister saw changing go right away
+    if (const auto stats = FMH::DirStats::instance()) {
+        connect(this, &FM::pathContentItemsChanged, stats, [stats](QVector<QPair<FMH::FileItem, FMH::FileItem>> items) {
+            for (const auto &pair : qAsConst(items)) {
+                const QUrl url(pair.first.url);
+                if (url.isLocalFile()) {
+                    stats->invalidate(url.toLocalFile());
+                }
+            }
+        });
+
+        connect(this, &FM::pathContentItemsRemoved, stats, [stats](FMH::PATH_CONTENT res) {
+            if (res.path.isLocalFile()) {
+                stats->invalidate(res.path.toLocalFile());
+            }
+        });
+    }
 }
 
 void FM::getPathContent(const QUrl &path, const bool &hidden, const bool &onlyDirs, const QStringList &filters, const QDirIterator::IteratorFlags &iteratorFlags)
@@ -355,6 +470,11 @@ void FM::getPathContent(const QUrl &path, const bool &hidden, const bool &onlyDi
     }
 }
 
+void FM::stopPathContent()
+{
+    this->dirLister->stop();
+}
+
 FMH::MODEL_LIST FM::getAppsPath()
 {
 #if defined Q_OS_ANDROID || defined Q_OS_WIN32 || defined Q_OS_MACOS || defined Q_OS_IOS // for android, windows and mac use this for now
@@ -456,7 +576,15 @@ bool FM::copy(const QList<QUrl> &urls, const QUrl &where)
 {
     // 	QStringList cloudPaths;
 
+#if defined Q_OS_ANDROID || defined Q_OS_WIN32 || defined Q_OS_MACOS || defined Q_OS_IOS
+    const auto copier = FMStatic::startCopy(urls, where);
+    connect(copier, &FMH::FileCopier::progressChanged, this, [this, copier]() {
+        emit this->loadProgress(copier->percent());
+    });
+    return true;
+#else
     return FMStatic::copy(urls, where);
+#endif
 
 #ifdef COMPONENT_SYNCING
     // 	if(!cloudPaths.isEmpty())
@@ -20,11 +20,12 @@
 #if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
 class KCoreDirLister;
 #else
-class QFileSystemWatcher;
+class QFileInfo;
 
 namespace FMH
 {
 class FileLoader;
+class DirWatcher;
 }
 /**
  * @brief The QDirLister class
@@ -62,20 +63,27 @@ public slots:
      */
     void setShowingDotFiles(bool value);
 
+    /**
+     * @brief stop
+     * Stops the listing in progress
+     */
+    void stop();
+
 signals:
-    void itemsReady(FMH::MODEL_LIST items, QUrl url);
-    void itemReady(FMH::MODEL item, QUrl url);
+    void itemsReady(FMH::FILE_LIST items, QUrl url);
+    void itemReady(FMH::FileItem item, QUrl url);
     void completed(QUrl url);
-    void itemsAdded(FMH::MODEL_LIST items, QUrl url);
-    void itemsDeleted(FMH::MODEL_LIST items, QUrl url);
-    void newItems(FMH::MODEL_LIST items, QUrl url);
-    void refreshItems(QVector<QPair<FMH::MODEL, FMH::MODEL>> items, QUrl url);
+    void itemsAdded(FMH::FILE_LIST items, QUrl url);
+    void itemsDeleted(FMH::FILE_LIST items, QUrl url);
+    void newItems(FMH::FILE_LIST items, QUrl url);
+    void refreshItems(QVector<QPair<FMH::FileItem, FMH::FileItem>> items, QUrl url);
 
 private:
     FMH::FileLoader *m_loader;
-    QFileSystemWatcher *m_watcher;
+    FMH::DirWatcher *m_watcher;
 
-    FMH::MODEL_LIST m_list;
+    FMH::FILE_LIST m_list;
+    QHash<QString, int> m_index; // url to position in m_list
     QString m_nameFilters;
     QUrl m_url;
     bool m_dirOnly = false;
@@ -84,8 +92,10 @@ private:
     bool m_checking = false;
 
     void reviewChanges();
+    void applyChanges(const QStringList &added, const QStringList &removed, const QStringList &modified);
+    bool accepts(const QFileInfo &file) const;
     bool includes(const QUrl &url);
-    int indexOf(const FMH::MODEL_KEY &key, const QString &value) const;
+    int indexOf(const QString &url) const;
 };
 #endif
 
@@ -143,6 +153,12 @@ public:
      */
     void getPathContent(const QUrl &path, const bool &hidden = false, const bool &onlyDirs = false, const QStringList &filters = QStringList(), const QDirIterator::IteratorFlags &iteratorFlags = QDirIterator::NoIteratorFlags);
 
+    /**
+     * @brief stopPathContent
+     * Stops the listing started by getPathContent, the batches left are not reported. The directory is still watched
+     */
+    void stopPathContent();
+
     /**
      * @brief resolveLocalCloudPath
      * Given a server address URL resolve it to the local cache URL. This only works if the syncing component has been enabled COMPONENT_SYNCING
@@ -189,7 +205,7 @@ signals:
     void pathContentReady(QUrl path);
     void pathContentItemsReady(FMH::PATH_CONTENT list);
     void pathContentChanged(QUrl path);
-    void pathContentItemsChanged(QVector<QPair<FMH::MODEL, FMH::MODEL>> items);
+    void pathContentItemsChanged(QVector<QPair<FMH::FileItem, FMH::FileItem>> items);
     void pathContentItemsRemoved(FMH::PATH_CONTENT list);
 
     void warningMessage(QString message);
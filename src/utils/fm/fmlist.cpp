@@ -19,6 +19,10 @@
 
 #include "fmlist.h"
 #include "fm.h"
+#include "dirsnapshot.h"
+#include "dirstats.h"
+#include "fuzzymatcher.h"
+#include "textfilter.h"
 #include "utils.h"
 
 #ifdef COMPONENT_SYNCING
@@ -31,43 +35,96 @@
 
 #include <QObject>
 #include <QFuture>
+#include <QDateTime>
+#include <QPointer>
 #include <QThread>
 #include <QtConcurrent/QtConcurrentRun>
 #include <QtConcurrent>
 
+#include <algorithm>
+#include <numeric>
+
+static const int MEDIA_PAGE = 500;
+static const int MAX_MERGE_RUNS = 8; // past it, the batch is interleaved with the list and a single reset is cheaper
+
+/**
+ * What a substring filter found, along with the filter it used so the next one can reuse it
+ */
+struct FilterResult {
+    std::shared_ptr<const FMH::TextFilter> filter;
+    QVector<int> rows;
+};
+
+static FMH::MediaCatalogue::TYPE mediaType(const QUrl &path)
+{
+    static const QHash<QString, FMH::MediaCatalogue::TYPE> types = {{"qrc:/widgets/views/Document", FMH::MediaCatalogue::DOCUMENT},
+                                                                    {"qrc:/widgets/views/Picture", FMH::MediaCatalogue::IMAGE},
+                                                                    {"qrc:/widgets/views/Video", FMH::MediaCatalogue::VIDEO},
+                                                                    {"qrc:/widgets/views/Music", FMH::MediaCatalogue::AUDIO}};
+    return types.value(path.toString(), FMH::MediaCatalogue::NONE);
+}
+
 FMList::FMList(QObject *parent)
     : MauiList(parent)
     , fm(new FM(this))
+    , resolver(new FMH::MetadataResolver(this))
 {
     qRegisterMetaType<FMList*>("const FMList*"); //this is needed for QML to know of FMList in the search method
     connect(this->fm, &FM::cloudServerContentReady, [&](const FMH::MODEL_LIST &list, const QUrl &url) {
         if (this->path == url) {
-            this->assignList(list);
+            this->assignList(FMH::toFileList(list));
         }
     });
 
-    connect(this->fm, &FM::pathContentReady, [&](QUrl) {
-        emit this->preListChanged();
-        this->sortList();
+    connect(this->fm, &FM::pathContentReady, [&](QUrl url) {
+        // unless a search or filter took over the list meanwhile
+        if (url == this->path && this->m_listingGeneration == this->m_generation) {
+            this->finishRevalidation();
+            this->storeSnapshot();
+        }
+
+        // the batches are merged sorted as they arrive, so there is nothing left to reset
         this->setStatus({STATUS_CODE::READY, this->list.isEmpty() ? "Nothing here!" : "", this->list.isEmpty() ? "This place seems to be empty" : "", this->list.isEmpty() ? "folder-add" : "", this->list.isEmpty(), true});
-        emit this->postListChanged();
     });
 
-    connect(this->fm, &FM::pathContentItemsChanged, [&](QVector<QPair<FMH::MODEL, FMH::MODEL>> res) {
+    connect(this->fm, &FM::pathContentItemsChanged, [&](QVector<QPair<FMH::FileItem, FMH::FileItem>> res) {
         for (const auto &item : qAsConst(res)) {
-            const auto index = this->indexOf(FMH::MODEL_KEY::PATH, item.first[FMH::MODEL_KEY::PATH]);
+            const auto index = this->indexOfUrl(item.first.url);
 
             if (index >= this->list.size() || index < 0) {
                 return;
             }
 
-            this->list[index] = item.second;
-            emit this->updateModel(index, FMH::modelRoles(item.second));
+            this->setItem(index, item.second);
+            emit this->updateModel(index, item.second.roles());
+        }
+    });
+
+    connect(this->resolver, &FMH::MetadataResolver::resolved, [&](FMH::FILE_LIST items) {
+        QVector<int> indexes;
+        indexes.reserve(items.size());
+        for (const auto &item : qAsConst(items)) {
+            const auto index = this->indexOfUrl(item.url);
+            if (index < 0) {
+                continue;
+            }
+
+            this->setItem(index, item);
+            indexes << index;
         }
+
+        // the visible rows tend to be contiguous
+        this->updateRanges(indexes);
     });
 
     connect(this->fm, &FM::pathContentItemsReady, [&](FMH::PATH_CONTENT res) {
-        if (res.path != this->path) {
+        // a search or filter took over the list, the listing is not what it shows anymore
+        if (res.path != this->path || this->m_listingGeneration != this->m_generation) {
+            return;
+        }
+
+        if (this->m_revalidating) {
+            this->revalidate(res.content);
             return;
         }
 
@@ -84,10 +141,13 @@ FMList::FMList(QObject *parent)
             return;
         }
 
+        QVector<int> indexes;
+        indexes.reserve(res.content.size());
         for (const auto &item : qAsConst(res.content)) {
-            const auto index = this->indexOf(FMH::MODEL_KEY::PATH, item[FMH::MODEL_KEY::PATH]);
-            this->remove(index);
+            indexes << this->indexOfUrl(item.url);
         }
+
+        this->removeItems(indexes);
         this->setStatus({STATUS_CODE::READY, this->list.isEmpty() ? "Nothing here!" : "", this->list.isEmpty() ? "This place seems to be empty" : "", this->list.isEmpty() ? "folder-add" : "", this->list.isEmpty(), true});
     });
 
@@ -106,55 +166,133 @@ FMList::FMList(QObject *parent)
         this->sortList();
     });
 
+    if (const auto catalogue = FMH::MediaCatalogue::instance()) {
+        // a finished crawl may know of files the list is missing
+        connect(catalogue, &FMH::MediaCatalogue::ready, this, [this]() {
+            if (this->pathType == FMList::PATHTYPE::OTHER_PATH && mediaType(this->path) != FMH::MediaCatalogue::NONE) {
+                this->setList();
+            }
+        });
+    }
+
+    if (const auto stats = FMH::DirStats::instance()) {
+        connect(stats, &FMH::DirStats::ready, this, [this](const QString &path, const int &count, const qint64 &size) {
+            const auto index = this->indexOfUrl(QUrl::fromLocalFile(path).toString());
+            if (index < 0 || !this->folderSizes) {
+                return;
+            }
+
+            auto &item = this->list[index];
+            item.count = count;
+            item.size = size;
+            this->updateFilterSource(item);
+            emit this->updateModel(index, {FMH::MODEL_KEY::SIZE, FMH::MODEL_KEY::COUNT});
+        });
+
+        // the folder is measured again once the view asks for it
+        connect(stats, &FMH::DirStats::changed, this, [this](const QString &path) {
+            const auto url = QUrl::fromLocalFile(path).toString();
+            if (!this->m_measured.remove(url)) {
+                return;
+            }
+
+            const auto index = this->indexOfUrl(url);
+            if (index >= 0) {
+                emit this->updateModel(index, {FMH::MODEL_KEY::SIZE, FMH::MODEL_KEY::COUNT});
+            }
+        });
+    }
+
     connect(this->fm, &FM::newItem, [&](const FMH::MODEL &item, const QUrl &url) {
         if (this->path == url) {
+            const auto fileItem = FMH::FileItem::fromModel(item);
+            this->filterAdded({fileItem});
+
             emit this->preItemAppended();
-            this->list << item;
+            this->list << fileItem;
+            if (this->urlIndexValid) {
+                this->urlIndex.insert(this->list.last().url, this->list.size() - 1);
+            }
             emit this->postItemAppended();
         }
     });
 }
 
-void FMList::assignList(const FMH::MODEL_LIST &list)
+FMList::~FMList()
 {
+    // the workers still running give up, and their results are not handed to a list that is gone
+    this->m_token.cancel();
+}
+
+void FMList::assignList(const FMH::FILE_LIST &list)
+{
+    // a new listing, unless it is the filter showing its result
+    if (!this->m_filtering) {
+        this->m_filterStale = true;
+    }
+
     emit this->preListChanged();
     this->list = list;
+    this->urlIndexValid = false;
     this->sortList();
     this->setStatus({STATUS_CODE::READY, this->list.isEmpty() ? "Nothing here!" : "", this->list.isEmpty() ? "This place seems to be empty" : "", this->list.isEmpty() ? "folder-add" : "", this->list.isEmpty(), true});
     emit this->postListChanged();
 }
 
-void FMList::appendToList(const FMH::MODEL_LIST &list)
+void FMList::appendToList(const FMH::FILE_LIST &list)
 {
-    FMH::MODEL_LIST tmpList = list;
+    FMH::FILE_LIST tmpList = list;
     if (this->path.toString() == "trash:/") {
         tmpList.clear();
         foreach (const auto &item, list) {
-            QString hidden = item[FMH::MODEL_KEY::HIDDEN];
-            if (hidden != "true") {
+            if (!item.is(FMH::FileItem::HIDDEN)) {
                 tmpList << item;
             }
         }
     }
-    emit this->preItemsAppended(tmpList.size());
-    this->list << tmpList;
-    emit this->postItemAppended();
+
+    if (tmpList.isEmpty()) {
+        return;
+    }
+
+    this->mergeIntoList(tmpList);
 }
 
 void FMList::clear()
 {
     emit this->preListChanged();
     this->list.clear();
+    this->urlIndex.clear();
+    this->urlIndexValid = true;
+    this->m_filterStale = true;
     emit this->postListChanged();
 }
 
+FMH::CancelToken FMList::newRequest()
+{
+    // the listing of the current path is of no use to what comes next
+    if (this->m_listingGeneration == this->m_generation) {
+        this->cancelRevalidation();
+        this->fm->stopPathContent();
+    }
+
+    this->m_token.cancel();
+    this->m_token = FMH::CancelToken(++this->m_generation);
+    this->m_ranked = false;
+
+    return this->m_token;
+}
+
 void FMList::setList()
 {
+    const auto token = this->newRequest();
+    this->resolver->clear();
+    this->m_measured.clear();
     this->clear();
 
     switch (this->pathType) {
     case FMList::PATHTYPE::TAGS_PATH:
-        this->assignList(FMStatic::getTagContent(this->path.fileName(), QStringList() << this->filters << FMH::FILTER_LIST[static_cast<FMH::FILTER_TYPE>(this->filterType)]));
+        this->assignList(FMH::toFileList(FMStatic::getTagContent(this->path.fileName(), QStringList() << this->filters << FMH::FILTER_LIST[static_cast<FMH::FILTER_TYPE>(this->filterType)])));
         break; // SYNC
 
     case FMList::PATHTYPE::CLOUD_PATH:
@@ -169,108 +307,38 @@ void FMList::setList()
 
             if (pathType == FMList::PATHTYPE::OTHER_PATH) {
                 if (this->path.toString() == "qrc:/widgets/views/Recents") {
-                    this->assignList(FMStatic::getTagContent("recents_jingos"));
+                    this->assignList(FMH::toFileList(FMStatic::getTagContent("recents_jingos")));
                     return;
                 } else if (this->path.toString() == "qrc:/widgets/views/tag0") {
-                    this->assignList(FMStatic::getTagContent("tag0_jingos"));
+                    this->assignList(FMH::toFileList(FMStatic::getTagContent("tag0_jingos")));
                     return;
                 } else if (this->path.toString() == "qrc:/widgets/views/tag1") {
-                    this->assignList(FMStatic::getTagContent("tag1_jingos"));
+                    this->assignList(FMH::toFileList(FMStatic::getTagContent("tag1_jingos")));
                     return;
                 } else if (this->path.toString() == "qrc:/widgets/views/tag2") {
-                    this->assignList(FMStatic::getTagContent("tag2_jingos"));
+                    this->assignList(FMH::toFileList(FMStatic::getTagContent("tag2_jingos")));
                     return;
                 } else if (this->path.toString() == "qrc:/widgets/views/tag3") {
-                    this->assignList(FMStatic::getTagContent("tag3_jingos"));
+                    this->assignList(FMH::toFileList(FMStatic::getTagContent("tag3_jingos")));
                     return;
                 } else if (this->path.toString() == "qrc:/widgets/views/tag4") {
-                    this->assignList(FMStatic::getTagContent("tag4_jingos"));
+                    this->assignList(FMH::toFileList(FMStatic::getTagContent("tag4_jingos")));
                     return;
                 } else if (this->path.toString() == "qrc:/widgets/views/tag5") {
-                    this->assignList(FMStatic::getTagContent("tag5_jingos"));
+                    this->assignList(FMH::toFileList(FMStatic::getTagContent("tag5_jingos")));
                     return;
                 } else if (this->path.toString() == "qrc:/widgets/views/tag6") {
-                    this->assignList(FMStatic::getTagContent("tag6_jingos"));
+                    this->assignList(FMH::toFileList(FMStatic::getTagContent("tag6_jingos")));
                     return;
                 } else if (this->path.toString() == "qrc:/widgets/views/tag7") {
-                    this->assignList(FMStatic::getTagContent("tag7_jingos"));
+                    this->assignList(FMH::toFileList(FMStatic::getTagContent("tag7_jingos")));
                     return;
                 }
 
-                QFutureWatcher<QString> *watcher = new QFutureWatcher<QString>;
-                connect(watcher, &QFutureWatcher<QString>::finished, [&, watcher]() {
-                    watcher->deleteLater();
-                });
-
-                const auto func = [=]() -> QString {
-                    const QString currentCustomPath = this->path.toString();
-                    QStringList typeFilterList;
-                    if (this->path.toString() == "qrc:/widgets/views/Document")
-                    {
-                        typeFilterList << "type:document";
-                    } else if (this->path.toString() == "qrc:/widgets/views/Picture")
-                    {
-                        typeFilterList << "type:image";
-                    } else if (this->path.toString() == "qrc:/widgets/views/Video")
-                    {
-                        typeFilterList << "type:video";
-                    } else if (this->path.toString() == "qrc:/widgets/views/Music")
-                    {
-                        typeFilterList << "type:audio";
-                    }
-                    QProcess balooProcess;
-                    balooProcess.start("baloosearch", typeFilterList);
-                    if (!balooProcess.waitForStarted())
-                    {
-                        return "0";
-                    }
-                    balooProcess.closeWriteChannel();
-                    if (!balooProcess.waitForFinished())
-                    {
-                        return "0";
-                    }
-                    QByteArray bateArray = balooProcess.readAll();
-                    QString result = QString(bateArray);
-                    QStringList pathList = result.split(QLatin1Char('\n'), Qt::SkipEmptyParts);//以“\n”为间隔，分割返回的数据
-                    int count = 0;
-                    FMH::MODEL_LIST currentList;
-                    foreach (const QString &path, pathList)
-                    {
-                        QFile typeFile(path);
-                        if (!typeFile.exists()) {
-                            continue;
-                        }
-                        FMH::MODEL model = FMH::getFileInfoModel(QUrl("file://" + path));
-                        currentList << model;
-                        if (this->path.toString() == currentCustomPath) {
-                            this->list << model;
-                            count++;
-                            if (count > 200) {
-                                emit this->preListChanged();
-                                this->setStatus({STATUS_CODE::READY, this->list.isEmpty() ? "Nothing here!" : "", this->list.isEmpty() ? "This place seems to be empty" : "", this->list.isEmpty() ? "folder-add" : "", this->list.isEmpty(), true});
-                                emit this->postListChanged();
-                                count = 0;
-                            }
-                        } else {
-                            break;
-                        }
-                    }
-                    FMH::MODEL_LIST sortLists = this->sortList(currentList);
-                    if (this->path.toString() == currentCustomPath)
-                    {
-                        emit this->preListChanged();
-                        list = sortLists;
-                        this->setStatus({STATUS_CODE::READY, this->list.isEmpty() ? "Nothing here!" : "", this->list.isEmpty() ? "This place seems to be empty" : "", this->list.isEmpty() ? "folder-add" : "", this->list.isEmpty(), true});
-                        emit this->postListChanged();
-                        return currentCustomPath;
-                    } else
-                    {
-                        return "-1";
-                    }
-                };
-                QFuture<QString> t1 = QtConcurrent::run(func);
-                watcher->setFuture(t1);
+                this->loadMedia(mediaType(this->path), token);
             } else {
+                this->m_listingGeneration = token.generation();
+                this->loadSnapshot();
                 this->fm->getPathContent(this->path, this->hidden, this->onlyDirs, QStringList() << this->filters << FMH::FILTER_LIST[static_cast<FMH::FILTER_TYPE>(this->filterType)]);
             }
         }
@@ -279,6 +347,186 @@ void FMList::setList()
     }
 }
 
+void FMList::loadMedia(const FMH::MediaCatalogue::TYPE &type, const FMH::CancelToken &token)
+{
+    const auto catalogue = FMH::MediaCatalogue::instance();
+    if (type == FMH::MediaCatalogue::NONE || !catalogue) {
+        this->setStatus({STATUS_CODE::READY, "Nothing here!", "This place seems to be empty", "folder-add", true, true});
+        return;
+    }
+
+    this->setStatus({STATUS_CODE::LOADING, "", "", "", false, true});
+    catalogue->activate();
+
+    FMH::MODEL_KEY key;
+    Qt::SortOrder order;
+    bool foldersFirst;
+    this->sortParams(key, order, foldersFirst);
+
+    const QPointer<FMList> self(this);
+    QtConcurrent::run([self, catalogue, type, key, order, token]() {
+        // the pages already come in the order of the list, so merging them in only appends
+        for (int offset = 0; !token.isCancelled(); offset += MEDIA_PAGE) {
+            const auto page = catalogue->items(type, key, order, offset, MEDIA_PAGE);
+            if (!page.isEmpty() && self) {
+                QMetaObject::invokeMethod(self, [self, token, page]() {
+                    if (self && !token.isCancelled()) {
+                        self->mergeIntoList(page);
+                    }
+                }, Qt::QueuedConnection);
+            }
+
+            if (page.size() < MEDIA_PAGE) {
+                break;
+            }
+        }
+
+        if (!self) {
+            return;
+        }
+
+        QMetaObject::invokeMethod(self, [self, token]() {
+            if (!self || token.isCancelled()) {
+                return;
+            }
+
+            self->setStatus({STATUS_CODE::READY, self->list.isEmpty() ? "Nothing here!" : "", self->list.isEmpty() ? "This place seems to be empty" : "", self->list.isEmpty() ? "folder-add" : "", self->list.isEmpty(), true});
+        }, Qt::QueuedConnection);
+    });
+}
+
+bool FMList::usesSnapshots() const
+{
+    return this->pathType == FMList::PATHTYPE::PLACES_PATH && this->path.isLocalFile();
+}
+
+QString FMList::snapshotOptions() const
+{
+    return QStringList {QString::number(this->hidden), QString::number(this->onlyDirs), QString::number(this->filterType), this->filters.join(QLatin1Char(' '))}.join(QLatin1Char('|'));
+}
+
+void FMList::loadSnapshot()
+{
+    if (!this->usesSnapshots()) {
+        return;
+    }
+
+    FMH::FILE_LIST items;
+    bool fresh = false;
+    if (!FMH::DirSnapshot::load(this->path, this->snapshotOptions(), items, &fresh) || items.isEmpty()) {
+        return;
+    }
+
+    // shown right away, the listing that follows only applies what changed since
+    this->assignList(items);
+    this->m_revalidating = true;
+
+    if (!fresh) {
+        this->setStatus({STATUS_CODE::LOADING, "", "", "", false, true});
+    }
+}
+
+void FMList::storeSnapshot()
+{
+    if (!this->usesSnapshots()) {
+        return;
+    }
+
+    const auto url = this->path;
+    const auto options = this->snapshotOptions();
+    const auto items = this->list;
+
+    QtConcurrent::run([url, options, items]() {
+        if (items.isEmpty()) {
+            FMH::DirSnapshot::remove(url, options);
+        } else {
+            FMH::DirSnapshot::store(url, options, items);
+        }
+    });
+}
+
+void FMList::revalidate(const FMH::FILE_LIST &items)
+{
+    FMH::FILE_LIST added;
+    QVector<int> indexes;
+    for (const auto &item : items) {
+        this->m_seen.insert(item.url);
+
+        const auto index = this->indexOfUrl(item.url);
+        if (index < 0) {
+            added << item;
+            continue;
+        }
+
+        const auto &current = this->list.at(index);
+
+        // a lazy listing leaves the deferred fields unset, and the measured folders got their size from DirStats
+        const auto partial = item.is(FMH::FileItem::PARTIAL) || current.is(FMH::FileItem::PARTIAL);
+        const auto measured = this->folderSizes && item.is(FMH::FileItem::IS_DIR);
+        const quint16 mask = ~quint16(FMH::FileItem::PARTIAL);
+
+        if (current.modified == item.modified && current.label == item.label && (current.flags & mask) == (item.flags & mask)
+            && (measured || current.size == item.size) && (measured || partial || current.count == item.count)) {
+            continue;
+        }
+
+        auto updated = item;
+
+        // what was already resolved is kept, the resolver does not ask twice for the same item
+        if (item.is(FMH::FileItem::PARTIAL) && !current.is(FMH::FileItem::PARTIAL)) {
+            updated.mime = current.mime;
+            updated.icon = current.icon;
+            updated.thumbnail = current.thumbnail;
+            updated.symlink = current.symlink;
+            updated.count = current.count;
+            updated.setFlag(FMH::FileItem::PARTIAL, false);
+        }
+
+        if (measured) {
+            updated.size = current.size;
+            updated.count = current.count;
+        }
+
+        this->setItem(index, updated);
+        indexes << index;
+    }
+
+    this->updateRanges(indexes);
+    this->appendToList(added);
+}
+
+void FMList::cancelRevalidation()
+{
+    if (!this->m_revalidating) {
+        return;
+    }
+
+    // the rest of the listing is dropped, so nothing it reports is merged twice. The snapshot file is left as it is,
+    // unchecked, and the next visit checks it again
+    this->fm->stopPathContent();
+    this->m_revalidating = false;
+    this->m_seen.clear();
+}
+
+void FMList::finishRevalidation()
+{
+    if (!this->m_revalidating) {
+        return;
+    }
+
+    // whatever the listing did not report is gone since the snapshot was taken
+    QVector<int> indexes;
+    for (int i = 0; i < this->list.size(); i++) {
+        if (!this->m_seen.contains(this->list.at(i).url)) {
+            indexes << i;
+        }
+    }
+
+    this->m_revalidating = false;
+    this->m_seen.clear();
+    this->removeItems(indexes);
+}
+
 void FMList::reset()
 {
     this->setList();
@@ -286,7 +534,61 @@ void FMList::reset()
 
 const FMH::MODEL_LIST &FMList::items() const
 {
-    return this->list;
+    this->modelList = FMH::toModelList(this->list);
+    return this->modelList;
+}
+
+/**
+ * Keys that the lazy listing leaves unset or only guesses
+ */
+static inline bool isDeferredKey(const FMH::MODEL_KEY &key)
+{
+    switch (key) {
+    case FMH::MODEL_KEY::MIME:
+    case FMH::MODEL_KEY::ICON:
+    case FMH::MODEL_KEY::THUMBNAIL:
+    case FMH::MODEL_KEY::SYMLINK:
+    case FMH::MODEL_KEY::COUNT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int FMList::itemsCount() const
+{
+    return this->list.size();
+}
+
+FMH::MODEL FMList::itemAt(const int &index) const
+{
+    return this->list.at(index).toModel();
+}
+
+QString FMList::itemValue(const int &index, const FMH::MODEL_KEY &key) const
+{
+    return this->list.at(index).value(key);
+}
+
+QVariant FMList::itemData(const int &index, const FMH::MODEL_KEY &key) const
+{
+    const auto &item = this->list.at(index);
+
+    // the view is showing the item, so it is time to read what the lazy listing skipped
+    if (item.is(FMH::FileItem::PARTIAL) && isDeferredKey(key)) {
+        this->resolver->request(item.url);
+    }
+
+    if (this->folderSizes && (key == FMH::MODEL_KEY::SIZE || key == FMH::MODEL_KEY::COUNT) && item.is(FMH::FileItem::IS_DIR) && !this->m_measured.contains(item.url)) {
+        const QUrl url(item.url);
+        const auto stats = FMH::DirStats::instance();
+        if (url.isLocalFile() && stats) {
+            this->m_measured.insert(item.url);
+            stats->request(url.toLocalFile());
+        }
+    }
+
+    return item.data(key);
 }
 
 FMList::SORTBY FMList::getSortBy() const
@@ -303,6 +605,7 @@ void FMList::setSortBy(const FMList::SORTBY &key)
     emit this->preListChanged();
 
     this->sort = key;
+    this->m_ranked = false;
     this->sortList();
 
     emit this->sortByChanged();
@@ -322,493 +625,340 @@ void FMList::setSortOrder(const Qt::SortOrder &sortOrder)   //add by hjy
 
     emit this->preListChanged();
     this->m_sortOrder = sortOrder;
+    this->m_ranked = false;
     this->sortList();
     emit this->sortOrderChanged();
     emit this->postListChanged();
 }
 
-FMH::MODEL_LIST FMList::sortList(FMH::MODEL_LIST currentList)
-{
-    const FMH::MODEL_KEY key = static_cast<FMH::MODEL_KEY>(this->sort);
-    auto index = 0;
-    Qt::SortOrder sortOrder = this->m_sortOrder;
-    std::sort(currentList.begin() + index, currentList.end(), [key, sortOrder](const FMH::MODEL &e1, const FMH::MODEL &e2) -> bool {
-        switch (key)
-        {
-        case FMH::MODEL_KEY::MIME: {
-            auto str1 = QString(e1.value(key)).toLower();
-            auto str2 = QString(e2.value(key)).toLower();
-            auto indexE1 = str1.indexOf("/");
-            auto indexE2 = str2.indexOf("/");
-            if (indexE1 != -1) {
-                str1 = str1.mid(0, indexE1);
-            }
+/**
+ * Sorting key of a single entry, computed once before sorting so the comparisons do not
+ * need to fold labels, split mimetypes or parse dates over and over again.
+ */
+struct SortEntry {
+    QString label; // case folded label, used as tie breaker
+    QString text; // mimetype major type or the raw value for keys without a native field
+    qint64 number = 0; // size, epoch time, tag rank or search rank
+    qint64 recency = 0; // modification time, breaks the ties between search ranks
+    int index = 0; // position in the unsorted list
+};
+
+static SortEntry sortEntry(const FMH::FileItem &item, const FMH::MODEL_KEY &key, const qint64 &now, const int &index)
+{
+    SortEntry entry;
+    entry.index = index;
+    entry.label = item.label.toLower();
+
+    switch (key) {
+    case FMH::MODEL_KEY::MIME: {
+        const auto slash = item.mime.indexOf(QLatin1Char('/'));
+        entry.text = (slash != -1 ? item.mime.left(slash) : item.mime).toLower();
+        break;
+    }
+    case FMH::MODEL_KEY::SIZE:
+        entry.number = item.size;
+        break;
+    case FMH::MODEL_KEY::MODIFIED:
+    case FMH::MODEL_KEY::DATE: {
+        // unknown dates used to compare as the current time
+        const auto secs = key == FMH::MODEL_KEY::MODIFIED ? item.modified : item.created;
+        entry.number = secs > 0 ? secs : now;
+        break;
+    }
+    case FMH::MODEL_KEY::LABEL:
+        break;
+    case FMH::MODEL_KEY::PLACE:
+        entry.number = FMStatic::urlColorTag(item.url);
+        break;
+    case FMH::MODEL_KEY::SCORE:
+        entry.number = item.value(key).toInt();
+        entry.recency = item.modified;
+        break;
+    default:
+        entry.text = item.value(key);
+        break;
+    }
 
-            if (indexE2 != -1) {
-                str2 = str2.mid(0, indexE2);
-            }
+    return entry;
+}
 
-            if (sortOrder == Qt::AscendingOrder) {
-                if (str1 < str2) {
-                    return true;
-                } else if (str1 == str2) {
-                    const auto str1 = QString(e1.value(FMH::MODEL_KEY::LABEL)).toLower();
-                    const auto str2 = QString(e2.value(FMH::MODEL_KEY::LABEL)).toLower();
-                    if (str1 < str2) {
-                        return true;
-                    }
-                }
-            } else {
-                if (str1 > str2) {
-                    return true;
-                } else if (str1 == str2) {
-                    const auto str1 = QString(e1.value(FMH::MODEL_KEY::LABEL)).toLower();
-                    const auto str2 = QString(e2.value(FMH::MODEL_KEY::LABEL)).toLower();
-                    if (str1 > str2) {
-                        return true;
-                    }
-                }
-            }
-            break;
+// returns a negative number when e1 goes before e2 in ascending order
+static int compareEntries(const SortEntry &e1, const SortEntry &e2, const FMH::MODEL_KEY &key)
+{
+    switch (key) {
+    case FMH::MODEL_KEY::MIME: {
+        const auto res = e1.text.compare(e2.text);
+        return res != 0 ? res : e1.label.compare(e2.label);
+    }
+    case FMH::MODEL_KEY::SIZE:
+    case FMH::MODEL_KEY::MODIFIED:
+    case FMH::MODEL_KEY::DATE:
+        if (e1.number != e2.number) {
+            return e1.number < e2.number ? -1 : 1;
         }
-        case FMH::MODEL_KEY::SIZE: {
-            if (sortOrder == Qt::AscendingOrder) {
-                if (e1[key].toDouble() < e2[key].toDouble()) {
-                    return true;
-                } else if (e1[key].toDouble() == e2[key].toDouble()) {
-                    const auto str1 = QString(e1.value(FMH::MODEL_KEY::LABEL)).toLower();
-                    const auto str2 = QString(e2.value(FMH::MODEL_KEY::LABEL)).toLower();
-                    if (str1 < str2) {
-                        return true;
-                    }
-                }
-            } else {
-                if (e1[key].toDouble() > e2[key].toDouble()) {
-                    return true;
-                } else if (e1[key].toDouble() == e2[key].toDouble()) {
-                    const auto str1 = QString(e1[FMH::MODEL_KEY::LABEL]).toLower();
-                    const auto str2 = QString(e2[FMH::MODEL_KEY::LABEL]).toLower();
-                    if (str1 > str2) {
-                        return true;
-                    }
-                }
-            }
-            break;
+        return e1.label.compare(e2.label);
+    case FMH::MODEL_KEY::PLACE: // tagged items go first
+        if (e1.number != e2.number) {
+            return e1.number > e2.number ? -1 : 1;
         }
-
-        case FMH::MODEL_KEY::MODIFIED:
-        case FMH::MODEL_KEY::DATE: {
-            auto currentTime = QDateTime::currentDateTime();
-
-            auto date1 = QDateTime::fromString(e1[key], Qt::TextDate);
-            auto date2 = QDateTime::fromString(e2[key], Qt::TextDate);
-
-            if (sortOrder == Qt::AscendingOrder) {
-                if (date1.secsTo(currentTime) > date2.secsTo(currentTime)) {
-                    return true;
-                } else if (date1.secsTo(currentTime) == date2.secsTo(currentTime)) {
-                    const auto str1 = QString(e1[FMH::MODEL_KEY::LABEL]).toLower();
-                    const auto str2 = QString(e2[FMH::MODEL_KEY::LABEL]).toLower();
-                    if (str1 < str2) {
-                        return true;
-                    }
-                }
-            } else {
-                if (date1.secsTo(currentTime) < date2.secsTo(currentTime)) {
-                    return true;
-                } else if (date1.secsTo(currentTime) == date2.secsTo(currentTime)) {
-                    const auto str1 = QString(e1[FMH::MODEL_KEY::LABEL]).toLower();
-                    const auto str2 = QString(e2[FMH::MODEL_KEY::LABEL]).toLower();
-                    if (str1 > str2) {
-                        return true;
-                    }
-                }
-            }
-
-            break;
+        return e1.label.compare(e2.label);
+    case FMH::MODEL_KEY::SCORE: // best matches first, then the most recent ones
+        if (e1.number != e2.number) {
+            return e1.number < e2.number ? -1 : 1;
         }
-
-        case FMH::MODEL_KEY::LABEL: {
-            const auto str1 = QString(e1[key]).toLower();
-            const auto str2 = QString(e2[key]).toLower();
-
-            if (sortOrder == Qt::AscendingOrder) {
-                if (str1 < str2) {
-                    return true;
-                }
-            } else {
-                if (str1 > str2) {
-                    return true;
-                }
-            }
-            break;
+        if (e1.recency != e2.recency) {
+            return e1.recency > e2.recency ? -1 : 1;
         }
+        return e1.label.compare(e2.label);
+    case FMH::MODEL_KEY::LABEL:
+        return e1.label.compare(e2.label);
+    default:
+        return e1.text.compare(e2.text);
+    }
+}
 
-        case FMH::MODEL_KEY::PLACE: {
-            int e1TagIndex = -1;
-            int e2TagIndex = -1;
-            for (int m = 0; m < 8; m++) {
-                QString tag = "tag" + QString::number(m) + "_jingos";
-                if (FMStatic::urlTagExists(e1[FMH::MODEL_KEY::PATH], tag)) {
-                    e1TagIndex = m;
-                }
-                if (FMStatic::urlTagExists(e2[FMH::MODEL_KEY::PATH], tag)) {
-                    e2TagIndex = m;
-                }
-            }
-            if (sortOrder == Qt::AscendingOrder) {
-                if (e1TagIndex > e2TagIndex) {
-                    return true;
-                } else if (e1TagIndex == e2TagIndex) {
-                    const auto str1 = QString(e1[FMH::MODEL_KEY::LABEL]).toLower();
-                    const auto str2 = QString(e2[FMH::MODEL_KEY::LABEL]).toLower();
-                    if (str1 < str2) {
-                        return true;
-                    }
-                }
-            } else {
-                if (e1TagIndex < e2TagIndex) {
-                    return true;
-                } else if (e1TagIndex == e2TagIndex) {
-                    const auto str1 = QString(e1[FMH::MODEL_KEY::LABEL]).toLower();
-                    const auto str2 = QString(e2[FMH::MODEL_KEY::LABEL]).toLower();
-                    if (str1 > str2) {
-                        return true;
-                    }
-                }
-            }
-            break;
-        }
+static inline bool isFolder(const FMH::FileItem &item)
+{
+    return item.mime == QStringLiteral("inode/directory");
+}
 
-        default: {
-            if (sortOrder == Qt::AscendingOrder) {
-                if (e1[key] < e2[key]) {
-                    return true;
-                }
-            } else {
-                if (e1[key] > e2[key]) {
-                    return true;
-                }
-            }
-        }
+static void sortEntries(QVector<SortEntry>::iterator begin, QVector<SortEntry>::iterator end, const FMH::MODEL_KEY &key, const Qt::SortOrder &sortOrder)
+{
+    const bool ascending = sortOrder == Qt::AscendingOrder;
+    std::sort(begin, end, [key, ascending](const SortEntry &e1, const SortEntry &e2) -> bool {
+        const auto res = compareEntries(e1, e2, key);
+        if (res != 0) {
+            return ascending ? res < 0 : res > 0;
         }
 
-        return false;
+        return e1.index < e2.index;
     });
-    return currentList;
 }
-void FMList::sortList()
+
+static void sortItems(FMH::FILE_LIST &list, const FMH::MODEL_KEY &key, const Qt::SortOrder &sortOrder, const bool &foldersFirst)
 {
-    const FMH::MODEL_KEY key = static_cast<FMH::MODEL_KEY>(this->sort);
-    auto index = 0;
-    Qt::SortOrder sortOrder = this->m_sortOrder;
+    if (list.size() < 2) {
+        return;
+    }
 
-    if (this->foldersFirst) {
-        qSort(this->list.begin(), this->list.end(), [](const FMH::MODEL &e1, const FMH::MODEL &e2) -> bool {
-            Q_UNUSED(e2)
-            const auto key = FMH::MODEL_KEY::MIME;
-            return e1[key] == "inode/directory";
+    const auto now = QDateTime::currentSecsSinceEpoch();
+
+    QVector<SortEntry> entries;
+    entries.reserve(list.size());
+    for (auto i = 0; i < list.size(); i++) {
+        entries << sortEntry(list.at(i), key, now, i);
+    }
+
+    auto filesBegin = entries.begin();
+    if (foldersFirst) {
+        filesBegin = std::stable_partition(entries.begin(), entries.end(), [&list](const SortEntry &entry) -> bool {
+            return isFolder(list.at(entry.index));
         });
+        sortEntries(entries.begin(), filesBegin, key, sortOrder);
+    }
 
-        for (const auto &item : qAsConst(this->list)) {
-            if (item[FMH::MODEL_KEY::MIME] == "inode/directory") {
-                index++;
-            } else {
-                break;
+    sortEntries(filesBegin, entries.end(), key, sortOrder);
+
+    FMH::FILE_LIST res;
+    res.reserve(list.size());
+    for (const auto &entry : qAsConst(entries)) {
+        res << std::move(list[entry.index]);
+    }
+
+    list = std::move(res);
+}
+
+/**
+ * Finds where each item of the already sorted batch should be inserted in the sorted list.
+ * The positions refer to the list before any insertion and never decrease.
+ */
+static QVector<int> mergePositions(const FMH::FILE_LIST &list, const FMH::FILE_LIST &batch, const FMH::MODEL_KEY &key, const Qt::SortOrder &sortOrder, const bool &foldersFirst)
+{
+    const bool ascending = sortOrder == Qt::AscendingOrder;
+    const auto now = QDateTime::currentSecsSinceEpoch();
+
+    // true if the listed item does not go after the new entry, so equal items keep the order in which they arrived
+    const auto notAfter = [&](const FMH::FileItem &item, const SortEntry &entry, const bool &folder) -> bool {
+        if (foldersFirst) {
+            const auto itemFolder = isFolder(item);
+            if (itemFolder != folder) {
+                return itemFolder;
             }
         }
-        std::sort(this->list.begin(), this->list.begin() + index, [&key, &sortOrder](const FMH::MODEL &e1, const FMH::MODEL &e2) -> bool { //先给文件夹排序
-            switch (key)
-            {
-            case FMH::MODEL_KEY::SIZE: {
-                if (sortOrder == Qt::AscendingOrder) {
-                    if (e1[key].toDouble() < e2[key].toDouble()) {
-                        return true;
-                    } else if (e1[key].toDouble() == e2[key].toDouble()) {
-                        const auto str1 = QString(e1[FMH::MODEL_KEY::LABEL]).toLower();
-                        const auto str2 = QString(e2[FMH::MODEL_KEY::LABEL]).toLower();
-                        if (str1 < str2) {
-                            return true;
-                        }
-                    }
-                } else {
-                    if (e1[key].toDouble() > e2[key].toDouble()) {
-                        return true;
-                    } else if (e1[key].toDouble() == e2[key].toDouble()) {
-                        const auto str1 = QString(e1[FMH::MODEL_KEY::LABEL]).toLower();
-                        const auto str2 = QString(e2[FMH::MODEL_KEY::LABEL]).toLower();
-                        if (str1 > str2) {
-                            return true;
-                        }
-                    }
-                }
-                break;
-            }
 
-            case FMH::MODEL_KEY::MODIFIED:
-            case FMH::MODEL_KEY::DATE: {
-                auto currentTime = QDateTime::currentDateTime();
-
-                auto date1 = QDateTime::fromString(e1[key], Qt::TextDate);
-                auto date2 = QDateTime::fromString(e2[key], Qt::TextDate);
-
-                if (sortOrder == Qt::AscendingOrder) {
-                    if (date1.secsTo(currentTime) > date2.secsTo(currentTime)) {
-                        return true;
-                    } else if (date1.secsTo(currentTime) == date2.secsTo(currentTime)) {
-                        const auto str1 = QString(e1[FMH::MODEL_KEY::LABEL]).toLower();
-                        const auto str2 = QString(e2[FMH::MODEL_KEY::LABEL]).toLower();
-                        if (str1 < str2) {
-                            return true;
-                        }
-                    }
-                } else {
-                    if (date1.secsTo(currentTime) < date2.secsTo(currentTime)) {
-                        return true;
-                    } else if (date1.secsTo(currentTime) == date2.secsTo(currentTime)) {
-                        const auto str1 = QString(e1[FMH::MODEL_KEY::LABEL]).toLower();
-                        const auto str2 = QString(e2[FMH::MODEL_KEY::LABEL]).toLower();
-                        if (str1 > str2) {
-                            return true;
-                        }
-                    }
-                }
-                break;
+        const auto res = compareEntries(sortEntry(item, key, now, 0), entry, key);
+        return ascending ? res <= 0 : res >= 0;
+    };
+
+    QVector<int> res;
+    res.reserve(batch.size());
+
+    int lower = 0;
+    for (const auto &batchItem : batch) {
+        const auto entry = sortEntry(batchItem, key, now, 0);
+        const auto folder = isFolder(batchItem);
+
+        int first = lower;
+        int count = list.size() - lower;
+        while (count > 0) {
+            const int step = count / 2;
+            const int middle = first + step;
+            if (notAfter(list.at(middle), entry, folder)) {
+                first = middle + 1;
+                count -= step + 1;
+            } else {
+                count = step;
             }
+        }
 
-            case FMH::MODEL_KEY::LABEL: {
-                const auto str1 = QString(e1[key]).toLower();
-                const auto str2 = QString(e2[key]).toLower();
+        res << first;
+        lower = first;
+    }
 
-                if (sortOrder == Qt::AscendingOrder) {
-                    if (str1 < str2) {
-                        return true;
-                    }
-                } else {
-                    if (str1 > str2) {
-                        return true;
-                    }
-                }
-                break;
-            }
+    return res;
+}
 
-            case FMH::MODEL_KEY::PLACE: {
-                int e1TagIndex = -1;
-                int e2TagIndex = -1;
-                for (int m = 0; m < 8; m++) {
-                    QString tag = "tag" + QString::number(m) + "_jingos";
-                    if (FMStatic::urlTagExists(e1[FMH::MODEL_KEY::PATH], tag)) {
-                        e1TagIndex = m;
-                    }
-                    if (FMStatic::urlTagExists(e2[FMH::MODEL_KEY::PATH], tag)) {
-                        e2TagIndex = m;
-                    }
-                }
-                if (sortOrder == Qt::AscendingOrder) {
-                    if (e1TagIndex > e2TagIndex) {
-                        return true;
-                    } else if (e1TagIndex == e2TagIndex) {
-                        const auto str1 = QString(e1[FMH::MODEL_KEY::LABEL]).toLower();
-                        const auto str2 = QString(e2[FMH::MODEL_KEY::LABEL]).toLower();
-                        if (str1 < str2) {
-                            return true;
-                        }
-                    }
-                } else {
-                    if (e1TagIndex < e2TagIndex) {
-                        return true;
-                    } else if (e1TagIndex == e2TagIndex) {
-                        const auto str1 = QString(e1[FMH::MODEL_KEY::LABEL]).toLower();
-                        const auto str2 = QString(e2[FMH::MODEL_KEY::LABEL]).toLower();
-                        if (str1 > str2) {
-                            return true;
-                        }
-                    }
-                }
-                break;
-            }
+FMH::FILE_LIST FMList::sortList(FMH::FILE_LIST currentList)
+{
+    sortItems(currentList, static_cast<FMH::MODEL_KEY>(this->sort), this->m_sortOrder, false);
+    return currentList;
+}
 
-            default: {
-                if (sortOrder == Qt::AscendingOrder) {
-                    if (e1[key] < e2[key]) {
-                        return true;
-                    }
-                } else {
-                    if (e1[key] > e2[key]) {
-                        return true;
-                    }
-                }
-            }
+void FMList::sortParams(FMH::MODEL_KEY &key, Qt::SortOrder &order, bool &foldersFirst) const
+{
+    // search results keep their ranking until another order is picked
+    if (this->m_ranked) {
+        key = FMH::MODEL_KEY::SCORE;
+        order = Qt::AscendingOrder;
+        foldersFirst = false;
+        return;
+    }
 
-            }
+    key = static_cast<FMH::MODEL_KEY>(this->sort);
+    order = this->m_sortOrder;
+    foldersFirst = this->foldersFirst;
+}
 
-            return false;
-        });
+void FMList::sortList()
+{
+    FMH::MODEL_KEY key;
+    Qt::SortOrder order;
+    bool foldersFirst;
+    this->sortParams(key, order, foldersFirst);
+
+    sortItems(this->list, key, order, foldersFirst);
+
+    // the same urls, only their rows changed
+    this->reindex(0, this->list.size());
+
+    // the rows the filter picks must come in the new order
+    if (!this->m_filtering) {
+        this->m_filterResort = true;
     }
+}
 
-    std::sort(this->list.begin() + index, this->list.end(), [key, sortOrder](const FMH::MODEL &e1, const FMH::MODEL &e2) -> bool { //给文件排序
-        switch (key)
-        {
-        case FMH::MODEL_KEY::MIME: {
-            auto str1 = QString(e1.value(key)).toLower();
-            auto str2 = QString(e2.value(key)).toLower();
-            auto indexE1 = str1.indexOf("/");
-            auto indexE2 = str2.indexOf("/");
-            if (indexE1 != -1) {
-                str1 = str1.mid(0, indexE1);
-            }
+void FMList::mergeIntoList(FMH::FILE_LIST items)
+{
+    if (items.isEmpty()) {
+        return;
+    }
 
-            if (indexE2 != -1) {
-                str2 = str2.mid(0, indexE2);
-            }
+    this->filterAdded(items);
 
-            if (sortOrder == Qt::AscendingOrder) {
-                if (str1 < str2) {
-                    return true;
-                } else if (str1 == str2) {
-                    const auto str1 = QString(e1.value(FMH::MODEL_KEY::LABEL)).toLower();
-                    const auto str2 = QString(e2.value(FMH::MODEL_KEY::LABEL)).toLower();
-                    if (str1 < str2) {
-                        return true;
-                    }
-                }
-            } else {
-                if (str1 > str2) {
-                    return true;
-                } else if (str1 == str2) {
-                    const auto str1 = QString(e1.value(FMH::MODEL_KEY::LABEL)).toLower();
-                    const auto str2 = QString(e2.value(FMH::MODEL_KEY::LABEL)).toLower();
-                    if (str1 > str2) {
-                        return true;
-                    }
-                }
-            }
-            break;
-        }
-        case FMH::MODEL_KEY::SIZE: {
-            if (sortOrder == Qt::AscendingOrder) {
-                if (e1[key].toDouble() < e2[key].toDouble()) {
-                    return true;
-                } else if (e1[key].toDouble() == e2[key].toDouble()) {
-                    const auto str1 = QString(e1.value(FMH::MODEL_KEY::LABEL)).toLower();
-                    const auto str2 = QString(e2.value(FMH::MODEL_KEY::LABEL)).toLower();
-                    if (str1 < str2) {
-                        return true;
-                    }
-                }
-            } else {
-                if (e1[key].toDouble() > e2[key].toDouble()) {
-                    return true;
-                } else if (e1[key].toDouble() == e2[key].toDouble()) {
-                    const auto str1 = QString(e1[FMH::MODEL_KEY::LABEL]).toLower();
-                    const auto str2 = QString(e2[FMH::MODEL_KEY::LABEL]).toLower();
-                    if (str1 > str2) {
-                        return true;
-                    }
-                }
-            }
-            break;
-        }
+    FMH::MODEL_KEY key;
+    Qt::SortOrder order;
+    bool foldersFirst;
+    this->sortParams(key, order, foldersFirst);
 
-        case FMH::MODEL_KEY::MODIFIED:
-        case FMH::MODEL_KEY::DATE: {
-            auto currentTime = QDateTime::currentDateTime();
-
-            auto date1 = QDateTime::fromString(e1[key], Qt::TextDate);
-            auto date2 = QDateTime::fromString(e2[key], Qt::TextDate);
-
-            if (sortOrder == Qt::AscendingOrder) {
-                if (date1.secsTo(currentTime) > date2.secsTo(currentTime)) {
-                    return true;
-                } else if (date1.secsTo(currentTime) == date2.secsTo(currentTime)) {
-                    const auto str1 = QString(e1[FMH::MODEL_KEY::LABEL]).toLower();
-                    const auto str2 = QString(e2[FMH::MODEL_KEY::LABEL]).toLower();
-                    if (str1 < str2) {
-                        return true;
-                    }
-                }
-            } else {
-                if (date1.secsTo(currentTime) < date2.secsTo(currentTime)) {
-                    return true;
-                } else if (date1.secsTo(currentTime) == date2.secsTo(currentTime)) {
-                    const auto str1 = QString(e1[FMH::MODEL_KEY::LABEL]).toLower();
-                    const auto str2 = QString(e2[FMH::MODEL_KEY::LABEL]).toLower();
-                    if (str1 > str2) {
-                        return true;
-                    }
-                }
-            }
+    sortItems(items, key, order, foldersFirst);
 
-            break;
-        }
+    const auto positions = mergePositions(this->list, items, key, order, foldersFirst);
 
-        case FMH::MODEL_KEY::LABEL: {
-            const auto str1 = QString(e1[key]).toLower();
-            const auto str2 = QString(e2[key]).toLower();
+    if (positions.first() == this->list.size()) {
+        emit this->preItemsAppended(items.size());
+        const auto first = this->list.size();
+        this->list << items;
+        this->reindex(first, this->list.size());
+        emit this->postItemAppended();
+        return;
+    }
 
-            if (sortOrder == Qt::AscendingOrder) {
-                if (str1 < str2) {
-                    return true;
-                }
-            } else {
-                if (str1 > str2) {
-                    return true;
-                }
-            }
-            break;
+    auto runs = 1;
+    for (auto i = 1; i < positions.size(); i++) {
+        if (positions.at(i) != positions.at(i - 1)) {
+            runs++;
         }
+    }
 
-        case FMH::MODEL_KEY::PLACE: {
-            int e1TagIndex = -1;
-            int e2TagIndex = -1;
-            for (int m = 0; m < 8; m++) {
-                QString tag = "tag" + QString::number(m) + "_jingos";
-                if (FMStatic::urlTagExists(e1[FMH::MODEL_KEY::PATH], tag)) {
-                    e1TagIndex = m;
-                }
-                if (FMStatic::urlTagExists(e2[FMH::MODEL_KEY::PATH], tag)) {
-                    e2TagIndex = m;
-                }
-            }
-            if (sortOrder == Qt::AscendingOrder) {
-                if (e1TagIndex > e2TagIndex) {
-                    return true;
-                } else if (e1TagIndex == e2TagIndex) {
-                    const auto str1 = QString(e1[FMH::MODEL_KEY::LABEL]).toLower();
-                    const auto str2 = QString(e2[FMH::MODEL_KEY::LABEL]).toLower();
-                    if (str1 < str2) {
-                        return true;
-                    }
-                }
-            } else {
-                if (e1TagIndex < e2TagIndex) {
-                    return true;
-                } else if (e1TagIndex == e2TagIndex) {
-                    const auto str1 = QString(e1[FMH::MODEL_KEY::LABEL]).toLower();
-                    const auto str2 = QString(e2[FMH::MODEL_KEY::LABEL]).toLower();
-                    if (str1 > str2) {
-                        return true;
-                    }
-                }
+    // a few runs go in as ranges, from the last one so the earlier positions remain valid. Each one moves the tail of the list once
+    if (runs <= MAX_MERGE_RUNS && items.size() * 4 < this->list.size()) {
+        auto end = items.size();
+        while (end > 0) {
+            const auto position = positions.at(end - 1);
+            auto begin = end - 1;
+            while (begin > 0 && positions.at(begin - 1) == position) {
+                begin--;
             }
-            break;
-        }
 
-        default: {
-            if (sortOrder == Qt::AscendingOrder) {
-                if (e1[key] < e2[key]) {
-                    return true;
-                }
-            } else {
-                if (e1[key] > e2[key]) {
-                    return true;
-                }
-            }
+            const auto count = end - begin;
+            const auto size = this->list.size();
+
+            emit this->preItemsAppendedAt(position, count);
+            this->list.resize(size + count);
+            std::move_backward(this->list.begin() + position, this->list.begin() + size, this->list.end());
+            std::move(items.begin() + begin, items.begin() + end, this->list.begin() + position);
+            this->reindex(position, this->list.size());
+            emit this->postItemAppended();
+
+            end = begin;
         }
+        return;
+    }
+
+    // the batch is spread all over the list, so it is merged in a single pass and the view is reset once
+    emit this->preListChanged();
+
+    FMH::FILE_LIST merged;
+    merged.reserve(this->list.size() + items.size());
+
+    auto next = 0;
+    for (auto i = 0; i < items.size(); i++) {
+        while (next < positions.at(i)) {
+            merged << std::move(this->list[next++]);
         }
+        merged << std::move(items[i]);
+    }
 
-        return false;
-    });
+    while (next < this->list.size()) {
+        merged << std::move(this->list[next++]);
+    }
+
+    this->list = std::move(merged);
+    this->reindex(0, this->list.size());
+
+    emit this->postListChanged();
+}
+
+void FMList::reindex(const int &from, const int &to)
+{
+    if (!this->urlIndexValid) {
+        return;
+    }
+
+    for (auto i = from; i < to; i++) {
+        this->urlIndex.insert(this->list.at(i).url, i);
+    }
+}
+
+void FMList::unindex(const int &from, const int &to)
+{
+    if (!this->urlIndexValid) {
+        return;
+    }
+
+    for (auto i = from; i < to; i++) {
+        this->urlIndex.remove(this->list.at(i).url);
+    }
 }
 
 QString FMList::getPathName() const
@@ -955,9 +1105,13 @@ void FMList::refresh()
 
 void FMList::refreshItem(const int index, const QUrl &path)
 {
-    FMH::MODEL model = FMH::getFileInfoModel(path);
-    this->list[index] = model;
-    emit this->updateModel(index, FMH::modelRoles(model));
+    if (index >= this->list.size() || index < 0) {
+        return;
+    }
+
+    const auto item = FMH::getFileItem(path);
+    this->setItem(index, item);
+    emit this->updateModel(index, item.roles());
 }
 
 
@@ -993,7 +1147,7 @@ void FMList::setDirIcon(const int &index, const QString &iconName)
         return;
     }
 
-    const auto path = QUrl(this->list.at(index)[FMH::MODEL_KEY::PATH]);
+    const auto path = QUrl(this->list.at(index).url);
 
     if (!FMStatic::isDir(path)) {
         return;
@@ -1001,7 +1155,8 @@ void FMList::setDirIcon(const int &index, const QString &iconName)
 
     FMH::setDirConf(path.toString() + "/.directory", "Desktop Entry", "Icon", iconName);
 
-    this->list[index][FMH::MODEL_KEY::ICON] = iconName;
+    this->list[index].icon = iconName;
+    this->updateFilterSource(this->list.at(index));
     emit this->updateModel(index, QVector<int> {FMH::MODEL_KEY::ICON});
 }
 
@@ -1084,104 +1239,96 @@ void FMList::search(const QString &query, const QUrl &path, const bool &hidden,
         return;
     }
 
-    FMH::MODEL_LIST tmpList;
-    if (pathType == FMList::PATHTYPE::OTHER_PATH) {
-        if (this->path.toString() == "qrc:/widgets/views/Recents") {
-            tmpList = FMStatic::getTagContent("recents_jingos");
-        } else if (this->path.toString() == "qrc:/widgets/views/tag0") {
-            tmpList = FMStatic::getTagContent("tag0_jingos");
-        } else if (this->path.toString() == "qrc:/widgets/views/tag1") {
-            tmpList = FMStatic::getTagContent("tag1_jingos");
-        } else if (this->path.toString() == "qrc:/widgets/views/tag2") {
-            tmpList = FMStatic::getTagContent("tag2_jingos");
-        } else if (this->path.toString() == "qrc:/widgets/views/tag3") {
-            tmpList = FMStatic::getTagContent("tag3_jingos");
-        } else if (this->path.toString() == "qrc:/widgets/views/tag4") {
-            tmpList = FMStatic::getTagContent("tag4_jingos");
-        } else if (this->path.toString() == "qrc:/widgets/views/tag5") {
-            tmpList = FMStatic::getTagContent("tag5_jingos");
-        } else if (this->path.toString() == "qrc:/widgets/views/tag6") {
-            tmpList = FMStatic::getTagContent("tag6_jingos");
-        } else if (this->path.toString() == "qrc:/widgets/views/tag7") {
-            tmpList = FMStatic::getTagContent("tag7_jingos");
-        } else {
-            QStringList typeFilterList;
-            if (this->path.toString() == "qrc:/widgets/views/Document") {
-                typeFilterList << "type:document";
-            } else if (this->path.toString() == "qrc:/widgets/views/Picture") {
-                typeFilterList << "type:image";
-            } else if (this->path.toString() == "qrc:/widgets/views/Video") {
-                typeFilterList << "type:video";
-            } else if (this->path.toString() == "qrc:/widgets/views/Music") {
-                typeFilterList << "type:audio";
-            }
-            QProcess balooProcess;
-            balooProcess.start("baloosearch", typeFilterList);
-            if (!balooProcess.waitForStarted()) {
-                return;
-            }
-            balooProcess.closeWriteChannel();
-            if (!balooProcess.waitForFinished()) {
+    const auto token = this->newRequest();
+
+    if (pathType != FMList::PATHTYPE::OTHER_PATH) {
+        // the results are merged into the list as they are found, ranked by how well they match
+        this->clear();
+        this->m_ranked = true;
+        this->setStatus({STATUS_CODE::LOADING, "", "", "", false, true});
+
+        const auto limit = static_cast<uint>(qMax(0, this->searchLimit));
+        const QPointer<FMList> self(this);
+        QtConcurrent::run([=]() {
+            FMStatic::searchItems(query, path, hidden, onlyDirs, filters, [self, token](const FMH::FILE_LIST &batch) {
+                if (!self) {
+                    return;
+                }
+
+                QMetaObject::invokeMethod(self, [self, token, batch]() {
+                    if (self && !token.isCancelled()) {
+                        self->mergeIntoList(batch);
+                    }
+                }, Qt::QueuedConnection);
+            }, limit, token);
+
+            if (!self) {
                 return;
             }
-            QByteArray bateArray = balooProcess.readAll();
-            QString result = QString(bateArray);
-            QStringList pathList = result.split(QLatin1Char('\n'), Qt::SkipEmptyParts);//以“\n”为间隔，分割返回的数据
-            foreach (const QString &path, pathList) {
-                FMH::MODEL model = FMH::getFileInfoModel(QUrl("file://" + path));
-                tmpList << model;
-            }
-        }
+
+            QMetaObject::invokeMethod(self, [self, token]() {
+                // a newer request took over, its results are the ones to show
+                if (!self || token.isCancelled()) {
+                    return;
+                }
+
+                self->setStatus({STATUS_CODE::READY, self->list.isEmpty() ? "Nothing here!" : "", self->list.isEmpty() ? "This place seems to be empty" : "", self->list.isEmpty() ? "folder-add" : "", self->list.isEmpty(), true});
+                emit self->searchResultReady();
+            }, Qt::QueuedConnection);
+        });
+
+        return;
     }
 
-    QFutureWatcher<FMH::PATH_CONTENT> *watcher = new QFutureWatcher<FMH::PATH_CONTENT>;
-    connect(watcher, &QFutureWatcher<FMH::MODEL_LIST>::finished, [=]() {
-        const auto res = watcher->future().result();
+    FMH::FILE_LIST tmpList;
+    if (this->path.toString() == "qrc:/widgets/views/Recents") {
+        tmpList = FMH::toFileList(FMStatic::getTagContent("recents_jingos"));
+    } else if (this->path.toString() == "qrc:/widgets/views/tag0") {
+        tmpList = FMH::toFileList(FMStatic::getTagContent("tag0_jingos"));
+    } else if (this->path.toString() == "qrc:/widgets/views/tag1") {
+        tmpList = FMH::toFileList(FMStatic::getTagContent("tag1_jingos"));
+    } else if (this->path.toString() == "qrc:/widgets/views/tag2") {
+        tmpList = FMH::toFileList(FMStatic::getTagContent("tag2_jingos"));
+    } else if (this->path.toString() == "qrc:/widgets/views/tag3") {
+        tmpList = FMH::toFileList(FMStatic::getTagContent("tag3_jingos"));
+    } else if (this->path.toString() == "qrc:/widgets/views/tag4") {
+        tmpList = FMH::toFileList(FMStatic::getTagContent("tag4_jingos"));
+    } else if (this->path.toString() == "qrc:/widgets/views/tag5") {
+        tmpList = FMH::toFileList(FMStatic::getTagContent("tag5_jingos"));
+    } else if (this->path.toString() == "qrc:/widgets/views/tag6") {
+        tmpList = FMH::toFileList(FMStatic::getTagContent("tag6_jingos"));
+    } else if (this->path.toString() == "qrc:/widgets/views/tag7") {
+        tmpList = FMH::toFileList(FMStatic::getTagContent("tag7_jingos"));
+    }
 
+    // the media views are read from the catalogue off the main thread
+    const auto type = mediaType(this->path);
+    const auto catalogue = FMH::MediaCatalogue::instance();
 
-        if (pathType == FMList::PATHTYPE::OTHER_PATH) {
-            this->list = res.content;
-            this->sortList();
-            this->setStatus({STATUS_CODE::READY, this->list.isEmpty() ? "Nothing here!" : "", this->list.isEmpty() ? "This place seems to be empty" : "", this->list.isEmpty() ? "folder-add" : "", this->list.isEmpty(), true});
-            this->filterContent(query, path);
-        } else {
-            this->assignList(res.content);
+    QFutureWatcher<FMH::PATH_CONTENT> *watcher = new QFutureWatcher<FMH::PATH_CONTENT>(this);
+    connect(watcher, &QFutureWatcher<FMH::PATH_CONTENT>::finished, [=]() {
+        watcher->deleteLater();
+
+        // a newer request took over, its results are the ones to show
+        if (token.isCancelled()) {
+            return;
         }
-        emit this->searchResultReady();
 
-        watcher->deleteLater();
+        const auto res = watcher->future().result();
+
+        this->list = res.content;
+        this->urlIndexValid = false;
+        this->m_filterStale = true;
+        this->sortList();
+        this->setStatus({STATUS_CODE::READY, this->list.isEmpty() ? "Nothing here!" : "", this->list.isEmpty() ? "This place seems to be empty" : "", this->list.isEmpty() ? "folder-add" : "", this->list.isEmpty(), true});
+        this->filterContent(query, path);
+        emit this->searchResultReady();
     });
 
     QFuture<FMH::PATH_CONTENT> t1 = QtConcurrent::run([=]() -> FMH::PATH_CONTENT {
         FMH::PATH_CONTENT res;
         res.path = path.toString();
-        if (pathType == FMList::PATHTYPE::OTHER_PATH)
-        {
-            if (this->path.toString() == "qrc:/widgets/views/Recents") {
-                res.content = tmpList;
-            } else if (this->path.toString() == "qrc:/widgets/views/tag0") {
-                res.content = tmpList;
-            } else if (this->path.toString() == "qrc:/widgets/views/tag1") {
-                res.content = tmpList;
-            } else if (this->path.toString() == "qrc:/widgets/views/tag2") {
-                res.content = tmpList;
-            } else if (this->path.toString() == "qrc:/widgets/views/tag3") {
-                res.content = tmpList;
-            } else if (this->path.toString() == "qrc:/widgets/views/tag4") {
-                res.content = tmpList;
-            } else if (this->path.toString() == "qrc:/widgets/views/tag5") {
-                res.content = tmpList;
-            } else if (this->path.toString() == "qrc:/widgets/views/tag6") {
-                res.content = tmpList;
-            } else if (this->path.toString() == "qrc:/widgets/views/tag7") {
-                res.content = tmpList;
-            } else {
-                res.content = tmpList;
-            }
-        } else
-        {
-            res.content = FMStatic::search(query, path, hidden, onlyDirs, filters);
-        }
+        res.content = type != FMH::MediaCatalogue::NONE && catalogue ? catalogue->items(type) : tmpList;
         return res;
     });
     watcher->setFuture(t1);
@@ -1189,39 +1336,252 @@ void FMList::search(const QString &query, const QUrl &path, const bool &hidden,
 
 void FMList::filterContent(const QString &query, const QUrl &path)
 {
-    if (this->list.isEmpty()) {
+    if (this->m_filterStale) {
+        // a new listing, shown whole, is what gets filtered from now on
+        this->setFilterSource(this->list);
+        this->m_filterRows.resize(this->list.size());
+        std::iota(this->m_filterRows.begin(), this->m_filterRows.end(), 0);
+        this->m_filterView = true;
+        this->m_filterStale = false;
+        this->m_filterResort = false;
+    } else if (!this->m_filterAdded.isEmpty() || !this->m_filterRemoved.isEmpty()) {
+        // what the list got or lost while filtered goes into the whole listing as well
+        FMH::FILE_LIST source;
+        source.reserve(this->m_filterSource.size() + this->m_filterAdded.size());
+        for (const auto &item : qAsConst(this->m_filterSource)) {
+            if (!this->m_filterRemoved.contains(item.url)) {
+                source << item;
+            }
+        }
+        source << this->m_filterAdded;
+
+        this->setFilterSource(source);
+        this->m_filterResort = true;
+    }
+
+    if (this->m_filterResort) {
+        FMH::MODEL_KEY key;
+        Qt::SortOrder order;
+        bool foldersFirst;
+        this->sortParams(key, order, foldersFirst);
+
+        auto source = this->m_filterSource;
+        sortItems(source, key, order, foldersFirst);
+        this->setFilterSource(source);
+        this->m_filterResort = false;
+    }
+
+    if (this->m_filterSource.isEmpty()) {
         return;
     }
 
-    QFutureWatcher<FMH::PATH_CONTENT> *watcher = new QFutureWatcher<FMH::PATH_CONTENT>;
-    connect(watcher, &QFutureWatcher<FMH::MODEL_LIST>::finished, [=]() {
-        const auto res = watcher->future().result();
+    // a longer text can only narrow down the rows shown
+    const bool refine = this->m_filter && this->m_filterView && query.startsWith(this->m_filterQuery, Qt::CaseInsensitive);
 
-        this->assignList(res.content);
-        emit this->searchResultReady();
+    const auto token = this->newRequest();
+    const auto items = this->m_filterSource; // shared copy, the list may change while filtering
+    const bool fuzzy = this->filterMode == FMList::FILTER_MODE::FUZZY && !query.isEmpty();
+
+    if (fuzzy) {
+        QFutureWatcher<FMH::PATH_CONTENT> *watcher = new QFutureWatcher<FMH::PATH_CONTENT>(this);
+        connect(watcher, &QFutureWatcher<FMH::PATH_CONTENT>::finished, [=]() {
+            watcher->deleteLater();
+
+            if (token.isCancelled()) {
+                return;
+            }
+
+            const auto res = watcher->future().result();
+
+            // the ranking is not a view of the source rows, the next filter starts over from them
+            this->m_ranked = true;
+            this->m_filterView = false;
+            this->m_filtering = true;
+            this->assignList(res.content);
+            this->m_filtering = false;
+            emit this->searchResultReady();
+        });
+
+        QFuture<FMH::PATH_CONTENT> t1 = QtConcurrent::run([=]() -> FMH::PATH_CONTENT {
+            FMH::FILE_LIST m_content;
+            FMH::PATH_CONTENT res;
 
+            FMH::FuzzyMatcher matcher;
+            for (int i = 0; i < items.size(); i++) {
+                if (i % 1024 == 0 && token.isCancelled()) {
+                    return res;
+                }
+
+                matcher.append(items.at(i).label);
+            }
+
+            const auto results = matcher.match(query, token);
+            if (token.isCancelled()) {
+                return res;
+            }
+
+            // the position in the ranking is the score the list is sorted by
+            m_content.reserve(results.size());
+            for (int i = 0; i < results.size(); i++) {
+                auto item = items.at(results.at(i).row);
+                item.extra[FMH::MODEL_KEY::SCORE] = QString::number(i);
+                m_content << item;
+            }
+
+            res.path = path.toString();
+            res.content = m_content;
+            return res;
+        });
+        watcher->setFuture(t1);
+        return;
+    }
+
+    const auto filter = this->m_filter;
+    const auto rows = refine ? this->m_filterRows : QVector<int>();
+    const auto version = this->m_filterVersion;
+
+    QFutureWatcher<FilterResult> *watcher = new QFutureWatcher<FilterResult>(this);
+    connect(watcher, &QFutureWatcher<FilterResult>::finished, [=]() {
         watcher->deleteLater();
+
+        if (token.isCancelled()) {
+            return;
+        }
+
+        const auto res = watcher->future().result();
+        this->m_filter = res.filter;
+        this->m_filterQuery = query;
+
+        // the source was replaced meanwhile, the rows found are not its own
+        if (this->m_filterStale || this->m_filterVersion != version) {
+            return;
+        }
+
+        this->m_filtering = true;
+        if (refine && this->m_filterView) {
+            // the rows left are already shown, only the others are taken out
+            QVector<int> removed;
+            for (int i = 0, j = 0; i < this->m_filterRows.size(); i++) {
+                if (j < res.rows.size() && res.rows.at(j) == this->m_filterRows.at(i)) {
+                    j++;
+                } else {
+                    removed << i;
+                }
+            }
+
+            this->removeItems(removed);
+        } else {
+            // the source is sorted and the rows come in ascending order, so the picked items need no sorting. They are
+            // picked from the source as it is now, with what was resolved or measured meanwhile
+            FMH::FILE_LIST picked;
+            picked.reserve(res.rows.size());
+            for (const auto &row : res.rows) {
+                picked << this->m_filterSource.at(row);
+            }
+
+            emit this->preListChanged();
+            this->list = picked;
+            this->urlIndexValid = false;
+            emit this->postListChanged();
+        }
+        this->m_filtering = false;
+
+        this->m_filterRows = res.rows;
+        this->m_filterView = true;
+
+        this->setStatus({STATUS_CODE::READY, this->list.isEmpty() ? "Nothing here!" : "", this->list.isEmpty() ? "This place seems to be empty" : "", this->list.isEmpty() ? "folder-add" : "", this->list.isEmpty(), true});
+        emit this->searchResultReady();
     });
 
-    QFuture<FMH::PATH_CONTENT> t1 = QtConcurrent::run([=]() -> FMH::PATH_CONTENT {
-        FMH::MODEL_LIST m_content;
-        FMH::PATH_CONTENT res;
+    QFuture<FilterResult> t1 = QtConcurrent::run([=]() -> FilterResult {
+        FilterResult res;
+        res.filter = filter;
 
-        for (const auto &item : qAsConst(this->list))
-        {
-            if (item[FMH::MODEL_KEY::LABEL].contains(query, Qt::CaseInsensitive) || item[FMH::MODEL_KEY::SUFFIX].contains(query, Qt::CaseInsensitive) || item[FMH::MODEL_KEY::MIME].contains(query, Qt::CaseInsensitive)) {
+        // built once per listing, the following filters reuse it
+        if (!res.filter) {
+            auto built = std::make_shared<FMH::TextFilter>();
+            for (int i = 0; i < items.size(); i++) {
+                if (i % 1024 == 0 && token.isCancelled()) {
+                    return res;
+                }
 
-                m_content << item;
+                const auto &item = items.at(i);
+                built->append({item.label, item.mime});
             }
+            res.filter = built;
         }
 
-        res.path = path.toString();
-        res.content = m_content;
+        res.rows = refine ? res.filter->match(query, rows, token) : res.filter->match(query, token);
         return res;
     });
     watcher->setFuture(t1);
 }
 
+void FMList::setFilterSource(const FMH::FILE_LIST &source)
+{
+    this->m_filterSource = source;
+    this->m_filterVersion++;
+    this->m_filterSourceIndex.clear();
+    this->m_filterSourceIndex.reserve(source.size());
+    for (int i = 0; i < source.size(); i++) {
+        this->m_filterSourceIndex.insert(source.at(i).url, i);
+    }
+
+    // the rows of the filter and the ones shown do not match the source anymore
+    this->m_filter.reset();
+    this->m_filterAdded.clear();
+    this->m_filterRemoved.clear();
+    this->m_filterQuery.clear();
+    this->m_filterView = false;
+}
+
+void FMList::updateFilterSource(const FMH::FileItem &item)
+{
+    const auto row = this->m_filterSourceIndex.value(item.url, -1);
+    if (row < 0) {
+        return;
+    }
+
+    // the filter only reads the label and the mime, the other fields can change under it
+    const auto &current = this->m_filterSource.at(row);
+    if (current.label != item.label || current.mime != item.mime) {
+        this->m_filter.reset();
+    }
+
+    this->m_filterSource[row] = item;
+}
+
+void FMList::filterAdded(const FMH::FILE_LIST &items)
+{
+    if (this->m_filtering || this->m_filterStale) {
+        return;
+    }
+
+    this->m_filterAdded << items;
+    this->m_filterView = false;
+}
+
+void FMList::filterRemoved(const QVector<int> &indexes)
+{
+    if (this->m_filtering || this->m_filterStale) {
+        return;
+    }
+
+    for (const auto &index : indexes) {
+        if (index < 0 || index >= this->list.size()) {
+            continue;
+        }
+
+        const auto &url = this->list.at(index).url;
+        this->m_filterAdded.erase(std::remove_if(this->m_filterAdded.begin(), this->m_filterAdded.end(), [&url](const FMH::FileItem &item) {
+            return item.url == url;
+        }), this->m_filterAdded.end());
+        this->m_filterRemoved.insert(url);
+    }
+
+    this->m_filterView = false;
+}
+
 int FMList::getCloudDepth() const
 {
     return this->cloudDepth;
@@ -1238,6 +1598,59 @@ void FMList::setCloudDepth(const int &value)
     emit this->cloudDepthChanged();
 }
 
+int FMList::getSearchLimit() const
+{
+    return this->searchLimit;
+}
+
+void FMList::setSearchLimit(const int &value)
+{
+    if (this->searchLimit == value) {
+        return;
+    }
+
+    this->searchLimit = value;
+
+    emit this->searchLimitChanged();
+}
+
+FMList::FILTER_MODE FMList::getFilterMode() const
+{
+    return this->filterMode;
+}
+
+void FMList::setFilterMode(const FMList::FILTER_MODE &value)
+{
+    if (this->filterMode == value) {
+        return;
+    }
+
+    this->filterMode = value;
+
+    emit this->filterModeChanged();
+}
+
+bool FMList::getFolderSizes() const
+{
+    return this->folderSizes;
+}
+
+void FMList::setFolderSizes(const bool &value)
+{
+    if (this->folderSizes == value) {
+        return;
+    }
+
+    this->folderSizes = value;
+    this->m_measured.clear();
+    emit this->folderSizesChanged();
+
+    // the views read the sizes again, which requests them
+    if (this->folderSizes && !this->list.isEmpty()) {
+        emit this->updateModelRange(0, static_cast<uint>(this->list.size()), {FMH::MODEL_KEY::SIZE, FMH::MODEL_KEY::COUNT});
+    }
+}
+
 PathStatus FMList::getStatus() const
 {
     return this->m_status;
@@ -1255,7 +1668,115 @@ void FMList::remove(const int &index)
         return;
     }
 
+    this->filterRemoved({index});
+
     emit this->preItemRemoved(index);
+    this->unindex(index, index + 1);
     this->list.remove(index);
+    this->reindex(index, this->list.size());
     emit this->postItemRemoved();
 }
+
+void FMList::removeItems(QVector<int> indexes)
+{
+    indexes.erase(std::remove_if(indexes.begin(), indexes.end(), [this](const int &index) -> bool {
+        return index >= this->list.size() || index < 0;
+    }), indexes.end());
+
+    if (indexes.isEmpty()) {
+        return;
+    }
+
+    std::sort(indexes.begin(), indexes.end());
+    indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+
+    this->filterRemoved(indexes);
+
+    for (const auto &index : qAsConst(indexes)) {
+        this->unindex(index, index + 1);
+    }
+
+    // when most of the list goes away a single reset is cheaper than notifying every range
+    if (indexes.size() > this->list.size() / 2) {
+        emit this->preListChanged();
+        FMH::FILE_LIST res;
+        res.reserve(this->list.size() - indexes.size());
+        auto next = indexes.constBegin();
+        for (auto i = 0; i < this->list.size(); i++) {
+            if (next != indexes.constEnd() && *next == i) {
+                next++;
+                continue;
+            }
+            res << this->list.at(i);
+        }
+        this->list = res;
+        this->reindex(indexes.first(), this->list.size());
+        emit this->postListChanged();
+        return;
+    }
+
+    // remove every contiguous range at once, from the last one so the earlier indexes remain valid
+    auto end = indexes.size();
+    while (end > 0) {
+        auto begin = end - 1;
+        while (begin > 0 && indexes.at(begin - 1) == indexes.at(begin) - 1) {
+            begin--;
+        }
+
+        emit this->preItemsRemoved(indexes.at(begin), end - begin);
+        this->list.remove(indexes.at(begin), end - begin);
+        emit this->postItemRemoved();
+
+        end = begin;
+    }
+
+    // only the rows after the first removed one moved
+    this->reindex(indexes.first(), this->list.size());
+}
+
+int FMList::indexOfUrl(const QString &url) const
+{
+    if (!this->urlIndexValid) {
+        this->urlIndex.clear();
+        this->urlIndex.reserve(this->list.size());
+        for (auto i = 0; i < this->list.size(); i++) {
+            this->urlIndex.insert(this->list.at(i).url, i);
+        }
+        this->urlIndexValid = true;
+    }
+
+    return this->urlIndex.value(url, -1);
+}
+
+void FMList::updateRanges(QVector<int> indexes, const QVector<int> &roles)
+{
+    std::sort(indexes.begin(), indexes.end());
+    indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+
+    for (int i = 0; i < indexes.size();) {
+        int j = i + 1;
+        while (j < indexes.size() && indexes.at(j) == indexes.at(j - 1) + 1) {
+            j++;
+        }
+
+        emit this->updateModelRange(indexes.at(i), static_cast<uint>(j - i), roles);
+        i = j;
+    }
+}
+
+void FMList::setItem(const int &index, const FMH::FileItem &item)
+{
+    if (this->urlIndexValid && this->list.at(index).url != item.url) {
+        this->urlIndex.remove(this->list.at(index).url);
+        this->urlIndex.insert(item.url, index);
+    }
+
+    // a renamed item is another entry of the listing
+    if (this->list.at(index).url != item.url) {
+        this->filterRemoved({index});
+        this->filterAdded({item});
+    }
+
+    this->list[index] = item;
+    this->updateFilterSource(item);
+}
@@ -22,11 +22,21 @@
 
 #include "fmh.h"
 #include "mauilist.h"
+#include "mediacatalogue.h"
+#include "metadataresolver.h"
 #include <QObject>
 #include <QFuture>
+#include <QSet>
+
+#include <memory>
 
 class FM;
 
+namespace FMH
+{
+class TextFilter;
+}
+
 enum STATUS_CODE : uint_fast8_t { LOADING, ERROR, READY };
 
 /**
@@ -104,6 +114,9 @@ class FMList : public MauiList
     Q_PROPERTY(bool onlyDirs READ getOnlyDirs WRITE setOnlyDirs NOTIFY onlyDirsChanged)
     Q_PROPERTY(bool foldersFirst READ getFoldersFirst WRITE setFoldersFirst NOTIFY foldersFirstChanged)
     Q_PROPERTY(int cloudDepth READ getCloudDepth WRITE setCloudDepth NOTIFY cloudDepthChanged)
+    Q_PROPERTY(int searchLimit READ getSearchLimit WRITE setSearchLimit NOTIFY searchLimitChanged)
+    Q_PROPERTY(FMList::FILTER_MODE filterMode READ getFilterMode WRITE setFilterMode NOTIFY filterModeChanged)
+    Q_PROPERTY(bool folderSizes READ getFolderSizes WRITE setFolderSizes NOTIFY folderSizesChanged)
 
     Q_PROPERTY(QStringList filters READ getFilters WRITE setFilters NOTIFY filtersChanged)
     Q_PROPERTY(FMList::FILTER filterType READ getFilterType WRITE setFilterType NOTIFY filterTypeChanged)
@@ -171,6 +184,12 @@ public:
     };
     Q_ENUM(VIEW_TYPE)
 
+    enum FILTER_MODE : uint_fast8_t {
+        SUBSTRING,
+        FUZZY
+    };
+    Q_ENUM(FILTER_MODE)
+
     Q_ENUM(STATUS_CODE)
 
     /**
@@ -178,13 +197,20 @@ public:
      * @param parent
      */
     FMList(QObject *parent = nullptr);
+    ~FMList();
 
     /**
      * @brief items
+     * The items are kept packed as FMH::FileItem, this builds a FMH::MODEL_LIST copy of them on every call, so prefer the item accessors
      * @return
      */
     const FMH::MODEL_LIST &items() const final override;
 
+    int itemsCount() const final override;
+    FMH::MODEL itemAt(const int &index) const final override;
+    QString itemValue(const int &index, const FMH::MODEL_KEY &key) const final override;
+    QVariant itemData(const int &index, const FMH::MODEL_KEY &key) const final override;
+
     /**
      * @brief getSortBy
      * @return
@@ -327,6 +353,47 @@ public:
      */
     void setCloudDepth(const int &value);
 
+    /**
+     * @brief getSearchLimit
+     * @return
+     */
+    int getSearchLimit() const;
+
+    /**
+     * @brief setSearchLimit
+     * Maximum number of search results, the search stops once it is reached. 0 for no limit
+     * @param value
+     */
+    void setSearchLimit(const int &value);
+
+    /**
+     * @brief getFilterMode
+     * @return
+     */
+    FMList::FILTER_MODE getFilterMode() const;
+
+    /**
+     * @brief setFilterMode
+     * How the content already listed is filtered by a search. The fuzzy mode matches the label and ranks the results by
+     * how well they match
+     * @param value
+     */
+    void setFilterMode(const FMList::FILTER_MODE &value);
+
+    /**
+     * @brief getFolderSizes
+     * @return
+     */
+    bool getFolderSizes() const;
+
+    /**
+     * @brief setFolderSizes
+     * Whether the folders show the total size of their content and their number of children, measured in the
+     * background by the DirStats service once they are shown
+     * @param value
+     */
+    void setFolderSizes(const bool &value);
+
     /**
     * @brief getStatus
     * Get the current status of the current path
@@ -336,19 +403,70 @@ public:
 
 private:
     FM *fm;
+    FMH::MetadataResolver *resolver; // completes the items listed lazily once they are shown
 
     void clear();
     void reset();
     void setList();
-    void assignList(const FMH::MODEL_LIST &list);
-    void appendToList(const FMH::MODEL_LIST &list);
+    void assignList(const FMH::FILE_LIST &list);
+    void appendToList(const FMH::FILE_LIST &list);
+    void mergeIntoList(FMH::FILE_LIST items);
     void sortList();
-    FMH::MODEL_LIST sortList(FMH::MODEL_LIST currentList);
+    FMH::FILE_LIST sortList(FMH::FILE_LIST currentList);
     void search(const QString &query, const QUrl &path, const bool &hidden = false, const bool &onlyDirs = false, const QStringList &filters = QStringList());
     void filterContent(const QString &query, const QUrl &path);
     void setStatus(const PathStatus &status);
-
-    FMH::MODEL_LIST list = {{}};
+    FMH::CancelToken newRequest();
+    void sortParams(FMH::MODEL_KEY &key, Qt::SortOrder &order, bool &foldersFirst) const;
+
+    bool usesSnapshots() const;
+    QString snapshotOptions() const;
+    void loadSnapshot();
+    void storeSnapshot();
+    void revalidate(const FMH::FILE_LIST &items);
+    void finishRevalidation();
+    void cancelRevalidation();
+
+    void loadMedia(const FMH::MediaCatalogue::TYPE &type, const FMH::CancelToken &token);
+
+    void removeItems(QVector<int> indexes);
+    int indexOfUrl(const QString &url) const;
+    void reindex(const int &from, const int &to);
+    void unindex(const int &from, const int &to);
+    void setItem(const int &index, const FMH::FileItem &item);
+    void updateRanges(QVector<int> indexes, const QVector<int> &roles = {});
+
+    void setFilterSource(const FMH::FILE_LIST &source);
+    void updateFilterSource(const FMH::FileItem &item);
+    void filterAdded(const FMH::FILE_LIST &items);
+    void filterRemoved(const QVector<int> &indexes);
+
+    FMH::FILE_LIST list = {FMH::FileItem()};
+    mutable FMH::MODEL_LIST modelList;
+    mutable QHash<QString, int> urlIndex; // url to row, kept current as the rows move and rebuilt on demand when the list is replaced
+    mutable bool urlIndexValid = false;
+
+    quint64 m_generation = 0; // bumped by every listing, search or filter request
+    FMH::CancelToken m_token; // token of the latest request
+
+    quint64 m_listingGeneration = 0; // request that started the directory listing in progress
+    bool m_revalidating = false; // the list shows a snapshot that the listing in progress is checking
+    QSet<QString> m_seen; // urls listed so far while revalidating
+
+    bool m_ranked = false; // the list shows search results, sorted by how well they match
+
+    std::shared_ptr<const FMH::TextFilter> m_filter; // built on the source rows by the first substring filter
+    FMH::FILE_LIST m_filterSource; // the whole listing, sorted, whatever the filter hides of it
+    QHash<QString, int> m_filterSourceIndex; // url to row in m_filterSource
+    FMH::FILE_LIST m_filterAdded; // items the list got since the source was built, not in it yet
+    QSet<QString> m_filterRemoved; // urls the list lost since the source was built
+    QVector<int> m_filterRows; // source rows the list shows, in order
+    QString m_filterQuery; // text of the last filter applied
+    quint64 m_filterVersion = 0; // bumped every time the source is replaced
+    bool m_filterView = false; // the list shows exactly the source rows in m_filterRows
+    bool m_filterStale = true; // the list holds a new listing, the source is built again from it
+    bool m_filterResort = false; // the sort changed, the source has to follow
+    bool m_filtering = false; // the filter itself is changing the rows
 
     QUrl path;
     QString pathName = QString();
@@ -359,6 +477,10 @@ private:
 
     bool foldersFirst = false;
     int cloudDepth = 1;
+    int searchLimit = 5000;
+    FMList::FILTER_MODE filterMode = FMList::FILTER_MODE::SUBSTRING;
+    bool folderSizes = false;
+    mutable QSet<QString> m_measured; // folders sent to DirStats, by url
 
     PathStatus m_status;
 
@@ -459,6 +581,9 @@ signals:
     void foldersFirstChanged();
     void statusChanged();
     void cloudDepthChanged();
+    void searchLimitChanged();
+    void filterModeChanged();
+    void folderSizesChanged();
 
     void warning(QString message);
     void progress(int percent);
@@ -0,0 +1,203 @@
+#include "imagethumbnailer.h"
+#include "mimecache.h"
+
+#include <QFile>
+#include <QImageReader>
+#include <QSet>
+#include <QTransform>
+
+#include <cmath>
+
+using namespace FMH;
+
+static const qint64 EXIF_MAX = 64 * 1024; // an APP1 segment, where the EXIF data lives, can not be larger
+static const double ASPECT_TOLERANCE = 0.02; // some cameras pad the embedded thumbnail to 4:3
+
+static QSet<QString> readableTypes()
+{
+    QSet<QString> res;
+    const auto types = QImageReader::supportedMimeTypes();
+    for (const auto &type : types) {
+        res.insert(QString::fromLatin1(type));
+    }
+
+    return res;
+}
+
+// integers of the TIFF structure holding the EXIF data, in the byte order it declares. The offsets come from the file,
+// so they are checked in 64 bits where no sum of them can overflow
+static bool read16(const QByteArray &data, const qint64 &offset, const bool &little, quint16 *value)
+{
+    if (offset < 0 || offset + 2 > data.size()) {
+        return false;
+    }
+
+    const auto bytes = reinterpret_cast<const uchar *>(data.constData()) + offset;
+    *value = little ? quint16(bytes[0] | bytes[1] << 8) : quint16(bytes[0] << 8 | bytes[1]);
+    return true;
+}
+
+static bool read32(const QByteArray &data, const qint64 &offset, const bool &little, quint32 *value)
+{
+    if (offset < 0 || offset + 4 > data.size()) {
+        return false;
+    }
+
+    const auto bytes = reinterpret_cast<const uchar *>(data.constData()) + offset;
+    *value = little ? quint32(bytes[0]) | quint32(bytes[1]) << 8 | quint32(bytes[2]) << 16 | quint32(bytes[3]) << 24
+                    : quint32(bytes[0]) << 24 | quint32(bytes[1]) << 16 | quint32(bytes[2]) << 8 | quint32(bytes[3]);
+    return true;
+}
+
+// the TIFF structure of the EXIF segment of a JPEG file, empty if there is none
+static QByteArray exifData(QFile &file)
+{
+    const auto head = file.read(EXIF_MAX + 4);
+    if (head.size() < 4 || uchar(head.at(0)) != 0xFF || uchar(head.at(1)) != 0xD8) {
+        return QByteArray();
+    }
+
+    int offset = 2;
+    while (offset + 4 <= head.size() && uchar(head.at(offset)) == 0xFF) {
+        const auto marker = uchar(head.at(offset + 1));
+        const auto length = int(uchar(head.at(offset + 2))) << 8 | uchar(head.at(offset + 3));
+
+        // the image data starts, the metadata is over
+        if (marker == 0xDA || marker == 0xD9) {
+            break;
+        }
+
+        if (marker == 0xE1 && head.mid(offset + 4, 6) == QByteArray("Exif\0\0", 6)) {
+            return head.mid(offset + 10, length - 8);
+        }
+
+        offset += 2 + length;
+    }
+
+    return QByteArray();
+}
+
+// turns the embedded thumbnail as the EXIF orientation of the photo says, the image reader only does it for the photo
+static QImage oriented(const QImage &image, const quint16 &orientation)
+{
+    switch (orientation) {
+    case 2:
+        return image.mirrored(true, false);
+    case 3:
+        return image.transformed(QTransform().rotate(180));
+    case 4:
+        return image.mirrored(false, true);
+    case 5:
+        return image.transformed(QTransform().rotate(90)).mirrored(true, false);
+    case 6:
+        return image.transformed(QTransform().rotate(90));
+    case 7:
+        return image.transformed(QTransform().rotate(90)).mirrored(false, true);
+    case 8:
+        return image.transformed(QTransform().rotate(270));
+    default:
+        return image;
+    }
+}
+
+bool ImageThumbnailer::canThumbnail(const QUrl &url)
+{
+    if (!url.isLocalFile()) {
+        return false;
+    }
+
+    static const auto types = readableTypes();
+    return types.contains(MimeCache::lookup(url.toLocalFile()).name);
+}
+
+QImage ImageThumbnailer::thumbnail(const QString &path, const int &size)
+{
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+
+    const auto imageSize = reader.size();
+
+    if (reader.format() == "jpeg" && imageSize.isValid()) {
+        const auto image = ImageThumbnailer::exifThumbnail(path, imageSize, size);
+        if (!image.isNull()) {
+            return image;
+        }
+    }
+
+    // the JPEG reader scales while decoding, the other formats are scaled once decoded
+    if (imageSize.isValid() && (imageSize.width() > size || imageSize.height() > size)) {
+        reader.setScaledSize(imageSize.scaled(size, size, Qt::KeepAspectRatio));
+    }
+
+    return reader.read();
+}
+
+QImage ImageThumbnailer::exifThumbnail(const QString &path, const QSize &imageSize, const int &size)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QImage();
+    }
+
+    const auto tiff = exifData(file);
+    if (tiff.size() < 8 || (!tiff.startsWith("II") && !tiff.startsWith("MM"))) {
+        return QImage();
+    }
+
+    const auto little = tiff.startsWith("II");
+
+    quint32 ifd0 = 0;
+    quint16 entries = 0;
+    if (!read32(tiff, 4, little, &ifd0) || ifd0 >= quint32(tiff.size()) || !read16(tiff, ifd0, little, &entries)) {
+        return QImage();
+    }
+
+    quint16 orientation = 1;
+    for (int i = 0; i < entries; i++) {
+        const auto entry = qint64(ifd0) + 2 + qint64(i) * 12;
+        quint16 tag = 0;
+        if (read16(tiff, entry, little, &tag) && tag == 0x0112) {
+            read16(tiff, entry + 8, little, &orientation);
+        }
+    }
+
+    // the embedded thumbnail is described by the second directory
+    quint32 ifd1 = 0;
+    if (!read32(tiff, qint64(ifd0) + 2 + qint64(entries) * 12, little, &ifd1) || ifd1 == 0 || ifd1 >= quint32(tiff.size())
+        || !read16(tiff, ifd1, little, &entries)) {
+        return QImage();
+    }
+
+    quint32 offset = 0, length = 0;
+    for (int i = 0; i < entries; i++) {
+        const auto entry = qint64(ifd1) + 2 + qint64(i) * 12;
+        quint16 tag = 0;
+        if (!read16(tiff, entry, little, &tag)) {
+            break;
+        }
+
+        if (tag == 0x0201) {
+            read32(tiff, entry + 8, little, &offset);
+        } else if (tag == 0x0202) {
+            read32(tiff, entry + 8, little, &length);
+        }
+    }
+
+    if (offset == 0 || length == 0 || qint64(offset) + length > tiff.size()) {
+        return QImage();
+    }
+
+    const auto image = QImage::fromData(tiff.mid(int(offset), int(length)), "JPEG");
+    if (image.isNull() || qMax(image.width(), image.height()) < size) {
+        return QImage();
+    }
+
+    // a padded thumbnail would show bars the photo does not have
+    const auto aspect = double(image.width()) / image.height();
+    const auto imageAspect = double(imageSize.width()) / imageSize.height();
+    if (std::abs(aspect - imageAspect) > ASPECT_TOLERANCE * imageAspect) {
+        return QImage();
+    }
+
+    return oriented(image, orientation);
+}
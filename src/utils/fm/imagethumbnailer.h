@@ -0,0 +1,46 @@
+#ifndef IMAGETHUMBNAILER_H
+#define IMAGETHUMBNAILER_H
+
+#include <QImage>
+#include <QString>
+#include <QUrl>
+
+#include "mauikit_export.h"
+
+namespace FMH
+{
+/**
+ * @brief The ImageThumbnailer class
+ * Makes the thumbnails of the images in process, with no KIO involved. The thumbnail embedded in the EXIF data of a
+ * photo is used when it is large enough, otherwise the image is decoded right at the size of the thumbnail, which for
+ * JPEG only decodes a fraction of the pixels instead of scaling down the full image.
+ * It is thread safe, and meant to be called from worker threads.
+ */
+class MAUIKIT_EXPORT ImageThumbnailer
+{
+public:
+    /**
+     * @brief canThumbnail
+     * @param url
+     * @return
+     * If it is a local file of an image type the image reader can decode
+     */
+    static bool canThumbnail(const QUrl &url);
+
+    /**
+     * @brief thumbnail
+     * @param path
+     * Local path of the image
+     * @param size
+     * Largest side of the thumbnail
+     * @return
+     * The thumbnail turned as the image is meant to be shown, null if it could not be read
+     */
+    static QImage thumbnail(const QString &path, const int &size);
+
+private:
+    static QImage exifThumbnail(const QString &path, const QSize &imageSize, const int &size);
+};
+}
+
+#endif // IMAGETHUMBNAILER_H
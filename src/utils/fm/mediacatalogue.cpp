@@ -0,0 +1,409 @@
+#include "mediacatalogue.h"
+#include "direnumerator.h"
+#include "dirwalker.h"
+#include "fileindex.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QtConcurrent>
+
+using namespace FMH;
+
+static const int SCHEMA_VERSION = 1;
+static const int UPDATE_DELAY = 1000; // ms, the changes are applied in batches
+static const qint64 CRAWL_INTERVAL = 7 * 24 * 3600 * 1000; // ms, what changed while no application was watching is caught up by then
+
+namespace
+{
+/**
+ * Connection to the catalogue for the current scope. The catalogue is read from worker threads and a connection
+ * can not be shared between threads, so each caller opens its own.
+ */
+class Connection
+{
+public:
+    explicit Connection(const QString &path)
+        : m_name(QStringLiteral("mediacatalogue_%1").arg(counter++))
+    {
+        db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), m_name);
+        db.setDatabaseName(path);
+        if (!db.open()) {
+            qWarning() << "ERROR OPENING MEDIA CATALOGUE" << db.lastError().text();
+            return;
+        }
+
+        // the readers do not block the writer, and a writer waits for the other one instead of failing
+        QSqlQuery query(db);
+        query.exec(QStringLiteral("PRAGMA journal_mode=WAL"));
+        query.exec(QStringLiteral("PRAGMA synchronous=NORMAL"));
+        query.exec(QStringLiteral("PRAGMA busy_timeout=5000"));
+    }
+
+    ~Connection()
+    {
+        db.close();
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(m_name);
+    }
+
+    QSqlDatabase db;
+
+private:
+    QString m_name;
+    static std::atomic<quint64> counter;
+};
+
+std::atomic<quint64> Connection::counter {0};
+}
+
+static QByteArray packItem(const FileItem &item)
+{
+    QByteArray res;
+    QDataStream out(&res, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_10);
+    out << item;
+    return res;
+}
+
+static bool storeItem(QSqlQuery &update, QSqlQuery &insert, const FileItem &item, const MediaCatalogue::TYPE &type, const qint64 &scan)
+{
+    const auto path = QUrl(item.url).toLocalFile();
+
+    // most files did not change since the last crawl, they only need to be marked as seen
+    update.bindValue(0, scan);
+    update.bindValue(1, path);
+    update.bindValue(2, item.modified);
+    update.bindValue(3, item.size);
+    if (update.exec() && update.numRowsAffected() > 0) {
+        return true;
+    }
+
+    insert.bindValue(0, path);
+    insert.bindValue(1, static_cast<int>(type));
+    insert.bindValue(2, item.label);
+    insert.bindValue(3, item.size);
+    insert.bindValue(4, item.modified);
+    insert.bindValue(5, item.created);
+    insert.bindValue(6, scan);
+    insert.bindValue(7, packItem(item));
+    if (!insert.exec()) {
+        qWarning() << "Could not catalogue" << path << insert.lastError().text();
+        return false;
+    }
+
+    return true;
+}
+
+static void prepare(QSqlDatabase &db, QSqlQuery &update, QSqlQuery &insert)
+{
+    update = QSqlQuery(db);
+    update.prepare(QStringLiteral("UPDATE files SET scan = ? WHERE path = ? AND modified = ? AND size = ?"));
+
+    insert = QSqlQuery(db);
+    insert.prepare(QStringLiteral("INSERT OR REPLACE INTO files (path, type, label, size, modified, created, scan, record) VALUES (?, ?, ?, ?, ?, ?, ?, ?)"));
+}
+
+// removes an entry and, if it was a directory, everything under it
+static void removePath(QSqlDatabase &db, const QString &path)
+{
+    QSqlQuery query(db);
+    query.prepare(QStringLiteral("DELETE FROM files WHERE path = ? OR (path > ? AND path < ?)"));
+    query.bindValue(0, path);
+    query.bindValue(1, path + QLatin1Char('/'));
+    query.bindValue(2, path + QLatin1Char('0')); // the character right after the slash
+    query.exec();
+}
+
+MediaCatalogue *MediaCatalogue::instance()
+{
+    static MediaCatalogue *catalogue = []() -> MediaCatalogue * {
+        const auto app = QCoreApplication::instance();
+        if (!app) {
+            return nullptr;
+        }
+
+        auto res = new MediaCatalogue;
+        res->moveToThread(app->thread());
+        return res;
+    }();
+
+    return catalogue;
+}
+
+MediaCatalogue::MediaCatalogue(QObject *parent)
+    : QObject(parent)
+    , m_updateTimer(new QTimer(this))
+{
+    m_updateTimer->setSingleShot(true);
+    m_updateTimer->setInterval(UPDATE_DELAY);
+    connect(m_updateTimer, &QTimer::timeout, this, [this]() {
+        const auto paths = m_changed.values();
+        m_changed.clear();
+        QtConcurrent::run([this, paths]() {
+            this->update(paths);
+        });
+    });
+}
+
+QString MediaCatalogue::filePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/mediacatalogue.db");
+}
+
+MediaCatalogue::TYPE MediaCatalogue::typeOf(const QString &mime)
+{
+    if (mime.startsWith(QStringLiteral("image/"))) {
+        return IMAGE;
+    }
+
+    if (mime.startsWith(QStringLiteral("video/"))) {
+        return VIDEO;
+    }
+
+    if (mime.startsWith(QStringLiteral("audio/"))) {
+        return AUDIO;
+    }
+
+    static const QStringList documentPrefixes = {QStringLiteral("application/vnd.oasis.opendocument."),
+                                                 QStringLiteral("application/vnd.openxmlformats-officedocument."),
+                                                 QStringLiteral("application/vnd.ms-"),
+                                                 QStringLiteral("application/msword"),
+                                                 QStringLiteral("application/epub+zip")};
+
+    if (DOCUMENT_MIMETYPES.contains(mime) || mime == QStringLiteral("text/plain") || mime == QStringLiteral("text/markdown")) {
+        return DOCUMENT;
+    }
+
+    for (const auto &prefix : documentPrefixes) {
+        if (mime.startsWith(prefix)) {
+            return DOCUMENT;
+        }
+    }
+
+    return NONE;
+}
+
+void MediaCatalogue::activate()
+{
+    if (!m_activated.exchange(true)) {
+        QMetaObject::invokeMethod(this, "start", Qt::QueuedConnection);
+    }
+}
+
+void MediaCatalogue::start()
+{
+    QDir().mkpath(QFileInfo(MediaCatalogue::filePath()).path());
+
+    {
+        Connection connection(MediaCatalogue::filePath());
+        if (!connection.db.isOpen()) {
+            return;
+        }
+
+        QSqlQuery query(connection.db);
+        query.exec(QStringLiteral("PRAGMA user_version"));
+        const auto version = query.next() ? query.value(0).toInt() : 0;
+
+        if (version != SCHEMA_VERSION) {
+            query.exec(QStringLiteral("DROP TABLE IF EXISTS files"));
+            query.exec(QStringLiteral("CREATE TABLE files (path TEXT PRIMARY KEY, type INTEGER NOT NULL, label TEXT NOT NULL, size INTEGER, modified INTEGER, created INTEGER, scan INTEGER, record BLOB) WITHOUT ROWID"));
+            query.exec(QStringLiteral("CREATE INDEX files_type_modified ON files (type, modified)"));
+            query.exec(QStringLiteral("CREATE INDEX files_type_created ON files (type, created)"));
+            query.exec(QStringLiteral("CREATE INDEX files_type_size ON files (type, size)"));
+            query.exec(QStringLiteral("CREATE INDEX files_type_label ON files (type, label COLLATE NOCASE)"));
+            query.exec(QStringLiteral("PRAGMA user_version = %1").arg(SCHEMA_VERSION));
+        }
+
+        // what the previous session catalogued is good enough to answer while the crawl checks it
+        query.exec(QStringLiteral("SELECT MAX(scan) FROM files"));
+        if (query.next() && !query.isNull(0)) {
+            m_scan = query.value(0).toLongLong();
+            m_ready = true;
+        }
+    }
+
+    if (const auto index = FileIndex::instance()) {
+        connect(index, &FileIndex::entryChanged, this, [this](const QString &path) {
+            m_changed.insert(path);
+            if (!m_updateTimer->isActive()) {
+                m_updateTimer->start();
+            }
+        });
+        index->activate();
+    }
+
+    // the stored rows and the changes reported by the index are trusted, until the catalogue gets too old
+    if (m_ready && QDateTime::currentMSecsSinceEpoch() - m_scan < CRAWL_INTERVAL) {
+        return;
+    }
+
+    QtConcurrent::run([this]() {
+        this->crawl();
+    });
+}
+
+void MediaCatalogue::crawl()
+{
+    Connection connection(MediaCatalogue::filePath());
+    if (!connection.db.isOpen()) {
+        return;
+    }
+
+    const auto scan = QDateTime::currentMSecsSinceEpoch();
+    m_scan = scan;
+
+    QSqlQuery update, insert;
+    prepare(connection.db, update, insert);
+
+    // a background job, it should leave the cores to whatever the user is doing
+    DirWalker walker({}, QDir::Files);
+    walker.setThreadCount(2);
+    walker.walk(FileIndex::defaultRoots(), [&](const FILE_LIST &batch) {
+        // one transaction per batch, so the readers see the progress
+        connection.db.transaction();
+        for (const auto &item : batch) {
+            const auto type = MediaCatalogue::typeOf(item.mime);
+            if (type != NONE) {
+                storeItem(update, insert, item, type, scan);
+            }
+        }
+        connection.db.commit();
+    });
+
+    // the files the crawl did not find are gone
+    QSqlQuery query(connection.db);
+    query.prepare(QStringLiteral("DELETE FROM files WHERE scan < ?"));
+    query.bindValue(0, scan);
+    query.exec();
+
+    m_ready = true;
+    QMetaObject::invokeMethod(this, &MediaCatalogue::ready, Qt::QueuedConnection);
+}
+
+void MediaCatalogue::update(const QStringList &paths)
+{
+    Connection connection(MediaCatalogue::filePath());
+    if (!connection.db.isOpen()) {
+        return;
+    }
+
+    const qint64 scan = m_scan;
+
+    QSqlQuery update, insert;
+    prepare(connection.db, update, insert);
+
+    DirEnumerator enumerator;
+    for (const auto &path : paths) {
+        const QFileInfo info(path);
+
+        connection.db.transaction();
+        if (!info.exists() || info.isDir()) {
+            // a directory moved in is crawled again, as nothing tells what it holds
+            removePath(connection.db, path);
+        }
+
+        if (info.isDir() && !info.isSymLink()) {
+            DirWalker walker({}, QDir::Files);
+            walker.setThreadCount(1);
+            walker.walk({path}, [&](const FILE_LIST &batch) {
+                for (const auto &item : batch) {
+                    const auto type = MediaCatalogue::typeOf(item.mime);
+                    if (type != NONE) {
+                        storeItem(update, insert, item, type, scan);
+                    }
+                }
+            });
+        } else if (info.exists()) {
+            const auto item = enumerator.fileItem(path);
+            const auto type = MediaCatalogue::typeOf(item.mime);
+            if (type != NONE) {
+                storeItem(update, insert, item, type, scan);
+            } else {
+                removePath(connection.db, path);
+            }
+        }
+        connection.db.commit();
+    }
+}
+
+bool MediaCatalogue::isReady() const
+{
+    return m_ready;
+}
+
+FILE_LIST MediaCatalogue::items(const TYPE &type, const MODEL_KEY &sortKey, const Qt::SortOrder &order, const int &offset, const int &limit) const
+{
+    FILE_LIST res;
+
+    QString column;
+    switch (sortKey) {
+    case MODEL_KEY::LABEL:
+        column = QStringLiteral("label COLLATE NOCASE");
+        break;
+    case MODEL_KEY::SIZE:
+        column = QStringLiteral("size");
+        break;
+    case MODEL_KEY::DATE:
+        column = QStringLiteral("created");
+        break;
+    default:
+        column = QStringLiteral("modified");
+        break;
+    }
+
+    const auto direction = order == Qt::AscendingOrder ? QStringLiteral("ASC") : QStringLiteral("DESC");
+
+    Connection connection(MediaCatalogue::filePath());
+    if (!connection.db.isOpen()) {
+        return res;
+    }
+
+    {
+        QSqlQuery query(connection.db);
+        query.setForwardOnly(true);
+        query.prepare(QStringLiteral("SELECT record FROM files WHERE type = ? ORDER BY %1 %2, path LIMIT ? OFFSET ?").arg(column, direction));
+        query.bindValue(0, static_cast<int>(type));
+        query.bindValue(1, limit);
+        query.bindValue(2, offset);
+
+        if (!query.exec()) {
+            qWarning() << "Could not read the media catalogue" << query.lastError().text();
+            return res;
+        }
+
+        while (query.next()) {
+            const auto record = query.value(0).toByteArray();
+            QDataStream in(record);
+            in.setVersion(QDataStream::Qt_5_10);
+
+            FileItem item;
+            in >> item;
+            if (in.status() == QDataStream::Ok) {
+                res << item;
+            }
+        }
+    }
+
+    return res;
+}
+
+int MediaCatalogue::count(const TYPE &type) const
+{
+    Connection connection(MediaCatalogue::filePath());
+    if (!connection.db.isOpen()) {
+        return 0;
+    }
+
+    QSqlQuery query(connection.db);
+    query.prepare(QStringLiteral("SELECT COUNT(*) FROM files WHERE type = ?"));
+    query.bindValue(0, static_cast<int>(type));
+    return query.exec() && query.next() ? query.value(0).toInt() : 0;
+}
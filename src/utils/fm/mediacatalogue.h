@@ -0,0 +1,115 @@
+#ifndef MEDIACATALOGUE_H
+#define MEDIACATALOGUE_H
+
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include <atomic>
+
+#include "fmh.h"
+#include "mauikit_export.h"
+
+class QTimer;
+
+namespace FMH
+{
+/**
+ * @brief The MediaCatalogue class
+ * Catalogue of the documents, images, videos and audio files under the default places, kept in an SQLite database in
+ * the cache location. Every file is stored along with its packed FileItem, so the pages of results are read back
+ * sorted and ready to be shown, without touching the files. Nothing is done until a media view first activates it.
+ * The changes reported by the FileIndex keep it current, and a background crawl only runs when there is no catalogue
+ * yet or it is a week old.
+ * Hidden files are not catalogued.
+ */
+class MAUIKIT_EXPORT MediaCatalogue : public QObject
+{
+    Q_OBJECT
+public:
+    enum TYPE : quint8 {
+        NONE,
+        DOCUMENT,
+        IMAGE,
+        VIDEO,
+        AUDIO
+    };
+
+    /**
+     * @brief instance
+     * The catalogue lives in the application thread, it does nothing until activated
+     * @return
+     * Null when there is no application
+     */
+    static MediaCatalogue *instance();
+
+    /**
+     * @brief activate
+     * Opens the catalogue, starts following the changes and crawls if needed. Only the first call does something
+     */
+    void activate();
+
+    /**
+     * @brief typeOf
+     * @param mime
+     * @return
+     * The class of media of the mime type, NONE if it is not catalogued
+     */
+    static TYPE typeOf(const QString &mime);
+
+    /**
+     * @brief isReady
+     * @return
+     * If a crawl has completed, in this session or in a previous one. Until then the results may be missing files
+     */
+    bool isReady() const;
+
+    /**
+     * @brief items
+     * A sorted page of the files of a class. It can be called from any thread
+     * @param type
+     * @param sortKey
+     * LABEL, SIZE, DATE or MODIFIED, any other key sorts by MODIFIED
+     * @param order
+     * @param offset
+     * @param limit
+     * Maximum number of items, -1 for no limit
+     * @return
+     */
+    FILE_LIST items(const TYPE &type, const MODEL_KEY &sortKey = MODEL_KEY::MODIFIED, const Qt::SortOrder &order = Qt::DescendingOrder, const int &offset = 0, const int &limit = -1) const;
+
+    /**
+     * @brief count
+     * @param type
+     * @return
+     * Number of files of a class
+     */
+    int count(const TYPE &type) const;
+
+signals:
+    /**
+     * @brief ready
+     * Emitted when a crawl completes
+     */
+    void ready();
+
+private:
+    explicit MediaCatalogue(QObject *parent = nullptr);
+
+    std::atomic<bool> m_activated {false};
+    std::atomic<bool> m_ready {false};
+    std::atomic<qint64> m_scan {0}; // id of the latest crawl, the rows it did not see are dropped at the end
+
+    QSet<QString> m_changed; // paths reported by the file index, applied in batches
+    QTimer *m_updateTimer;
+
+    Q_INVOKABLE void start();
+    void crawl();
+    void update(const QStringList &paths);
+
+    static QString filePath();
+};
+}
+
+#endif // MEDIACATALOGUE_H
@@ -0,0 +1,110 @@
+#include "metadataresolver.h"
+#include "direnumerator.h"
+
+#include <QFutureWatcher>
+#include <QTimer>
+#include <QUrl>
+#include <QtConcurrent>
+
+using namespace FMH;
+
+static const int BATCH_SIZE = 64;
+static const int GATHER_INTERVAL = 16; // ms, about a frame
+
+MetadataResolver::MetadataResolver(QObject *parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+{
+    qRegisterMetaType<FMH::FILE_LIST>("FMH::FILE_LIST");
+
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(GATHER_INTERVAL);
+    connect(m_timer, &QTimer::timeout, this, &MetadataResolver::flush);
+}
+
+MetadataResolver::~MetadataResolver()
+{
+    m_token.cancel();
+}
+
+void MetadataResolver::request(const QString &url)
+{
+    if (m_requested.contains(url)) {
+        return;
+    }
+
+    m_requested.insert(url);
+    m_queue << url;
+
+    if (!m_busy && !m_timer->isActive()) {
+        m_timer->start();
+    }
+}
+
+void MetadataResolver::clear()
+{
+    m_token.cancel();
+    m_token = CancelToken();
+    m_timer->stop();
+    m_queue.clear();
+    m_requested.clear();
+    m_busy = false;
+}
+
+void MetadataResolver::flush()
+{
+    if (m_queue.isEmpty() || m_busy) {
+        return;
+    }
+
+    const auto count = qMin(BATCH_SIZE, m_queue.size());
+    const auto urls = m_queue.mid(m_queue.size() - count);
+    m_queue.erase(m_queue.end() - count, m_queue.end());
+
+    m_busy = true;
+    const auto token = m_token;
+
+    auto watcher = new QFutureWatcher<FILE_LIST>;
+    connect(watcher, &QFutureWatcher<FILE_LIST>::finished, this, [this, watcher, token]() {
+        watcher->deleteLater();
+
+        // cleared meanwhile, a new batch may already be on its way
+        if (token.isCancelled()) {
+            return;
+        }
+
+        m_busy = false;
+
+        const auto items = watcher->future().result();
+        if (!items.isEmpty()) {
+            emit this->resolved(items);
+        }
+
+        if (!m_queue.isEmpty()) {
+            m_timer->start();
+        }
+    });
+
+    watcher->setFuture(QtConcurrent::run([urls, token]() -> FILE_LIST {
+        FILE_LIST res;
+        DirEnumerator enumerator;
+
+        for (const auto &url : urls) {
+            if (token.isCancelled()) {
+                break;
+            }
+
+            const QUrl path(url);
+            if (!path.isLocalFile()) {
+                continue;
+            }
+
+            const auto item = enumerator.fileItem(path.toLocalFile());
+            if (!item.isEmpty()) {
+                res << item;
+            }
+        }
+
+        return res;
+    }));
+}
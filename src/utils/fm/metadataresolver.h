@@ -0,0 +1,61 @@
+#ifndef METADATARESOLVER_H
+#define METADATARESOLVER_H
+
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include "fmh.h"
+#include "mauikit_export.h"
+
+class QTimer;
+
+namespace FMH
+{
+/**
+ * @brief The MetadataResolver class
+ * Completes the items listed in lazy mode, see DirEnumerator::setLazy. The views request the items they are about
+ * to show, the requests are gathered for a frame and then read in batches by a background thread. The most recent
+ * requests are served first, as they are the ones closest to what is on screen.
+ */
+class MAUIKIT_EXPORT MetadataResolver : public QObject
+{
+    Q_OBJECT
+public:
+    MetadataResolver(QObject *parent = nullptr);
+    ~MetadataResolver();
+
+    /**
+     * @brief request
+     * Queues a local file URL to be resolved, it can be called many times for the same URL
+     * @param url
+     */
+    void request(const QString &url);
+
+    /**
+     * @brief clear
+     * Drops the pending requests and the results of the batch being read, if any
+     */
+    void clear();
+
+signals:
+    /**
+     * @brief resolved
+     * @param items
+     * The complete items of a batch
+     */
+    void resolved(FMH::FILE_LIST items);
+
+private:
+    QTimer *m_timer;
+    QStringList m_queue;
+    QSet<QString> m_requested; // queued, being read or already resolved
+    CancelToken m_token;
+    bool m_busy = false;
+
+    void flush();
+};
+}
+
+#endif // METADATARESOLVER_H
@@ -0,0 +1,295 @@
+#include "thumbnailcache.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <limits>
+
+using namespace FMH;
+
+static const qint64 MEMORY_LIMIT = 128 * 1024 * 1024; // bytes
+static const int LATENCY_SAMPLES = 1000;
+static const QVector<QPair<int, QString>> BUCKETS = {{128, "normal"}, {256, "large"}, {512, "x-large"}, {1024, "xx-large"}};
+
+static QString thumbnailsPath()
+{
+    static const auto path = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/thumbnails";
+    return path;
+}
+
+// modification time of the file in seconds, -1 when it is gone. The remote ones are not checked
+static qint64 modifiedOf(const QUrl &url)
+{
+    if (!url.isLocalFile()) {
+        return 0;
+    }
+
+    const QFileInfo info(url.toLocalFile());
+    return info.exists() ? info.lastModified().toSecsSinceEpoch() : -1;
+}
+
+// the thumbnails of the thumbnails folder itself are not stored, nor the ones of remote files
+static bool isStorable(const QUrl &url)
+{
+    return url.isLocalFile() && !url.toLocalFile().startsWith(thumbnailsPath() + "/");
+}
+
+static QString diskPath(const QUrl &url, const int &bucket)
+{
+    const auto folder = std::find_if(BUCKETS.constBegin(), BUCKETS.constEnd(), [bucket](const QPair<int, QString> &value) {
+        return value.first == bucket;
+    });
+
+    const auto hash = QCryptographicHash::hash(url.toEncoded(), QCryptographicHash::Md5).toHex();
+    return QString("%1/%2/%3.png").arg(thumbnailsPath(), folder != BUCKETS.constEnd() ? folder->second : "large", QString::fromLatin1(hash));
+}
+
+static QString keyOf(const QUrl &url, const int &bucket)
+{
+    return url.toString() + "@" + QString::number(bucket);
+}
+
+ThumbnailCache *ThumbnailCache::instance()
+{
+    static ThumbnailCache *cache = []() -> ThumbnailCache * {
+        const auto app = QCoreApplication::instance();
+        if (!app) {
+            return nullptr;
+        }
+
+        auto res = new ThumbnailCache;
+        res->moveToThread(app->thread());
+        return res;
+    }();
+
+    return cache;
+}
+
+ThumbnailCache::ThumbnailCache(QObject *parent)
+    : QObject(parent)
+    , m_writer(new QThreadPool(this))
+    , m_hits(FAILED + 1, 0)
+{
+    // one at a time, the writes are not urgent
+    this->m_writer->setMaxThreadCount(1);
+    this->m_memory.setMaxCost(static_cast<int>(MEMORY_LIMIT / 1024));
+    this->m_latencies.reserve(LATENCY_SAMPLES);
+}
+
+int ThumbnailCache::bucket(const QSize &size)
+{
+    if (!size.isValid()) {
+        return 256;
+    }
+
+    const auto side = qMax(size.width(), size.height());
+    for (const auto &bucket : BUCKETS) {
+        if (side <= bucket.first) {
+            return bucket.first;
+        }
+    }
+
+    return BUCKETS.last().first;
+}
+
+QImage ThumbnailCache::find(const QUrl &url, const int &bucket)
+{
+    const auto key = keyOf(url, bucket);
+
+    {
+        QMutexLocker locker(&this->m_mutex);
+        if (!this->m_memory.contains(key)) {
+            return QImage();
+        }
+    }
+
+    const auto modified = modifiedOf(url);
+
+    QMutexLocker locker(&this->m_mutex);
+    const auto entry = this->m_memory.object(key);
+    if (!entry) {
+        return QImage();
+    }
+
+    if (entry->modified != modified) {
+        this->m_memory.remove(key);
+        return QImage();
+    }
+
+    return entry->image;
+}
+
+QImage ThumbnailCache::load(const QUrl &url, const int &bucket)
+{
+    if (!isStorable(url)) {
+        return QImage();
+    }
+
+    const auto modified = modifiedOf(url);
+    if (modified < 0) {
+        return QImage();
+    }
+
+    QImageReader reader(diskPath(url, bucket), "png");
+    if (!reader.canRead()) {
+        return QImage();
+    }
+
+    // the text chunks come before the pixels, so a stale thumbnail is never decoded
+    if (reader.text("Thumb::MTime").toLongLong() != modified || reader.text("Thumb::URI") != QString::fromUtf8(url.toEncoded())) {
+        return QImage();
+    }
+
+    const auto image = reader.read();
+    if (!image.isNull()) {
+        this->keep(keyOf(url, bucket), image, modified);
+    }
+
+    return image;
+}
+
+void ThumbnailCache::insert(const QUrl &url, const int &bucket, const QImage &image)
+{
+    if (image.isNull()) {
+        return;
+    }
+
+    const auto modified = modifiedOf(url);
+    if (modified < 0) {
+        return;
+    }
+
+    this->keep(keyOf(url, bucket), image, modified);
+
+    if (!isStorable(url)) {
+        return;
+    }
+
+    auto thumbnail = image.width() > bucket || image.height() > bucket ? image.scaled(bucket, bucket, Qt::KeepAspectRatio, Qt::SmoothTransformation) : image;
+    thumbnail.setText("Thumb::URI", QString::fromUtf8(url.toEncoded()));
+    thumbnail.setText("Thumb::MTime", QString::number(modified));
+    thumbnail.setText("Software", QCoreApplication::applicationName());
+
+    const auto path = diskPath(url, bucket);
+    QtConcurrent::run(this->m_writer, [thumbnail, path]() {
+        const auto folder = QFileInfo(path).path();
+        if (!QFileInfo::exists(folder)) {
+            QDir().mkpath(folder);
+            QFile::setPermissions(folder, QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner);
+        }
+
+        // written aside and renamed, so the other readers of the folder never see half a file
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            return;
+        }
+
+        file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+        if (thumbnail.save(&file, "PNG")) {
+            file.commit();
+        } else {
+            file.cancelWriting();
+        }
+    });
+}
+
+void ThumbnailCache::keep(const QString &key, const QImage &image, const qint64 &modified)
+{
+    auto entry = new Entry;
+    entry->image = image;
+    entry->modified = modified;
+
+    const auto cost = static_cast<int>(image.sizeInBytes() / 1024) + 1;
+
+    QMutexLocker locker(&this->m_mutex);
+    this->m_memory.insert(key, entry, cost);
+}
+
+void ThumbnailCache::record(const TIER &tier, const qint64 &msecs)
+{
+    QMutexLocker locker(&this->m_mutex);
+    this->m_hits[tier]++;
+
+    if (this->m_latencies.size() < LATENCY_SAMPLES) {
+        this->m_latencies << msecs;
+    } else {
+        this->m_latencies[this->m_latencyIndex] = msecs;
+        this->m_latencyIndex = (this->m_latencyIndex + 1) % LATENCY_SAMPLES;
+    }
+}
+
+QVariantMap ThumbnailCache::stats() const
+{
+    QMutexLocker locker(&this->m_mutex);
+    auto latencies = this->m_latencies;
+    const auto hits = this->m_hits;
+    const auto memory = static_cast<qint64>(this->m_memory.totalCost()) * 1024;
+    locker.unlock();
+
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&latencies](const int &value) -> qint64 {
+        return latencies.isEmpty() ? 0 : latencies.at(qMin(latencies.size() - 1, latencies.size() * value / 100));
+    };
+
+    quint64 total = 0;
+    for (const auto &count : hits) {
+        total += count;
+    }
+
+    const auto served = hits[MEMORY] + hits[DISK] + hits[COALESCED];
+
+    return QVariantMap({{"memoryHits", hits[MEMORY]},
+        {"diskHits", hits[DISK]},
+        {"coalesced", hits[COALESCED]},
+        {"generated", hits[GENERATED]},
+        {"failed", hits[FAILED]},
+        {"hitRatio", total > 0 ? double(served) / total : 0.0},
+        {"p50", percentile(50)},
+        {"p90", percentile(90)},
+        {"p99", percentile(99)},
+        {"memoryBytes", memory}});
+}
+
+void ThumbnailCache::resetStats()
+{
+    QMutexLocker locker(&this->m_mutex);
+    this->m_hits.fill(0);
+    this->m_latencies.clear();
+    this->m_latencyIndex = 0;
+}
+
+void ThumbnailCache::clear()
+{
+    QMutexLocker locker(&this->m_mutex);
+    this->m_memory.clear();
+}
+
+qint64 ThumbnailCache::memoryLimit() const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return static_cast<qint64>(this->m_memory.maxCost()) * 1024;
+}
+
+void ThumbnailCache::setMemoryLimit(const qint64 &bytes)
+{
+    const auto cost = static_cast<int>(qBound<qint64>(0, bytes / 1024, std::numeric_limits<int>::max()));
+
+    {
+        QMutexLocker locker(&this->m_mutex);
+        if (this->m_memory.maxCost() == cost) {
+            return;
+        }
+        this->m_memory.setMaxCost(cost);
+    }
+
+    emit this->memoryLimitChanged();
+}
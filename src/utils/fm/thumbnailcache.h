@@ -0,0 +1,147 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QUrl>
+#include <QVariantMap>
+#include <QVector>
+
+#include "mauikit_export.h"
+
+class QThreadPool;
+
+namespace FMH
+{
+/**
+ * @brief The ThumbnailCache class
+ * Two tiers of cached thumbnails. The first one keeps the decoded images in memory, the least recently used ones are
+ * dropped once they take more than the memory limit. The second one is the shared thumbnails folder of the
+ * freedesktop specification, ~/.cache/thumbnails, where each thumbnail is a PNG named after the MD5 of the file URI
+ * and only valid while it records the same modification time of the file.
+ * Thumbnails are kept in the sizes of the specification: 128, 256, 512 and 1024 pixels.
+ * It also keeps the numbers of hits and misses and the time taken to serve the requests, to tune the limits.
+ * It is thread safe.
+ */
+class MAUIKIT_EXPORT ThumbnailCache : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(qint64 memoryLimit READ memoryLimit WRITE setMemoryLimit NOTIFY memoryLimitChanged)
+
+public:
+    enum TIER : quint8 {
+        MEMORY,
+        DISK,
+        COALESCED, // served by a request for the same thumbnail that was already running
+        GENERATED,
+        FAILED
+    };
+    Q_ENUM(TIER)
+
+    /**
+     * @brief instance
+     * @return
+     * Null when there is no application
+     */
+    static ThumbnailCache *instance();
+
+    /**
+     * @brief bucket
+     * @param size
+     * Size requested
+     * @return
+     * The smallest size of the specification that covers the requested one, 256 when none was requested
+     */
+    static int bucket(const QSize &size);
+
+    /**
+     * @brief find
+     * Looks only in memory, it never touches the disk but to check the file did not change
+     * @param url
+     * @param bucket
+     * @return
+     * A null image when it is not cached
+     */
+    QImage find(const QUrl &url, const int &bucket);
+
+    /**
+     * @brief load
+     * Looks in the thumbnails folder, what is found is kept in memory too. It reads the disk, so it is meant for
+     * worker threads
+     * @param url
+     * @param bucket
+     * @return
+     * A null image when it is not cached or the file changed
+     */
+    QImage load(const QUrl &url, const int &bucket);
+
+    /**
+     * @brief insert
+     * Keeps a new thumbnail in memory, and writes it to the thumbnails folder on a worker thread
+     * @param url
+     * @param bucket
+     * @param image
+     */
+    void insert(const QUrl &url, const int &bucket, const QImage &image);
+
+    /**
+     * @brief record
+     * Counts a served request
+     * @param tier
+     * Where the thumbnail came from
+     * @param msecs
+     * Time from the request to the thumbnail
+     */
+    void record(const TIER &tier, const qint64 &msecs);
+
+    /**
+     * @brief stats
+     * @return
+     * The requests served from each tier, the hit ratio, the 50, 90 and 99 percentiles of the latency in ms of the
+     * last requests, and the memory in use
+     */
+    Q_INVOKABLE QVariantMap stats() const;
+
+    Q_INVOKABLE void resetStats();
+
+    /**
+     * @brief clear
+     * Drops the thumbnails kept in memory, the ones on disk are left
+     */
+    Q_INVOKABLE void clear();
+
+    /**
+     * @brief memoryLimit
+     * @return
+     * Bytes the images kept in memory can take
+     */
+    qint64 memoryLimit() const;
+    void setMemoryLimit(const qint64 &bytes);
+
+signals:
+    void memoryLimitChanged();
+
+private:
+    ThumbnailCache(QObject *parent = nullptr);
+
+    struct Entry {
+        QImage image;
+        qint64 modified = 0; // seconds since epoch, of the file
+    };
+
+    QThreadPool *m_writer;
+
+    mutable QMutex m_mutex;
+    QCache<QString, Entry> m_memory; // the cost is in KiB
+
+    QVector<quint64> m_hits;
+    QVector<qint64> m_latencies; // ring of the last ms taken
+    int m_latencyIndex = 0;
+
+    void keep(const QString &key, const QImage &image, const qint64 &modified);
+};
+}
+
+#endif // THUMBNAILCACHE_H
@@ -1,40 +1,324 @@
 #include "thumbnailer.h"
+#include "imagethumbnailer.h"
+#include "thumbnailcache.h"
 
 #if defined Q_OS_LINUX && !defined Q_OS_ANDROID
 #include <KIO/PreviewJob>
 #endif
 
+#include <QCoreApplication>
 #include <QDebug>
+#include <QHash>
 #include <QImage>
+#include <QMutex>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+using namespace FMH;
+
+// thumbnails made at once, more would only slow down the scrolling
+static const int MAX_RUNNING = qBound(2, QThread::idealThreadCount() / 2, 4);
+
+static QMutex mutex;
+static QHash<QString, ThumbnailJob *> jobs; // waiting or running, by url and size
+static QList<ThumbnailJob *> queue; // waiting, the first one goes first
+static int running = 0;
+
+static QThreadPool *pool()
+{
+    // never destroyed, like the jobs that may still use it
+    static QThreadPool *pool = []() {
+        auto res = new QThreadPool;
+        res->setMaxThreadCount(MAX_RUNNING);
+        return res;
+    }();
+
+    return pool;
+}
+
+static QString keyOf(const QUrl &url, const int &bucket)
+{
+    return url.toString() + "@" + QString::number(bucket);
+}
+
+Thumbnailer::Thumbnailer(const ThumbnailJob::BACKEND &backend)
+    : m_backend(backend)
+{
+}
 
 QQuickImageResponse * Thumbnailer::requestImageResponse(const QString & id, const QSize & requestedSize)
 {
-    AsyncImageResponse *response = new AsyncImageResponse(id, requestedSize);
+    AsyncImageResponse *response = new AsyncImageResponse(id, requestedSize, this->m_backend);
     return response;
 }
 
-AsyncImageResponse::AsyncImageResponse(const QString & id, const QSize & requestedSize)
+AsyncImageResponse::AsyncImageResponse(const QString & id, const QSize & requestedSize, const ThumbnailJob::BACKEND &backend)
     : m_id(id), m_requestedSize(requestedSize)
 {
+    this->m_timer.start();
+
+    auto url = QUrl::fromUserInput(id);
+    const auto priority = url.fragment() == QStringLiteral("prefetch") ? ThumbnailJob::PREFETCH : ThumbnailJob::VISIBLE;
+    url.setFragment(QString());
+
+    const auto bucket = ThumbnailCache::bucket(requestedSize);
+    const auto cache = ThumbnailCache::instance();
+
+    const auto image = cache ? cache->find(url, bucket) : QImage();
+    if (!image.isNull()) {
+        // the provider only listens once the response is returned
+        QMetaObject::invokeMethod(this, [this, image]() {
+            this->setImage(image, ThumbnailCache::MEMORY);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    this->m_key = ThumbnailJob::request(this, url, bucket, priority, backend, [this](const QImage &image, const int &tier) {
+        this->setImage(image, tier);
+    });
+}
+
+AsyncImageResponse::~AsyncImageResponse()
+{
+    if (!this->m_key.isEmpty()) {
+        ThumbnailJob::drop(this, this->m_key);
+    }
+}
+
+void AsyncImageResponse::setImage(const QImage &image, const int &tier)
+{
+    if (this->m_finished) {
+        return;
+    }
+
+    this->m_finished = true;
+    this->m_key.clear();
+
+    if (const auto cache = ThumbnailCache::instance()) {
+        cache->record(static_cast<ThumbnailCache::TIER>(tier), this->m_timer.elapsed());
+    }
+
+    // the cached sizes are the ones of the specification, which can be larger than the one requested
+    const auto larger = this->m_requestedSize.isValid() && (image.width() > this->m_requestedSize.width() || image.height() > this->m_requestedSize.height());
+    this->m_image = larger ? image.scaled(this->m_requestedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation) : image;
+
+    emit this->finished();
+}
+
+void AsyncImageResponse::cancel()
+{
+    if (this->m_finished) {
+        return;
+    }
+
+    this->m_finished = true;
+
+    if (!this->m_key.isEmpty()) {
+        ThumbnailJob::drop(this, this->m_key);
+        this->m_key.clear();
+    }
+
+    emit this->finished();
+}
+
+QQuickTextureFactory * AsyncImageResponse::textureFactory() const
+{
+    return QQuickTextureFactory::textureFactoryForImage(m_image);
+}
+
+QString AsyncImageResponse::errorString() const
+{
+    return this->m_image.isNull() ? QStringLiteral("No thumbnail for %1").arg(this->m_id) : QString();
+}
+
+ThumbnailJob::ThumbnailJob(const QUrl &url, const int &bucket, const PRIORITY &priority, const BACKEND &backend)
+    : QObject(nullptr)
+    , m_url(url)
+    , m_bucket(bucket)
+    , m_priority(priority)
+    , m_backend(backend)
+{
+    // the previews are made by jobs that need the event loop of the application
+    if (const auto app = QCoreApplication::instance()) {
+        this->moveToThread(app->thread());
+    }
+}
+
+QString ThumbnailJob::request(AsyncImageResponse *response, const QUrl &url, const int &bucket, const PRIORITY &priority, const BACKEND &backend, const Callback &callback)
+{
+    const auto key = keyOf(url, bucket);
+
+    QMutexLocker locker(&mutex);
+    auto job = jobs.value(key);
+    const auto shared = job != nullptr;
+
+    if (!shared) {
+        job = new ThumbnailJob(url, bucket, priority, backend);
+        jobs.insert(key, job);
+        ThumbnailJob::enqueue(job);
+
+    } else if (priority > job->m_priority) {
+        job->m_priority = priority;
+        if (queue.removeOne(job)) {
+            ThumbnailJob::enqueue(job);
+        }
+    }
+
+    job->m_waiters.insert(response);
+
+    // queued, as the response may be gone by the time the job is done
+    connect(job, &ThumbnailJob::done, response, [callback, shared](QImage image, int tier) {
+        callback(image, shared && !image.isNull() ? ThumbnailCache::COALESCED : tier);
+    }, Qt::QueuedConnection);
+
+    ThumbnailJob::schedule();
+    return key;
+}
+
+void ThumbnailJob::drop(const AsyncImageResponse *response, const QString &key)
+{
+    QMutexLocker locker(&mutex);
+    const auto job = jobs.value(key);
+    if (!job || !job->m_waiters.remove(response) || !job->m_waiters.isEmpty()) {
+        return;
+    }
+
+    // a new request for the same thumbnail gets a new job
+    jobs.remove(key);
+
+    if (queue.removeOne(job)) {
+        job->deleteLater();
+    } else {
+        job->cancel();
+    }
+}
+
+// before the ones of a lower priority, and of the same priority too as the latest requested are the likely visible
+void ThumbnailJob::enqueue(ThumbnailJob *job)
+{
+    auto index = 0;
+    while (index < queue.size() && queue.at(index)->m_priority > job->m_priority) {
+        index++;
+    }
+    queue.insert(index, job);
+}
+
+void ThumbnailJob::schedule()
+{
+    while (running < MAX_RUNNING && !queue.isEmpty()) {
+        running++;
+        queue.takeFirst()->start();
+    }
+}
+
+void ThumbnailJob::start()
+{
+    // the job is only deleted once done, so it can be reached from the work
+    QtConcurrent::run(pool(), [this]() {
+        if (this->m_token.isCancelled()) {
+            this->finish(QImage(), ThumbnailCache::FAILED);
+            return;
+        }
+
+        const auto cache = ThumbnailCache::instance();
+        const auto image = cache ? cache->load(this->m_url, this->m_bucket) : QImage();
+
+        if (!image.isNull()) {
+            this->finish(image, ThumbnailCache::DISK);
+            return;
+        }
+
+        // the images are made right here, on the worker
+        if (this->m_backend != KIO_PREVIEW && ImageThumbnailer::canThumbnail(this->m_url)) {
+            const auto thumbnail = this->m_token.isCancelled() ? QImage() : ImageThumbnailer::thumbnail(this->m_url.toLocalFile(), this->m_bucket);
+            if (cache) {
+                cache->insert(this->m_url, this->m_bucket, thumbnail);
+            }
+
+            this->finish(thumbnail, thumbnail.isNull() ? ThumbnailCache::FAILED : ThumbnailCache::GENERATED);
+            return;
+        }
+
+        if (this->m_backend == NATIVE) {
+            this->finish(QImage(), ThumbnailCache::FAILED);
+            return;
+        }
+
+        QMetaObject::invokeMethod(this, &ThumbnailJob::generate, Qt::QueuedConnection);
+    });
+}
+
+void ThumbnailJob::cancel()
+{
+    this->m_token.cancel();
+
+#if defined Q_OS_LINUX && !defined Q_OS_ANDROID
+    QMetaObject::invokeMethod(this, [this]() {
+        if (this->m_preview) {
+            this->m_preview->kill(KJob::EmitResult);
+        }
+    }, Qt::QueuedConnection);
+#endif
+}
+
+void ThumbnailJob::generate()
+{
+    if (this->m_token.isCancelled()) {
+        this->finish(QImage(), ThumbnailCache::FAILED);
+        return;
+    }
+
 #if defined Q_OS_LINUX && !defined Q_OS_ANDROID
     QStringList plugins = KIO::PreviewJob::defaultPlugins();
-    auto job = new KIO::PreviewJob(KFileItemList() << KFileItem(QUrl::fromUserInput (id)), requestedSize, &plugins);
+    auto job = new KIO::PreviewJob(KFileItemList() << KFileItem(this->m_url), QSize(this->m_bucket, this->m_bucket), &plugins);
+    this->m_preview = job;
+
+    // the thumbnails folder is written by the cache
+    job->setScaleType(KIO::PreviewJob::Scaled);
+
+    connect(job, &KIO::PreviewJob::gotPreview, this, [this](KFileItem, QPixmap pixmap) {
+        const auto image = pixmap.toImage();
+        if (const auto cache = ThumbnailCache::instance()) {
+            cache->insert(this->m_url, this->m_bucket, image);
+        }
+
+        this->finish(image, ThumbnailCache::GENERATED);
+    });
 
-    connect (job, &KIO::PreviewJob::gotPreview, [this](KFileItem, QPixmap pixmap) {
-        m_image = pixmap.toImage ();
-        emit this->finished ();
+    connect(job, &KIO::PreviewJob::failed, this, [this](KFileItem) {
+        this->finish(QImage(), ThumbnailCache::FAILED);
     });
 
-    connect (job, &KIO::PreviewJob::failed, [this](KFileItem) {
-        emit this->cancel ();
-        emit this->finished ();
+    // killed or done without a word
+    connect(job, &KJob::result, this, [this]() {
+        this->finish(QImage(), ThumbnailCache::FAILED);
     });
 
-    job->start ();
+    job->start();
+#else
+    this->finish(QImage(), ThumbnailCache::FAILED);
 #endif
 }
 
-QQuickTextureFactory * AsyncImageResponse::textureFactory() const
+void ThumbnailJob::finish(const QImage &image, const int &tier)
 {
-    return QQuickTextureFactory::textureFactoryForImage(m_image);
+    if (this->m_finished) {
+        return;
+    }
+    this->m_finished = true;
+
+    {
+        QMutexLocker locker(&mutex);
+        const auto key = keyOf(this->m_url, this->m_bucket);
+        if (jobs.value(key) == this) {
+            jobs.remove(key);
+        }
+
+        running--;
+        emit this->done(image, tier);
+        ThumbnailJob::schedule();
+    }
+
+    this->deleteLater();
 }
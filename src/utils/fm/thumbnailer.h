@@ -1,27 +1,156 @@
 #ifndef THUMBNAILER_H
 #define THUMBNAILER_H
 
+#include <QElapsedTimer>
 #include <QObject>
+#include <QPointer>
 #include <QQuickImageProvider>
+#include <QSet>
+#include <QUrl>
+
+#include <functional>
+
+#include "fmh.h"
+
+#if defined Q_OS_LINUX && !defined Q_OS_ANDROID
+namespace KIO
+{
+class PreviewJob;
+}
+#endif
+
+class AsyncImageResponse;
+
+/**
+ * @brief The ThumbnailJob class
+ * Looks for a thumbnail in the thumbnails folder and otherwise generates it. All the requests for the same thumbnail
+ * made while it waits or runs share the same job, which is dropped once none of them wants it anymore.
+ */
+class ThumbnailJob : public QObject
+{
+    Q_OBJECT
+public:
+    enum PRIORITY : quint8 {
+        PREFETCH, // near the visible items, it may be needed soon
+        VISIBLE
+    };
+
+    enum BACKEND : quint8 {
+        AUTO, // the images go in process, the rest through the KIO plugins
+        KIO_PREVIEW, // the KIO plugins only
+        NATIVE // in process only, the files that are not images get no thumbnail
+    };
+
+    /**
+     * Receives the thumbnail, in the thread of the context given along
+     */
+    typedef std::function<void(const QImage &image, const int &tier)> Callback;
+
+    /**
+     * @brief request
+     * Makes the response wait on the job of the thumbnail, queuing a new one if there is none
+     * @param response
+     * @param url
+     * @param bucket
+     * Size of the thumbnail, one of the ThumbnailCache
+     * @param priority
+     * A job waiting gets the highest priority of its responses
+     * @param backend
+     * Used when a new job is made
+     * @param callback
+     * Called with the response as context, so it is not called once the response is gone
+     * @return
+     * Key of the job, to drop it
+     */
+    static QString request(AsyncImageResponse *response, const QUrl &url, const int &bucket, const PRIORITY &priority, const BACKEND &backend, const Callback &callback);
+
+    /**
+     * @brief drop
+     * The response does not wait on the job anymore. Once no response waits on it, the job is removed from the queue,
+     * or cancelled if it runs
+     * @param response
+     * @param key
+     */
+    static void drop(const AsyncImageResponse *response, const QString &key);
+
+signals:
+    /**
+     * @brief done
+     * @param image
+     * Null when no thumbnail could be made
+     * @param tier
+     * Where the thumbnail came from, one of ThumbnailCache::TIER
+     */
+    void done(QImage image, int tier);
+
+private:
+    ThumbnailJob(const QUrl &url, const int &bucket, const PRIORITY &priority, const BACKEND &backend);
+
+    QUrl m_url;
+    int m_bucket;
+    PRIORITY m_priority;
+    BACKEND m_backend;
+    QSet<const AsyncImageResponse *> m_waiters;
+
+    FMH::CancelToken m_token;
+    bool m_finished = false;
+
+#if defined Q_OS_LINUX && !defined Q_OS_ANDROID
+    QPointer<KIO::PreviewJob> m_preview;
+#endif
+
+    static void enqueue(ThumbnailJob *job);
+    static void schedule();
+
+    void start();
+    void cancel();
+    void generate();
+    void finish(const QImage &image, const int &tier);
+};
 
 class AsyncImageResponse : public QQuickImageResponse
 {
 public:
-    AsyncImageResponse(const QString &id, const QSize &requestedSize);
+    AsyncImageResponse(const QString &id, const QSize &requestedSize, const ThumbnailJob::BACKEND &backend);
+    ~AsyncImageResponse() override;
     QQuickTextureFactory *textureFactory() const override;
+    QString errorString() const override;
+
+public slots:
+    /**
+     * @brief cancel
+     * The item went away, its job is dropped unless other items wait on it
+     */
+    void cancel() override;
 
 private:
     QString m_id;
     QSize m_requestedSize;
     QImage m_image;
-};
+    QElapsedTimer m_timer;
+    QString m_key; // of the job waited on, empty when there is none
+    bool m_finished = false;
 
+    void setImage(const QImage &image, const int &tier);
+};
 
+/**
+ * @brief The Thumbnailer class
+ * Provides the thumbnails of image://thumbnailer/<url>. The requests are served from the ThumbnailCache, the rest go
+ * through a queue that only lets a few thumbnails be made at once. The visible items go first, and among them the
+ * latest ones, as the older ones are likely to be scrolled away already. Adding a #prefetch fragment to the url
+ * requests the thumbnail of an item near the visible ones, it waits for all the visible ones to be started.
+ * The thumbnails are made by the backend given, by default the images are decoded in process by the ImageThumbnailer
+ * and the other files go through the KIO plugins, where there is KIO.
+ */
 class Thumbnailer : public QQuickAsyncImageProvider
 {
 public:
+    Thumbnailer(const ThumbnailJob::BACKEND &backend = ThumbnailJob::AUTO);
     QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
 
+private:
+    ThumbnailJob::BACKEND m_backend;
 };
 
 #endif // THUMBNAILER_H
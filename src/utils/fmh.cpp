@@ -7,6 +7,11 @@
  */
 #include "fmh.h"
 #include "fmstatic.h"
+#include "dirconfcache.h"
+#include "mimecache.h"
+
+#include <QReadWriteLock>
+#include <QSet>
 
 
 namespace FMH
@@ -84,6 +89,352 @@ const QStringList modelToList(const FMH::MODEL_LIST &list, const FMH::MODEL_KEY
     });
 }
 
+static const int INTERN_SHARDS = 16; // the threads listing at once rarely wait on the same lock
+static const int INTERN_SHARD_LIMIT = 512; // strings per shard
+
+struct InternShard {
+    QReadWriteLock lock;
+    QSet<QString> strings;
+};
+
+const QString internString(const QString &value)
+{
+    if (value.isEmpty()) {
+        return QString();
+    }
+
+    static InternShard shards[INTERN_SHARDS];
+    auto &shard = shards[qHash(value) % INTERN_SHARDS];
+
+    // the values are nearly always there already, so most calls only take the read lock
+    {
+        QReadLocker locker(&shard.lock);
+        const auto it = shard.strings.constFind(value);
+        if (it != shard.strings.constEnd()) {
+            return *it;
+        }
+    }
+
+    QWriteLocker locker(&shard.lock);
+    const auto it = shard.strings.constFind(value);
+    if (it != shard.strings.constEnd()) {
+        return *it;
+    }
+
+    // once full, the strings nobody else holds anymore make room
+    if (shard.strings.size() >= INTERN_SHARD_LIMIT) {
+        for (auto string = shard.strings.begin(); string != shard.strings.end();) {
+            if (string->isDetached()) {
+                string = shard.strings.erase(string);
+            } else {
+                ++string;
+            }
+        }
+
+        if (shard.strings.size() >= INTERN_SHARD_LIMIT) {
+            return value;
+        }
+    }
+
+    shard.strings.insert(value);
+    return value;
+}
+
+static inline QString boolString(const bool &value)
+{
+    return value ? QStringLiteral("true") : QStringLiteral("false");
+}
+
+static inline QString dateString(const qint64 &secs)
+{
+    return secs > 0 ? QDateTime::fromSecsSinceEpoch(secs).toString(Qt::TextDate) : QString();
+}
+
+static inline qint64 dateSecs(const QDateTime &date)
+{
+    return date.isValid() ? date.toSecsSinceEpoch() : 0;
+}
+
+static const QHash<MODEL_KEY, FileItem::FLAG> FILE_ITEM_FLAGS = {{MODEL_KEY::IS_DIR, FileItem::IS_DIR},
+    {MODEL_KEY::IS_FILE, FileItem::IS_FILE},
+    {MODEL_KEY::IS_SYMLINK, FileItem::IS_SYMLINK},
+    {MODEL_KEY::HIDDEN, FileItem::HIDDEN},
+    {MODEL_KEY::READABLE, FileItem::READABLE},
+    {MODEL_KEY::WRITABLE, FileItem::WRITABLE},
+    {MODEL_KEY::EXECUTABLE, FileItem::EXECUTABLE},
+    {MODEL_KEY::BOOK, FileItem::BOOK}};
+
+static const QVector<MODEL_KEY> FILE_ITEM_KEYS = {MODEL_KEY::LABEL,
+    MODEL_KEY::NAME,
+    MODEL_KEY::SUFFIX,
+    MODEL_KEY::DATE,
+    MODEL_KEY::MODIFIED,
+    MODEL_KEY::LAST_READ,
+    MODEL_KEY::PATH,
+    MODEL_KEY::URL,
+    MODEL_KEY::THUMBNAIL,
+    MODEL_KEY::SYMLINK,
+    MODEL_KEY::IS_SYMLINK,
+    MODEL_KEY::HIDDEN,
+    MODEL_KEY::IS_DIR,
+    MODEL_KEY::IS_FILE,
+    MODEL_KEY::WRITABLE,
+    MODEL_KEY::READABLE,
+    MODEL_KEY::EXECUTABLE,
+    MODEL_KEY::MIME,
+    MODEL_KEY::GROUP,
+    MODEL_KEY::ICON,
+    MODEL_KEY::SIZE,
+    MODEL_KEY::OWNER,
+    MODEL_KEY::NICKNAME,
+    MODEL_KEY::BOOK,
+    MODEL_KEY::COUNT};
+
+bool FileItem::isEmpty() const
+{
+    return this->url.isEmpty();
+}
+
+bool FileItem::is(const FileItem::FLAG &flag) const
+{
+    return this->flags & flag;
+}
+
+void FileItem::setFlag(const FileItem::FLAG &flag, const bool &value)
+{
+    if (value) {
+        this->flags |= flag;
+    } else {
+        this->flags &= ~flag;
+    }
+}
+
+const QString FileItem::value(const MODEL_KEY &key) const
+{
+    switch (key) {
+    case MODEL_KEY::LABEL:
+        return this->label;
+    case MODEL_KEY::NAME: {
+        const auto index = this->label.lastIndexOf(QLatin1Char('.'));
+        return index > 0 ? this->label.left(index) : this->label;
+    }
+    case MODEL_KEY::SUFFIX: {
+        const auto index = this->label.lastIndexOf(QLatin1Char('.'));
+        return index > 0 ? this->label.mid(index) : QString();
+    }
+    case MODEL_KEY::DATE:
+        return dateString(this->created);
+    case MODEL_KEY::MODIFIED:
+        return dateString(this->modified);
+    case MODEL_KEY::LAST_READ:
+        return dateString(this->lastRead);
+    case MODEL_KEY::PATH:
+    case MODEL_KEY::URL:
+    case MODEL_KEY::NICKNAME:
+        return this->url;
+    case MODEL_KEY::THUMBNAIL:
+        return this->thumbnail;
+    case MODEL_KEY::SYMLINK:
+        return this->symlink;
+    case MODEL_KEY::MIME:
+        return this->mime;
+    case MODEL_KEY::GROUP:
+        return this->group;
+    case MODEL_KEY::ICON:
+        return this->icon;
+    case MODEL_KEY::OWNER:
+        return this->owner;
+    case MODEL_KEY::SIZE:
+        return QString::number(this->size);
+    case MODEL_KEY::COUNT:
+        return QString::number(this->count);
+    default:
+        break;
+    }
+
+    if (FILE_ITEM_FLAGS.contains(key)) {
+        return boolString(this->is(FILE_ITEM_FLAGS[key]));
+    }
+
+    return this->extra.value(key);
+}
+
+const QVariant FileItem::data(const MODEL_KEY &key) const
+{
+    switch (key) {
+    case MODEL_KEY::DATE:
+        return this->created > 0 ? QVariant(QDateTime::fromSecsSinceEpoch(this->created)) : QVariant(QString());
+    case MODEL_KEY::MODIFIED:
+        return this->modified > 0 ? QVariant(QDateTime::fromSecsSinceEpoch(this->modified)) : QVariant(QString());
+    default:
+        return this->value(key);
+    }
+}
+
+void FileItem::insert(const MODEL_KEY &key, const QString &value)
+{
+    switch (key) {
+    case MODEL_KEY::LABEL:
+        this->label = value;
+        return;
+    case MODEL_KEY::NAME:
+    case MODEL_KEY::SUFFIX:
+    case MODEL_KEY::NICKNAME:
+        return; // derived from the label and the url
+    case MODEL_KEY::DATE:
+        this->created = dateSecs(QDateTime::fromString(value, Qt::TextDate));
+        return;
+    case MODEL_KEY::MODIFIED:
+        this->modified = dateSecs(QDateTime::fromString(value, Qt::TextDate));
+        return;
+    case MODEL_KEY::LAST_READ:
+        this->lastRead = dateSecs(QDateTime::fromString(value, Qt::TextDate));
+        return;
+    case MODEL_KEY::PATH:
+    case MODEL_KEY::URL:
+        this->url = value;
+        return;
+    case MODEL_KEY::THUMBNAIL:
+        this->thumbnail = value;
+        return;
+    case MODEL_KEY::SYMLINK:
+        this->symlink = value;
+        return;
+    case MODEL_KEY::MIME:
+        this->mime = internString(value);
+        return;
+    case MODEL_KEY::GROUP:
+        this->group = internString(value);
+        return;
+    case MODEL_KEY::ICON:
+        this->icon = internString(value);
+        return;
+    case MODEL_KEY::OWNER:
+        this->owner = internString(value);
+        return;
+    case MODEL_KEY::SIZE:
+        this->size = value.toLongLong();
+        return;
+    case MODEL_KEY::COUNT:
+        this->count = value.toInt();
+        return;
+    default:
+        break;
+    }
+
+    if (FILE_ITEM_FLAGS.contains(key)) {
+        this->setFlag(FILE_ITEM_FLAGS[key], value == QStringLiteral("true"));
+        return;
+    }
+
+    this->extra.insert(key, value);
+}
+
+const QVector<int> FileItem::roles() const
+{
+    QVector<int> res;
+    res.reserve(FILE_ITEM_KEYS.size() + this->extra.size());
+    for (const auto &key : FILE_ITEM_KEYS) {
+        res << key;
+    }
+
+    res << modelRoles(this->extra);
+    return res;
+}
+
+const MODEL FileItem::toModel() const
+{
+    MODEL model;
+    if (this->isEmpty()) {
+        return model;
+    }
+
+    model.reserve(FILE_ITEM_KEYS.size() + this->extra.size());
+    for (const auto &key : FILE_ITEM_KEYS) {
+        model.insert(key, this->value(key));
+    }
+
+    for (auto it = this->extra.constBegin(); it != this->extra.constEnd(); ++it) {
+        model.insert(it.key(), it.value());
+    }
+
+    return model;
+}
+
+FileItem FileItem::fromModel(const MODEL &model)
+{
+    FileItem item;
+    for (auto it = model.constBegin(); it != model.constEnd(); ++it) {
+        item.insert(it.key(), it.value());
+    }
+
+    // the path and the url are expected to be the same, but prefer the url if both are present
+    if (model.contains(MODEL_KEY::URL)) {
+        item.url = model[MODEL_KEY::URL];
+    }
+
+    return item;
+}
+
+const FILE_LIST toFileList(const MODEL_LIST &list)
+{
+    FILE_LIST res;
+    res.reserve(list.size());
+    for (const auto &model : list) {
+        res << FileItem::fromModel(model);
+    }
+
+    return res;
+}
+
+const MODEL_LIST toModelList(const FILE_LIST &list)
+{
+    MODEL_LIST res;
+    res.reserve(list.size());
+    for (const auto &item : list) {
+        res << item.toModel();
+    }
+
+    return res;
+}
+
+QDataStream &operator<<(QDataStream &out, const FileItem &item)
+{
+    out << item.url << item.label << item.thumbnail << item.symlink << item.mime << item.icon << item.owner << item.group;
+    out << item.size << item.modified << item.created << item.lastRead << item.count << item.flags;
+
+    out << static_cast<qint32>(item.extra.size());
+    for (auto it = item.extra.constBegin(); it != item.extra.constEnd(); ++it) {
+        out << static_cast<qint32>(it.key()) << it.value();
+    }
+
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, FileItem &item)
+{
+    item = FileItem();
+    in >> item.url >> item.label >> item.thumbnail >> item.symlink >> item.mime >> item.icon >> item.owner >> item.group;
+    in >> item.size >> item.modified >> item.created >> item.lastRead >> item.count >> item.flags;
+
+    // the repeated strings are shared with the rest of the listings
+    item.mime = internString(item.mime);
+    item.icon = internString(item.icon);
+    item.owner = internString(item.owner);
+    item.group = internString(item.group);
+
+    qint32 extra = 0;
+    in >> extra;
+    for (qint32 i = 0; i < extra && in.status() == QDataStream::Ok; i++) {
+        qint32 key;
+        QString value;
+        in >> key >> value;
+        item.extra.insert(static_cast<MODEL_KEY>(key), value);
+    }
+
+    return in;
+}
+
 bool isAndroid()
 {
 #if defined(Q_OS_ANDROID)
@@ -171,68 +522,59 @@ const QUrl parentDir(const QUrl &path)
     return QUrl::fromLocalFile(dir.absolutePath());
 }
 
-const QVariantMap dirConf(const QUrl &path)
+// the configuration of a directory out of the groups of its .directory file
+static const QVariantMap toDirConf(const DirConfCache::Groups &groups)
 {
-    if (!path.isLocalFile()) {
-        qWarning() << "URL recived is not a local file" << path;
-        return QVariantMap();
-    }
-
-    if (!fileExists(path)) {
+    if (groups.isEmpty()) {
         return QVariantMap();
     }
 
-    QString icon, iconsize, hidden, detailview, showthumbnail, showterminal;
-
-    uint count = 0, sortby = MODEL_KEY::MODIFIED, viewType = 0;
+    const auto entry = groups.value("Desktop Entry");
+    const auto settings = groups.value("Settings");
+    const auto maui = groups.value("MAUIFM");
 
-    bool foldersFirst = false;
-
-#if defined Q_OS_ANDROID || defined Q_OS_WIN32 || defined Q_OS_MACOS || defined Q_OS_IOS
-    QSettings file(path.toLocalFile(), QSettings::Format::NativeFormat);
-    file.beginGroup(QString("Desktop Entry"));
-    icon = file.value("Icon").toString();
-    file.endGroup();
-
-    file.beginGroup(QString("Settings"));
-    hidden = file.value("HiddenFilesShown").toString();
-    file.endGroup();
-
-    file.beginGroup(QString("MAUIFM"));
-    iconsize = file.value("IconSize").toString();
-    detailview = file.value("DetailView").toString();
-    showthumbnail = file.value("ShowThumbnail").toString();
-    showterminal = file.value("ShowTerminal").toString();
-    count = file.value("Count").toInt();
-    sortby = file.value("SortBy").toInt();
-    foldersFirst = file.value("FoldersFirst").toBool();
-    viewType = file.value("ViewType").toInt();
-    file.endGroup();
-
-#else
-    KConfig file(path.toLocalFile());
-    icon = file.entryMap(QString("Desktop Entry"))["Icon"];
-    hidden = file.entryMap(QString("Settings"))["HiddenFilesShown"];
-    iconsize = file.entryMap(QString("MAUIFM"))["IconSize"];
-    detailview = file.entryMap(QString("MAUIFM"))["DetailView"];
-    showthumbnail = file.entryMap(QString("MAUIFM"))["ShowThumbnail"];
-    showterminal = file.entryMap(QString("MAUIFM"))["ShowTerminal"];
-    count = file.entryMap(QString("MAUIFM"))["Count"].toInt();
-    sortby = file.entryMap(QString("MAUIFM"))["SortBy"].toInt();
-    foldersFirst = file.entryMap(QString("MAUIFM"))["FoldersFirst"] == "true" ? true : false;
-    viewType = file.entryMap(QString("MAUIFM"))["ViewType"].toInt();
-#endif
+    const auto icon = entry.value("Icon");
+    const auto hidden = settings.value("HiddenFilesShown");
+    const auto showterminal = maui.value("ShowTerminal");
+    const auto showthumbnail = maui.value("ShowThumbnail");
+    const auto detailview = maui.value("DetailView");
 
     return QVariantMap({{MODEL_NAME[MODEL_KEY::ICON], icon.isEmpty() ? "folder" : icon},
-        {MODEL_NAME[MODEL_KEY::ICONSIZE], iconsize},
-        {MODEL_NAME[MODEL_KEY::COUNT], count},
+        {MODEL_NAME[MODEL_KEY::ICONSIZE], maui.value("IconSize")},
+        {MODEL_NAME[MODEL_KEY::COUNT], maui.value("Count").toUInt()},
         {MODEL_NAME[MODEL_KEY::SHOWTERMINAL], showterminal.isEmpty() ? "false" : showterminal},
         {MODEL_NAME[MODEL_KEY::SHOWTHUMBNAIL], showthumbnail.isEmpty() ? "false" : showthumbnail},
         {MODEL_NAME[MODEL_KEY::DETAILVIEW], detailview.isEmpty() ? "false" : detailview},
-        {MODEL_NAME[MODEL_KEY::HIDDEN], hidden.isEmpty() ? false : (hidden == "true" ? true : false)},
-        {MODEL_NAME[MODEL_KEY::SORTBY], sortby},
-        {MODEL_NAME[MODEL_KEY::FOLDERSFIRST], foldersFirst},
-        {MODEL_NAME[MODEL_KEY::VIEWTYPE], viewType}});
+        {MODEL_NAME[MODEL_KEY::HIDDEN], hidden == "true"},
+        {MODEL_NAME[MODEL_KEY::SORTBY], maui.value("SortBy").toUInt()},
+        {MODEL_NAME[MODEL_KEY::FOLDERSFIRST], maui.value("FoldersFirst") == "true"},
+        {MODEL_NAME[MODEL_KEY::VIEWTYPE], maui.value("ViewType").toUInt()}});
+}
+
+const QVariantMap dirConf(const QUrl &path)
+{
+    if (!path.isLocalFile()) {
+        qWarning() << "URL recived is not a local file" << path;
+        return QVariantMap();
+    }
+
+    return toDirConf(DirConfCache::read(path.toLocalFile()));
+}
+
+const QVector<QVariantMap> dirConfs(const QList<QUrl> &paths)
+{
+    QStringList files;
+    for (const auto &path : paths) {
+        files << (path.isLocalFile() ? path.toLocalFile() : QString());
+    }
+
+    QVector<QVariantMap> res;
+    const auto groups = DirConfCache::readAll(files);
+    for (const auto &group : groups) {
+        res << toDirConf(group);
+    }
+
+    return res;
 }
 
 void setDirConf(const QUrl &path, const QString &group, const QString &key, const QVariant &value)
@@ -242,18 +584,7 @@ void setDirConf(const QUrl &path, const QString &group, const QString &key, cons
         return;
     }
 
-#if defined Q_OS_ANDROID || defined Q_OS_WIN32 || defined Q_OS_MACOS || defined Q_OS_IOS
-    QSettings file(path.toLocalFile(), QSettings::Format::IniFormat);
-    file.beginGroup(group);
-    file.setValue(key, value);
-    file.endGroup();
-    file.sync();
-#else
-    KConfig file(path.toLocalFile(), KConfig::SimpleConfig);
-    auto kgroup = file.group(group);
-    kgroup.writeEntry(key, value);
-    file.sync();
-#endif
+    DirConfCache::write(path.toLocalFile(), group, key, value);
 }
 
 const QString getIconName(const QUrl &path)
@@ -268,10 +599,13 @@ const QString getIconName(const QUrl &path)
 
     } else {
 #if defined Q_OS_ANDROID || defined Q_OS_WIN32 || defined Q_OS_MACOS || defined Q_OS_IOS
-        QMimeDatabase mime;
-        const auto type = mime.mimeTypeForFile(path.toString());
-        return type.iconName();
+        return MimeCache::lookup(path.toLocalFile()).icon;
 #else
+        // desktop files carry their own icon
+        if (path.isLocalFile() && !path.fileName().endsWith(QStringLiteral(".desktop"))) {
+            return MimeCache::lookup(path.toLocalFile()).icon;
+        }
+
         KFileItem mime(path);
         return mime.iconName();
 #endif
@@ -285,8 +619,7 @@ const QString getMime(const QUrl &path)
         return QString();
     }
 
-    const QMimeDatabase mimedb;
-    return mimedb.mimeTypeForFile(path.toLocalFile()).name();
+    return MimeCache::lookup(path.toLocalFile()).name;
 }
 
 
@@ -306,99 +639,128 @@ const QUrl thumbnailUrl(const QUrl &url, const QString &mimetype)
 }
 
 #if !defined Q_OS_ANDROID && defined Q_OS_LINUX
-const FMH::MODEL getFileInfo(const KFileItem &kfile)
+/**
+ * Mime type and icon of a listed item. Local files go through the MimeCache with the inode KIO has already read,
+ * instead of letting the KFileItem look into every file again
+ */
+static MimeCache::Entry kfileMime(const KFileItem &kfile)
 {
-    QString fileHidden = QVariant(kfile.isHidden()).toString();
-    QString fileThumbnailUrl = thumbnailUrl(kfile.mostLocalUrl(), kfile.mimetype()).toString();
-    QString filePath = kfile.mostLocalUrl().toString();
-    QString fileNickName = filePath;
-    QString fileLabel = kfile.name();
-    QString fileCount = kfile.isLocalFile() && kfile.isDir() ? QString::number(QDir(kfile.localPath()).count() - 2) : "0";
-    if (filePath.contains("trash:/") && fileLabel.indexOf("-") != -1) {
-        fileLabel = fileLabel.mid(fileLabel.indexOf("-") + 1, fileLabel.length() + 1);
-        if (fileLabel.startsWith(".") && fileLabel.endsWith(".jpg")) {
-            fileHidden = "true";
+    if (kfile.isLocalFile() && !kfile.isDir() && !kfile.isMimeTypeKnown() && !kfile.name().endsWith(QStringLiteral(".desktop"))) {
+        const auto entry = kfile.entry();
+
+        MimeCache::Key key;
+        key.device = static_cast<quint64>(entry.numberValue(KIO::UDSEntry::UDS_DEVICE_ID, 0));
+        key.inode = static_cast<quint64>(entry.numberValue(KIO::UDSEntry::UDS_INODE, 0));
+        key.modified = entry.numberValue(KIO::UDSEntry::UDS_MODIFICATION_TIME, 0);
+        key.size = static_cast<qint64>(kfile.size());
+
+        if (key.inode != 0) {
+            return MimeCache::lookup(kfile.localPath(), key);
         }
-        filePath = HomePath + "/.local/share/Trash/files/" + fileLabel;
-        fileThumbnailUrl = filePath;
-        QString fileInfoPath = filePath;
+    }
+
+    return {kfile.mimetype(), kfile.iconName()};
+}
+
+const FileItem getFileItem(const KFileItem &kfile)
+{
+    const auto type = kfileMime(kfile);
+
+    FileItem item;
+    item.url = kfile.mostLocalUrl().toString();
+    item.label = kfile.name();
+    item.mime = internString(type.name);
+    item.thumbnail = thumbnailUrl(kfile.mostLocalUrl(), item.mime).toString();
+    item.count = kfile.isLocalFile() && kfile.isDir() ? QDir(kfile.localPath()).count() - 2 : 0;
+    item.setFlag(FileItem::HIDDEN, kfile.isHidden());
+
+    if (item.url.contains("trash:/") && item.label.indexOf("-") != -1) {
+        item.label = item.label.mid(item.label.indexOf("-") + 1, item.label.length() + 1);
+        if (item.label.startsWith(".") && item.label.endsWith(".jpg")) {
+            item.setFlag(FileItem::HIDDEN);
+        }
+        item.url = HomePath + "/.local/share/Trash/files/" + item.label;
+        item.thumbnail = item.url;
+        QString fileInfoPath = item.url;
         if (fileInfoPath.startsWith("file://")) {
             fileInfoPath = fileInfoPath.mid(7);
         }
         QFileInfo trashFile(fileInfoPath);
         if (!trashFile.exists()) {
-            return MODEL{};
+            return FileItem();
         }
-        fileCount = trashFile.isDir() ? QString::number(QDir(fileInfoPath).count()) : "0";
-    }
-
-    return MODEL {{MODEL_KEY::LABEL, fileLabel},
-        {MODEL_KEY::NAME, kfile.name().remove(kfile.name().lastIndexOf("."), kfile.name().size())},
-        {MODEL_KEY::SUFFIX, kfile.name().remove(0,kfile.name().lastIndexOf("."))},
-        {MODEL_KEY::DATE, kfile.time(KFileItem::FileTimes::CreationTime).toString(Qt::TextDate)},
-        {MODEL_KEY::MODIFIED, kfile.time(KFileItem::FileTimes::ModificationTime).toString(Qt::TextDate)},
-        {MODEL_KEY::LAST_READ, kfile.time(KFileItem::FileTimes::AccessTime).toString(Qt::TextDate)},
-        {MODEL_KEY::PATH, filePath},
-        {MODEL_KEY::URL, filePath},
-        {MODEL_KEY::THUMBNAIL, fileThumbnailUrl},
-        {MODEL_KEY::SYMLINK, kfile.linkDest()},
-        {MODEL_KEY::IS_SYMLINK, QVariant(kfile.isLink()).toString()},
-        {MODEL_KEY::HIDDEN, fileHidden},
-        {MODEL_KEY::IS_DIR, QVariant(kfile.isDir()).toString()},
-        {MODEL_KEY::IS_FILE, QVariant(kfile.isFile()).toString()},
-        {MODEL_KEY::WRITABLE, QVariant(kfile.isWritable()).toString()},
-        {MODEL_KEY::READABLE, QVariant(kfile.isReadable()).toString()},
-        {MODEL_KEY::EXECUTABLE, QVariant(kfile.isDesktopFile()).toString()},
-        {MODEL_KEY::MIME, kfile.mimetype()},
-        {MODEL_KEY::GROUP, kfile.group()},
-        {MODEL_KEY::ICON, kfile.iconName()},
-        // {MODEL_KEY::SIZE, QString::number(kfile.size())},
-        {MODEL_KEY::SIZE, QString::number((qulonglong)kfile.size())},
-        {MODEL_KEY::OWNER, kfile.user()},
-        {MODEL_KEY::NICKNAME, fileNickName},
-        {MODEL_KEY::BOOK, "false"},
-        // {MODEL_KEY::TAGS, tagIndex},
-        {MODEL_KEY::COUNT, fileCount}};
+        item.count = trashFile.isDir() ? QDir(fileInfoPath).count() : 0;
+    }
+
+    item.created = dateSecs(kfile.time(KFileItem::FileTimes::CreationTime));
+    item.modified = dateSecs(kfile.time(KFileItem::FileTimes::ModificationTime));
+    item.lastRead = dateSecs(kfile.time(KFileItem::FileTimes::AccessTime));
+    item.symlink = kfile.linkDest();
+    item.group = internString(kfile.group());
+    item.owner = internString(kfile.user());
+    item.icon = internString(type.icon);
+    item.size = static_cast<qint64>(kfile.size());
+
+    item.setFlag(FileItem::IS_SYMLINK, kfile.isLink());
+    item.setFlag(FileItem::IS_DIR, kfile.isDir());
+    item.setFlag(FileItem::IS_FILE, kfile.isFile());
+    item.setFlag(FileItem::WRITABLE, kfile.isWritable());
+    item.setFlag(FileItem::READABLE, kfile.isReadable());
+    item.setFlag(FileItem::EXECUTABLE, kfile.isDesktopFile());
+
+    return item;
+}
 
+const FMH::MODEL getFileInfo(const KFileItem &kfile)
+{
+    return getFileItem(kfile).toModel();
 }
 #endif
 
-const FMH::MODEL getFileInfoModel(const QUrl &path)
+const FileItem getFileItem(const QUrl &path)
 {
-    MODEL res;
 #if defined Q_OS_ANDROID || defined Q_OS_WIN32 || defined Q_OS_MACOS || defined Q_OS_IOS
     const QFileInfo file(path.toLocalFile());
     if (!file.exists()) {
-        return MODEL();
-    }
-    const auto mime = getMime(path);
-    res = MODEL {{MODEL_KEY::GROUP, file.group()},
-        {MODEL_KEY::OWNER, file.owner()},
-        {MODEL_KEY::SUFFIX, file.completeSuffix()},
-        {MODEL_KEY::LABEL, /*file.isDir() ? file.baseName() :*/ path == HomePath ? QStringLiteral("Home") : file.fileName()},
-        {MODEL_KEY::NAME, file.fileName()},
-        {MODEL_KEY::DATE,  file.birthTime().toString(Qt::TextDate)},
-        {MODEL_KEY::MODIFIED, file.lastModified().toString(Qt::TextDate)},
-        {MODEL_KEY::LAST_READ, file.lastRead().toString(Qt::TextDate)},
-        {MODEL_KEY::MIME, mime},
-        {MODEL_KEY::SYMLINK, file.symLinkTarget()},
-        {MODEL_KEY::IS_SYMLINK, QVariant(file.isSymLink()).toString()},
-        {MODEL_KEY::IS_FILE, QVariant(file.isFile()).toString()},
-        {MODEL_KEY::HIDDEN, QVariant(file.isHidden()).toString()},
-        {MODEL_KEY::IS_DIR, QVariant(file.isDir()).toString()},
-        {MODEL_KEY::WRITABLE, QVariant(file.isWritable()).toString()},
-        {MODEL_KEY::READABLE, QVariant(file.isReadable()).toString()},
-        {MODEL_KEY::EXECUTABLE, QVariant(file.suffix().endsWith(".desktop")).toString()},
-        {MODEL_KEY::ICON, getIconName(path)},
-        {MODEL_KEY::SIZE, QString::number(file.size()) /*locale.formattedDataSize(file.size())*/},
-        {MODEL_KEY::PATH, path.toString()},
-        {MODEL_KEY::URL, path.toString()},
-        {MODEL_KEY::THUMBNAIL, thumbnailUrl(path, mime).toString()},
-        {MODEL_KEY::COUNT, file.isDir() ? QString::number(QDir(path.toLocalFile()).count() - 2) : "0"}};
+        return FileItem();
+    }
+
+    FileItem item;
+    item.url = path.toString();
+    item.label = path == HomePath ? QStringLiteral("Home") : file.fileName();
+    item.mime = internString(getMime(path));
+    item.icon = internString(getIconName(path));
+    item.group = internString(file.group());
+    item.owner = internString(file.owner());
+    item.created = dateSecs(file.birthTime());
+    item.modified = dateSecs(file.lastModified());
+    item.lastRead = dateSecs(file.lastRead());
+    item.symlink = file.symLinkTarget();
+    item.size = file.size();
+    item.thumbnail = thumbnailUrl(path, item.mime).toString();
+    item.count = file.isDir() ? QDir(path.toLocalFile()).count() - 2 : 0;
+
+    item.setFlag(FileItem::IS_SYMLINK, file.isSymLink());
+    item.setFlag(FileItem::IS_FILE, file.isFile());
+    item.setFlag(FileItem::HIDDEN, file.isHidden());
+    item.setFlag(FileItem::IS_DIR, file.isDir());
+    item.setFlag(FileItem::WRITABLE, file.isWritable());
+    item.setFlag(FileItem::READABLE, file.isReadable());
+    item.setFlag(FileItem::EXECUTABLE, file.suffix().endsWith(".desktop"));
+
+    return item;
 #else
-    res = getFileInfo(KFileItem(path, KFileItem::MimeTypeDetermination::NormalMimeTypeDetermination));
+    if (path.isLocalFile()) {
+        return getFileItem(KFileItem(path, MimeCache::lookup(path.toLocalFile()).name));
+    }
+
+    return getFileItem(KFileItem(path, KFileItem::MimeTypeDetermination::NormalMimeTypeDetermination));
 #endif
-    return res;
+}
+
+const FMH::MODEL getFileInfoModel(const QUrl &path)
+{
+    return getFileItem(path).toModel();
 }
 
 const QVariantMap getFileInfo(const QUrl &path)
@@ -21,6 +21,7 @@
 #ifndef FMH_H
 #define FMH_H
 
+#include <QDataStream>
 #include <QDateTime>
 #include <QDebug>
 #include <QDirIterator>
@@ -35,6 +36,9 @@
 #include <QUrl>
 #include <QVector>
 
+#include <atomic>
+#include <memory>
+
 #if defined(Q_OS_ANDROID)
 #include "mauiandroid.h"
 #elif defined(Q_OS_LINUX)
@@ -728,12 +732,218 @@ const MODEL MAUIKIT_EXPORT filterModel(const MODEL &model, const QVector<MODEL_K
  */
 const QStringList MAUIKIT_EXPORT modelToList(const MODEL_LIST &list, const MODEL_KEY &key);
 
+/**
+ * @brief internString
+ * Returns a shared copy of the given string from a process wide pool, so repeated values such as mimetypes,
+ * icon names, owners and groups share a single allocation. It is safe to call from any thread.
+ * The pool is split in shards, each with its own lock, and bounded: when a shard is full the strings only it holds are
+ * dropped, and if all of them are in use the value is returned as it is.
+ * @param value
+ * @return
+ */
+const QString MAUIKIT_EXPORT internString(const QString &value);
+
+/**
+ * @brief The FileItem class
+ * Packed representation of a file entry.
+ * Sizes and dates are kept as native values, the boolean properties as bit flags and the repeated strings
+ * (mime, icon, owner and group) are interned. Any other key is kept in a small fallback MODEL.
+ * The values can still be read by MODEL_KEY, and converted back into a MODEL or a QVariantMap with the same
+ * string representation as before, so the QML side does not notice the difference.
+ */
+class MAUIKIT_EXPORT FileItem
+{
+public:
+    enum FLAG : quint16 {
+        IS_DIR = 1 << 0,
+        IS_FILE = 1 << 1,
+        IS_SYMLINK = 1 << 2,
+        HIDDEN = 1 << 3,
+        READABLE = 1 << 4,
+        WRITABLE = 1 << 5,
+        EXECUTABLE = 1 << 6,
+        BOOK = 1 << 7,
+        PARTIAL = 1 << 8 // only the cheap fields are filled, the rest is resolved on demand
+    };
+
+    /**
+     * @brief isEmpty
+     * An item without URL does not represent any file
+     * @return
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief is
+     * Checks if the given flag is set
+     * @param flag
+     * @return
+     */
+    bool is(const FLAG &flag) const;
+
+    /**
+     * @brief setFlag
+     * @param flag
+     * @param value
+     */
+    void setFlag(const FLAG &flag, const bool &value = true);
+
+    /**
+     * @brief value
+     * The value of the key represented as a string, the same way it would be found in a MODEL
+     * @param key
+     * @return
+     */
+    const QString value(const MODEL_KEY &key) const;
+
+    /**
+     * @brief data
+     * The value of the key as it should be exposed by a model, dates are returned as QDateTime
+     * @param key
+     * @return
+     */
+    const QVariant data(const MODEL_KEY &key) const;
+
+    /**
+     * @brief insert
+     * Sets the value of a key, the string is parsed into the native field when there is one
+     * @param key
+     * @param value
+     */
+    void insert(const MODEL_KEY &key, const QString &value);
+
+    /**
+     * @brief roles
+     * The keys that this item can provide
+     * @return
+     */
+    const QVector<int> roles() const;
+
+    /**
+     * @brief toModel
+     * @return
+     */
+    const MODEL toModel() const;
+
+    /**
+     * @brief fromModel
+     * @param model
+     * @return
+     */
+    static FileItem fromModel(const MODEL &model);
+
+    inline const QString operator[](const MODEL_KEY &key) const
+    {
+        return this->value(key);
+    }
+
+    QString url; // also used as PATH and NICKNAME
+    QString label;
+    QString thumbnail;
+    QString symlink;
+    QString mime;
+    QString icon;
+    QString owner;
+    QString group;
+
+    qint64 size = 0;
+    qint64 modified = 0; // seconds since epoch, 0 when unknown
+    qint64 created = 0;
+    qint64 lastRead = 0;
+    qint32 count = 0;
+    quint16 flags = 0;
+
+    MODEL extra; // keys without a native field, such as TYPE
+};
+}
+
+// before any container of FileItem is instantiated, so they all relocate it with memmove
+Q_DECLARE_TYPEINFO(FMH::FileItem, Q_MOVABLE_TYPE);
+
+namespace FMH
+{
+/**
+ * @brief FILE_LIST
+ */
+typedef QVector<FileItem> FILE_LIST;
+
+/**
+ * @brief toFileList
+ * @param list
+ * @return
+ */
+const FILE_LIST MAUIKIT_EXPORT toFileList(const MODEL_LIST &list);
+
+/**
+ * @brief toModelList
+ * @param list
+ * @return
+ */
+const MODEL_LIST MAUIKIT_EXPORT toModelList(const FILE_LIST &list);
+
+/**
+ * @brief operator <<
+ * Writes every field of the item, so it can be stored and read back as it is
+ * @param out
+ * @param item
+ * @return
+ */
+MAUIKIT_EXPORT QDataStream &operator<<(QDataStream &out, const FileItem &item);
+
+/**
+ * @brief operator >>
+ * Reads an item written with operator<<, the repeated strings are interned again
+ * @param in
+ * @param item
+ * @return
+ */
+MAUIKIT_EXPORT QDataStream &operator>>(QDataStream &in, FileItem &item);
+
 /**
  * @brief The PATH_CONTENT struct
  */
 struct PATH_CONTENT {
     QUrl path;               // the url holding all the content
-    MODEL_LIST content; // the content from the url
+    FILE_LIST content; // the content from the url
+};
+
+/**
+ * @brief The CancelToken class
+ * Tags a listing, search or filter request with a generation number and is shared, by copy, with the work the
+ * request starts. Once a newer request supersedes it the token gets cancelled, so the work can stop at the next
+ * batch and its results are dropped instead of being applied over the newer ones.
+ */
+class MAUIKIT_EXPORT CancelToken
+{
+public:
+    explicit CancelToken(const quint64 &generation = 0)
+        : m_generation(generation)
+        , m_cancelled(std::make_shared<std::atomic<bool>>(false))
+    {
+    }
+
+    /**
+     * @brief cancel
+     * Can be called from any thread, every copy of the token sees it
+     */
+    void cancel() const
+    {
+        m_cancelled->store(true, std::memory_order_relaxed);
+    }
+
+    bool isCancelled() const
+    {
+        return m_cancelled->load(std::memory_order_relaxed);
+    }
+
+    quint64 generation() const
+    {
+        return m_generation;
+    }
+
+private:
+    quint64 m_generation;
+    std::shared_ptr<std::atomic<bool>> m_cancelled;
 };
 
 /**
@@ -949,6 +1159,16 @@ const MAUIKIT_EXPORT QUrl parentDir(const QUrl &path);
  */
 const MAUIKIT_EXPORT QVariantMap dirConf(const QUrl &path);
 
+/**
+ * @brief dirConfs
+ * Same as dirConf for many directories at once, the .directory files not cached yet are parsed in parallel
+ * @param paths
+ * Local file URLs of the .directory files
+ * @return
+ * The configurations in the same order
+ */
+const MAUIKIT_EXPORT QVector<QVariantMap> dirConfs(const QList<QUrl> &paths);
+
 /**
  * @brief setDirConf
  * @param path
@@ -1000,8 +1220,23 @@ const QUrl MAUIKIT_EXPORT thumbnailUrl(const QUrl &url, const QString &mimetype)
  * @return
  */
 const MODEL MAUIKIT_EXPORT getFileInfo(const KFileItem &kfile);
+
+/**
+ * @brief getFileItem
+ * Packs the KFileItem information into a FileItem
+ * @param kfile
+ * @return
+ */
+const FileItem MAUIKIT_EXPORT getFileItem(const KFileItem &kfile);
 #endif
 
+/**
+ * @brief getFileItem
+ * @param path
+ * @return
+ */
+const FileItem MAUIKIT_EXPORT getFileItem(const QUrl &path);
+
 /**
  * @brief getFileInfoModel
  * @param path
@@ -1040,5 +1275,8 @@ const QVariantMap MAUIKIT_EXPORT getDirInfo(const QUrl &path);
 PATHTYPE_KEY MAUIKIT_EXPORT getPathType(const QUrl &url);
 }
 
+Q_DECLARE_METATYPE(FMH::FileItem)
+Q_DECLARE_METATYPE(FMH::CancelToken)
+
 
 #endif // FMH_H
@@ -6,11 +6,15 @@
  *
  */
 #include "fmstatic.h"
+#include "filejobqueue.h"
 #include "utils.h"
 #include "platform.h"
+#include "mimecache.h"
 
 #include <QDesktopServices>
 
+#include <memory>
+
 #if defined Q_OS_LINUX && !defined Q_OS_ANDROID
 #include <KCoreDirLister>
 #include <KFileItem>
@@ -27,12 +31,19 @@
 #include "tagging.h"
 #endif
 
+#ifdef COMPONENT_FM
+#include "direnumerator.h"
+#include "dirwalker.h"
+#include "fileindex.h"
+#endif
+
 #ifdef Q_OS_ANDROID
 #include "platforms/android/mauiandroid.h"
 #endif
 
 
 #include <QObject>
+#include <QPointer>
 #include <QtGlobal>
 #include <QCoreApplication>
 #include <QThread>
@@ -40,6 +51,7 @@
 #include <QNetworkInterface>
 
 QMap<QString, QHash<QString,QString>> FMStatic::tagUrlMap;
+QHash<QString, int> FMStatic::urlColorTagMap;
 
 FMStatic::FMStatic(QObject *parent)
     : QObject(parent)
@@ -49,6 +61,16 @@ FMH::MODEL_LIST FMStatic::packItems(const QStringList &items, const QString &typ
 {
     FMH::MODEL_LIST data;
 
+    // the icon of each folder comes from its .directory file, so they all get parsed up front at once
+    QList<QUrl> confs;
+    for (const auto &path : items) {
+        const QUrl url(path);
+        if (url.isLocalFile()) {
+            confs << QUrl(url.toString() + "/.directory");
+        }
+    }
+    FMH::dirConfs(confs);
+
     for (const auto &path : items) {
         if (QUrl(path).isLocalFile() && !FMH::fileExists(path)) {
             continue;
@@ -67,38 +89,148 @@ FMH::MODEL_LIST FMStatic::getDefaultPaths()
     return FMStatic::packItems(FMH::defaultPaths, FMH::PATHTYPE_LABEL[FMH::PATHTYPE_KEY::PLACES_PATH]);
 }
 
-FMH::MODEL_LIST FMStatic::search(const QString &query, const QUrl &path, const bool &hidden, const bool &onlyDirs, const QStringList &filters)
+int FMStatic::searchRank(const QString &name, const QString &query)
 {
-    FMH::MODEL_LIST content;
+    if (name.compare(query, Qt::CaseInsensitive) == 0) {
+        return 0;
+    }
+
+    if (name.startsWith(query, Qt::CaseInsensitive)) {
+        return 1;
+    }
+
+    return name.contains(query, Qt::CaseInsensitive) ? 2 : 3;
+}
 
+// small batches so the first results show up without waiting for a full one
+static const uint SEARCH_BATCH = 100;
+
+static FMH::FILE_LIST rankItems(FMH::FILE_LIST items, const QString &query)
+{
+    for (auto &item : items) {
+        item.extra[FMH::MODEL_KEY::SCORE] = QString::number(FMStatic::searchRank(item.label, query));
+    }
+
+    return items;
+}
+
+uint FMStatic::searchItems(const QString &query, const QUrl &path, const bool &hidden, const bool &onlyDirs, const QStringList &filters, const std::function<void(const FMH::FILE_LIST &batch)> &onBatch, const uint &limit, const FMH::CancelToken &token)
+{
     if (!path.isLocalFile()) {
         qWarning() << "URL recived is not a local file. FM::search" << path;
-        return content;
+        return 0;
+    }
+
+    if (!FMStatic::isDir(path)) {
+        qWarning() << "Search path does not exists" << path;
+        return 0;
     }
 
-    if (FMStatic::isDir(path)) {
-        QDir::Filters dirFilter;
+    QDir::Filters dirFilter = (onlyDirs ? QDir::AllDirs | QDir::NoDotDot | QDir::NoDot : QDir::Files | QDir::AllDirs | QDir::NoDotDot | QDir::NoDot);
 
-        dirFilter = (onlyDirs ? QDir::AllDirs | QDir::NoDotDot | QDir::NoDot : QDir::Files | QDir::AllDirs | QDir::NoDotDot | QDir::NoDot);
+    if (hidden) {
+        dirFilter = dirFilter | QDir::Hidden | QDir::System;
+    }
 
-        if (hidden) {
-            dirFilter = dirFilter | QDir::Hidden | QDir::System;
+    uint count = 0;
+    FMH::FILE_LIST batch;
+    const auto flush = [&]() {
+        if (!batch.isEmpty() && !token.isCancelled()) {
+            onBatch(rankItems(batch, query));
         }
+        batch.clear();
+    };
 
-        QDirIterator it(path.toLocalFile(), filters, dirFilter, QDirIterator::Subdirectories);
-        while (it.hasNext()) {
-            auto url = it.next();
-            if (it.fileName().contains(query, Qt::CaseInsensitive)) {
-                content << FMH::getFileInfoModel(QUrl::fromLocalFile(url));
+#ifdef COMPONENT_FM
+    const auto index = FMH::FileIndex::instance();
+    if (index) {
+        // the first search walks the tree, the later ones are answered by the index once it is ready
+        index->activate();
+    }
+
+    if (!hidden && index && index->covers(path.toLocalFile())) {
+        // the index only knows the names, which is enough to rank them before reading any of the entries
+        const auto results = index->query(path.toLocalFile(), query, onlyDirs, 0, token);
+
+        QVector<QPair<int, int>> order; // rank and position of each result
+        order.reserve(results.size());
+        for (auto i = 0; i < results.size(); i++) {
+            const auto &result = results.at(i);
+            order << qMakePair(FMStatic::searchRank(result.mid(result.lastIndexOf(QLatin1Char('/')) + 1), query), i);
+        }
+        std::sort(order.begin(), order.end());
+
+        // the entries are read and checked against the disk here
+        FMH::DirEnumerator enumerator;
+        for (const auto &entry : qAsConst(order)) {
+            if (token.isCancelled() || (limit > 0 && count >= limit)) {
+                break;
+            }
+
+            // the name filters do not apply to directories, the same as with QDir::AllDirs
+            const auto item = enumerator.fileItem(results.at(entry.second));
+            if (item.isEmpty() || (!filters.isEmpty() && !item.is(FMH::FileItem::IS_DIR) && !QDir::match(filters, item.label))) {
+                continue;
+            }
+
+            batch << item;
+            count++;
+
+            if (static_cast<uint>(batch.size()) >= SEARCH_BATCH) {
+                flush();
+            }
+        }
+
+        flush();
+        return count;
+    }
+
+    FMH::DirWalker walker(filters, dirFilter);
+    walker.setMatcher([query](const QString &name) -> bool {
+        return name.contains(query, Qt::CaseInsensitive);
+    });
+    walker.setLimit(limit);
+    walker.setBatchCount(SEARCH_BATCH);
+    walker.setCancelToken(token);
+    count = walker.walk({path.toLocalFile()}, [&](const FMH::FILE_LIST &items) {
+        batch = items;
+        flush();
+    });
+#else
+    QDirIterator it(path.toLocalFile(), filters, dirFilter, QDirIterator::Subdirectories);
+    while (it.hasNext() && !token.isCancelled() && (limit == 0 || count < limit)) {
+        auto url = it.next();
+        if (it.fileName().contains(query, Qt::CaseInsensitive)) {
+            batch << FMH::getFileItem(QUrl::fromLocalFile(url));
+            count++;
+
+            if (static_cast<uint>(batch.size()) >= SEARCH_BATCH) {
+                flush();
             }
         }
-    } else {
-        qWarning() << "Search path does not exists" << path;
     }
 
+    flush();
+#endif
+
+    return count;
+}
+
+FMH::MODEL_LIST FMStatic::search(const QString &query, const QUrl &path, const bool &hidden, const bool &onlyDirs, const QStringList &filters, const FMH::CancelToken &token)
+{
+    FMH::MODEL_LIST content;
+    FMStatic::searchItems(query, path, hidden, onlyDirs, filters, [&content](const FMH::FILE_LIST &items) {
+        content << FMH::toModelList(items);
+    }, 0, token);
+
     return content;
 }
 
+QVariantMap FMStatic::mimeCacheStats()
+{
+    return {{"hits", FMH::MimeCache::hits()}, {"misses", FMH::MimeCache::misses()}, {"count", FMH::MimeCache::count()}};
+}
+
 FMH::MODEL_LIST FMStatic::getDevices()
 {
     FMH::MODEL_LIST drives;
@@ -208,69 +340,59 @@ QString FMStatic::homePath()
 {
     return FMH::HomePath;
 }
-#if defined Q_OS_ANDROID || defined Q_OS_WIN32 || defined Q_OS_MACOS || defined Q_OS_IOS
 
-static bool copyRecursively(QString sourceFolder, QString destFolder)
+// the copiers that failed or were cancelled, only touched from the application thread
+static QList<QPointer<FMH::FileCopier>> &unfinished()
 {
-    bool success = false;
-    QDir sourceDir(sourceFolder);
+    static QList<QPointer<FMH::FileCopier>> copiers;
+    return copiers;
+}
 
-    if (!sourceDir.exists()) {
-        return false;
-    }
+FMH::FileCopier *FMStatic::startCopy(const QList<QUrl> &urls, const QUrl &destinationDir, const FMH::FileCopier::MODE &mode)
+{
+    // owned by the application, so a failed copy outlives whoever started it
+    auto copier = new FMH::FileCopier(urls, destinationDir, mode, QCoreApplication::instance());
+    QObject::connect(copier, &FMH::FileCopier::finished, copier, [copier](bool success) {
+        unfinished().removeAll(copier);
+        if (success) {
+            copier->deleteLater();
+        } else {
+            unfinished() << copier;
+        }
+    });
 
-    QDir destDir(destFolder);
-    if (!destDir.exists()) {
-        destDir.mkdir(destFolder);
-    }
+    copier->start();
+    return copier;
+}
 
-    QStringList files = sourceDir.entryList(QDir::Files);
-    for (int i = 0; i < files.count(); i++) {
-        QString srcName = sourceFolder + QDir::separator() + files[i];
-        QString destName = destFolder + QDir::separator() + files[i];
-        success = QFile::copy(srcName, destName);
-        if (!success) {
-            return false;
+QList<QObject *> FMStatic::unfinishedCopies()
+{
+    QList<QObject *> res;
+    for (const auto &copier : qAsConst(unfinished())) {
+        if (copier) {
+            res << copier.data();
         }
     }
 
-    files.clear();
-    files = sourceDir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot);
-    for (int i = 0; i < files.count(); i++) {
-        QString srcName = sourceFolder + QDir::separator() + files[i];
-        QString destName = destFolder + QDir::separator() + files[i];
-        success = copyRecursively(srcName, destName);
-        if (!success) {
-            return false;
-        }
+    return res;
+}
+
+void FMStatic::discardCopy(QObject *copier)
+{
+    const auto res = qobject_cast<FMH::FileCopier *>(copier);
+    if (!res || !unfinished().contains(res)) {
+        return;
     }
 
-    return true;
+    unfinished().removeAll(res);
+    res->cancel();
+    res->deleteLater();
 }
-#endif
 
 bool FMStatic::copy(const QList<QUrl> &urls, const QUrl &destinationDir)
 {
 #if defined Q_OS_ANDROID || defined Q_OS_WIN32 || defined Q_OS_MACOS || defined Q_OS_IOS
-    for (const auto &url : urls) {
-        QFileInfo srcFileInfo(url.toLocalFile());
-        if (!srcFileInfo.isDir() && srcFileInfo.isFile()) {
-            const auto _destination = QUrl(destinationDir.toString() + "/" + FMH::getFileInfoModel(url)[FMH::MODEL_KEY::LABEL]);
-            if (!QFile::copy(url.toLocalFile(), _destination.toLocalFile())) {
-                continue;
-            }
-        } else {
-            const auto _destination = QUrl(destinationDir.toString() + "/" + FMH::getFileInfoModel(url)[FMH::MODEL_KEY::LABEL]);
-            QDir destDir(_destination.toLocalFile());
-            if (!destDir.exists()) {
-                destDir.mkdir(_destination.toLocalFile());
-            }
-
-            if (!copyRecursively(url.toLocalFile(), _destination.toLocalFile())) {
-                continue;
-            }
-        }
-    }
+    FMStatic::startCopy(urls, destinationDir, FMH::FileCopier::MODE::COPY);
     return true;
 #else
     auto job = KIO::copy(urls, destinationDir, KIO::HideProgressInfo);
@@ -286,6 +408,29 @@ bool FMStatic::cut(const QList<QUrl> &urls, const QUrl &where)
     return FMStatic::cut(urls, where, QString());
 }
 
+bool FMStatic::cut(const QList<QUrl> &urls, const QUrl &where, const QString &name)
+{
+    FMStatic::cutJob(urls, where, name);
+    return true;
+}
+
+#if defined COMPONENT_TAGGING && (defined Q_OS_ANDROID || defined Q_OS_WIN32 || defined Q_OS_MACOS || defined Q_OS_IOS)
+// runs the callback once the job of the queue is done, with the urls it failed on
+static void whenFinished(const uint &id, const std::function<void(const QStringList &failed)> &callback)
+{
+    const auto queue = FMH::FileJobQueue::instance();
+    auto connection = std::make_shared<QMetaObject::Connection>();
+    *connection = QObject::connect(queue, &FMH::FileJobQueue::jobFinished, queue, [id, callback, connection](uint finished, bool, QStringList failed) {
+        if (finished != id) {
+            return;
+        }
+
+        QObject::disconnect(*connection);
+        callback(failed);
+    });
+}
+#endif
+
 bool FMStatic::updateTag(const QList<QUrl> &urls, const QUrl &where)
 {
     for (const auto &url : urls) {
@@ -295,24 +440,49 @@ bool FMStatic::updateTag(const QList<QUrl> &urls, const QUrl &where)
     return true;
 }
 
-bool FMStatic::cut(const QList<QUrl> &urls, const QUrl &where, const QString &name)
+uint FMStatic::cutJob(const QList<QUrl> &urls, const QUrl &where, const QString &name)
 {
 #if defined Q_OS_ANDROID || defined Q_OS_WIN32 || defined Q_OS_MACOS || defined Q_OS_IOS
-    for (const auto &url : qAsConst(urls)) {
-        QUrl _where;
-        if (name.isEmpty()) {
-            _where = QUrl(where.toString() + "/" + FMH::getFileInfoModel(url)[FMH::MODEL_KEY::LABEL]);
-        } else {
-            _where = QUrl(where.toString() + "/" + name);
-        }
-
-        QFile file(url.toLocalFile());
-        file.rename(_where.toLocalFile());
+    // the copier renames what it can and copies the rest across filesystems
+    if (name.isEmpty()) {
+        const auto copier = FMStatic::startCopy(urls, where, FMH::FileCopier::MODE::MOVE);
 
 #ifdef COMPONENT_TAGGING
-        Tagging::getInstance()->updateUrl(url.toString(), _where.toString());
+        // the tags follow the items that got moved, to the name the copier picked for them. A failed copy may be
+        // resumed, so this runs every time it finishes
+        QObject::connect(copier, &FMH::FileCopier::finished, copier, [copier, urls]() {
+            for (const auto &url : urls) {
+                const auto destination = copier->destinationOf(url);
+                if (!destination.isEmpty() && !FMH::fileExists(url) && FMH::fileExists(destination)) {
+                    Tagging::getInstance()->updateUrl(url.toString(), destination.toString());
+                }
+            }
+        });
+#else
+        Q_UNUSED(copier)
 #endif
+
+        return 0;
     }
+
+    const QUrl _where(where.toString() + "/" + name);
+    const auto target = _where.toLocalFile();
+    const auto id = FMH::FileJobQueue::instance()->enqueue(QString(), urls, [target](const QUrl &url) {
+        return QFile::rename(url.toLocalFile(), target);
+    });
+
+#ifdef COMPONENT_TAGGING
+    // the tags follow the files that were actually renamed
+    whenFinished(id, [urls, _where](const QStringList &failed) {
+        for (const auto &url : urls) {
+            if (!failed.contains(url.toString())) {
+                Tagging::getInstance()->updateUrl(url.toString(), _where.toString());
+            }
+        }
+    });
+#endif
+
+    return id;
 #else
     QUrl _where = where;
     if (!name.isEmpty()) {
@@ -333,33 +503,55 @@ bool FMStatic::cut(const QList<QUrl> &urls, const QUrl &where, const QString &na
         Tagging::getInstance()->updateUrl(url.toString(), where_.toString());
     }
 #endif
+
+    return 0;
 #endif
+}
 
-    return true;
+// removes a file, or a folder along with its content
+static bool removeUrl(const QUrl &url)
+{
+    const QFileInfo info(url.toLocalFile());
+    if (info.isDir() && !info.isSymLink()) {
+        return QDir(info.absoluteFilePath()).removeRecursively();
+    }
+
+    return QFile::remove(info.absoluteFilePath());
 }
 
 bool FMStatic::removeFiles(const QList<QUrl> &urls)
 {
+    FMStatic::removeFilesJob(urls);
+    return true;
+}
+
+uint FMStatic::removeFilesJob(const QList<QUrl> &urls)
+{
+#if defined Q_OS_ANDROID || defined Q_OS_WIN32 || defined Q_OS_MACOS || defined Q_OS_IOS
+    const auto id = FMH::FileJobQueue::instance()->enqueue("remove", urls, removeUrl);
+
+#ifdef COMPONENT_TAGGING
+    // the files that could not be removed keep their tags
+    whenFinished(id, [urls](const QStringList &failed) {
+        for (const auto &url : urls) {
+            if (!failed.contains(url.toString())) {
+                Tagging::getInstance()->removeUrl(url.toString());
+            }
+        }
+    });
+#endif
+
+    return id;
+#else
 #ifdef COMPONENT_TAGGING
     for (const auto &url : qAsConst(urls)) {
         Tagging::getInstance()->removeUrl(url.toString());
     }
 #endif
 
-#if defined Q_OS_ANDROID || defined Q_OS_WIN32 || defined Q_OS_MACOS || defined Q_OS_IOS
-
-    for (const auto &url : qAsConst(urls)) {
-        if (isDir(url)) {
-            FMStatic::removeDir(url);
-        } else {
-            QFile::remove(url.toLocalFile());
-        }
-    }
-    return true;
-#else
     auto job = KIO::del(urls, KIO::HideProgressInfo);
-    job->exec();
-    return true;
+    job->start();
+    return 0;
 #endif
 }
 
@@ -377,30 +569,19 @@ void FMStatic::emptyTrash()
 {
 #if defined Q_OS_LINUX && !defined Q_OS_ANDROID
     auto job = KIO::emptyTrash();
-    job->exec();
+    job->start();
 #endif
 }
 
 bool FMStatic::removeDir(const QUrl &path)
 {
-    bool result = true;
-    QDir dir(path.toLocalFile());
-    if (dir.exists()) {
-        Q_FOREACH (QFileInfo info, dir.entryInfoList(QDir::NoDotAndDotDot | QDir::System | QDir::Hidden | QDir::AllDirs | QDir::Files, QDir::DirsFirst)) {
-            if (info.isDir()) {
-                result = removeDir(QUrl::fromLocalFile(info.absoluteFilePath()));
-            } else {
-                result = QFile::remove(info.absoluteFilePath());
-            }
-
-            if (!result) {
-                return result;
-            }
-        }
-        result = dir.rmdir(path.toLocalFile());
-    }
+    FMStatic::removeDirJob(path);
+    return true;
+}
 
-    return result;
+uint FMStatic::removeDirJob(const QUrl &path)
+{
+    return FMH::FileJobQueue::instance()->enqueue("remove", {path}, removeUrl);
 }
 
 bool FMStatic::rename(const QUrl &url, const QString &name)
@@ -408,15 +589,32 @@ bool FMStatic::rename(const QUrl &url, const QString &name)
     return FMStatic::cut({url}, QUrl(url.toString().left(url.toString().lastIndexOf("/"))), name);
 }
 
+uint FMStatic::renameJob(const QUrl &url, const QString &name)
+{
+    return FMStatic::cutJob({url}, QUrl(url.toString().left(url.toString().lastIndexOf("/"))), name);
+}
+
 bool FMStatic::createDir(const QUrl &path, const QString &name)
 {
 #if defined Q_OS_ANDROID || defined Q_OS_WIN32 || defined Q_OS_MACOS || defined Q_OS_IOS
-    QFileInfo dd(path.toLocalFile());
+    // a single mkdir is cheap enough to answer right away
     return QDir(path.toLocalFile()).mkdir(name);
+#else
+    FMStatic::createDirJob(path, name);
+    return true;
+#endif
+}
+
+uint FMStatic::createDirJob(const QUrl &path, const QString &name)
+{
+#if defined Q_OS_ANDROID || defined Q_OS_WIN32 || defined Q_OS_MACOS || defined Q_OS_IOS
+    return FMH::FileJobQueue::instance()->enqueue(QString(), {path}, [name](const QUrl &url) {
+        return QDir(url.toLocalFile()).mkdir(name);
+    });
 #else
     auto job = KIO::mkdir(name.isEmpty() ? path : QUrl(path.toString() + "/" + name));
     job->start();
-    return true;
+    return 0;
 #endif
 }
 
@@ -598,23 +796,72 @@ FMH::MODEL_LIST FMStatic::getUrlTags(const QUrl &url)
 bool FMStatic::urlTagExists(const QUrl &url, const QString tag)
 {
 #ifdef COMPONENT_TAGGING
-    QHash<QString,QString> tagUrlList = FMStatic::tagUrlMap[tag];
-    bool isTagExists = tagUrlList.contains(url.toString());
-//    for (int i = 0; i < tagUrlList.size(); i++) {
-//        if (url == tagUrlList.at(i)) {
-//            isTagExists = true;
-//            break;
-//        }
-//    }
-    return isTagExists;
+    const auto it = FMStatic::tagUrlMap.constFind(tag);
+    return it != FMStatic::tagUrlMap.constEnd() && it.value().contains(url.toString());
 #endif
 }
 
+static int colorTagNumber(const QString &tag)
+{
+    if (tag.size() != 11 || !tag.startsWith(QStringLiteral("tag")) || !tag.endsWith(QStringLiteral("_jingos"))) {
+        return -1;
+    }
+
+    const auto number = tag.at(3).digitValue();
+    return number >= 0 && number < 8 ? number : -1;
+}
+
+static void updateUrlColorTag(const QString &url)
+{
+    int res = -1;
+    for (int i = 0; i < 8; i++) {
+        const auto it = FMStatic::tagUrlMap.constFind("tag" + QString::number(i) + "_jingos");
+        if (it != FMStatic::tagUrlMap.constEnd() && it.value().contains(url)) {
+            res = i;
+        }
+    }
+
+    if (res < 0) {
+        FMStatic::urlColorTagMap.remove(url);
+    } else {
+        FMStatic::urlColorTagMap.insert(url, res);
+    }
+}
+
+static void updateColorTagIndex(const QString &tag)
+{
+    const auto number = colorTagNumber(tag);
+    if (number < 0) {
+        return;
+    }
+
+    // drop the stale entries of this tag, then add back the current ones
+    QStringList urls;
+    for (auto it = FMStatic::urlColorTagMap.constBegin(); it != FMStatic::urlColorTagMap.constEnd(); ++it) {
+        if (it.value() == number) {
+            urls << it.key();
+        }
+    }
+
+    urls << FMStatic::tagUrlMap.value(tag).keys();
+    for (const auto &url : qAsConst(urls)) {
+        updateUrlColorTag(url);
+    }
+}
+
+int FMStatic::urlColorTag(const QString &url)
+{
+    return FMStatic::urlColorTagMap.value(url, -1);
+}
+
 bool FMStatic::addTagToUrl(const QString tag, const QUrl &url)
 {
 #ifdef COMPONENT_TAGGING
     if (Tagging::getInstance()->tagUrl(url.toString(), tag)) {
-        FMStatic::updateTagUrl(tag);
+        FMStatic::tagUrlMap[tag].insert(url.toString(), tag);
+        if (colorTagNumber(tag) >= 0) {
+            updateUrlColorTag(url.toString());
+        }
         return true;
     } else {
         return false;
@@ -636,7 +883,10 @@ bool FMStatic::removeTagToUrl(const QString tag, const QUrl &url)
 {
 #ifdef COMPONENT_TAGGING
     if (Tagging::getInstance()->removeUrlTag(url.toString(), tag)) {
-        FMStatic::updateTagUrl(tag);
+        FMStatic::tagUrlMap[tag].remove(url.toString());
+        if (colorTagNumber(tag) >= 0) {
+            updateUrlColorTag(url.toString());
+        }
         return true;
     } else {
         return false;
@@ -690,9 +940,11 @@ void FMStatic::updateTagUrl(QString userTag)
        }
        tagUrlMap.remove(userTag);
        tagUrlMap[userTag] = tagUrlList;
+       updateColorTagIndex(userTag);
        return;
     }
     FMStatic::tagUrlMap.clear();
+    FMStatic::urlColorTagMap.clear();
     QHash<QString,QString> tagUrlList;
 
     QVariantList mapList;
@@ -706,6 +958,7 @@ void FMStatic::updateTagUrl(QString userTag)
             if (!tagUrl.isEmpty()) {
 //                tagUrlList << tagUrl;
                 tagUrlList.insert(tagUrl,tag);
+                urlColorTagMap.insert(tagUrl, i);
             }
         }
         tagUrlMap[tag] = tagUrlList;
@@ -8,10 +8,13 @@
 #ifndef FMSTATIC_H
 #define FMSTATIC_H
 
+#include "filecopier.h"
 #include "fmh.h"
 #include <QObject>
 #include <QMap>
 
+#include <functional>
+
 #include "mauikit_export.h"
 
 /**
@@ -25,6 +28,46 @@ public:
     explicit FMStatic(QObject *parent = nullptr);
     static QMap<QString, QHash<QString,QString>> tagUrlMap;
 
+    /**
+     * @brief urlColorTagMap
+     * Index of the colour tag (tag0_jingos to tag7_jingos) of each tagged URL, kept in sync with tagUrlMap
+     */
+    static QHash<QString, int> urlColorTagMap;
+
+    /**
+     * @brief urlColorTag
+     * Looks up the colour tag of a file URL without going through every tag
+     * @param url
+     * The file URL as a string
+     * @return
+     * The colour tag number, from 0 to 7, or -1 if the URL has no colour tag. If the URL has many, the highest one
+     */
+    static int urlColorTag(const QString &url);
+
+    /**
+     * @brief searchRank
+     * How well a name matches a search term, lower is better: 0 for the exact name, 1 when the name starts with the
+     * term, 2 when it contains it and 3 when the entry matched by anything else, such as its path
+     * @param name
+     * @param query
+     * @return
+     */
+    static int searchRank(const QString &name, const QString &query);
+
+    /**
+     * @brief searchItems
+     * Same as search() but the results are handed back in batches while the search goes on, each item with its
+     * searchRank() under FMH::MODEL_KEY::SCORE. Searches answered by the file index deliver the best ranked
+     * names first
+     * @param onBatch
+     * Called from the calling thread with each batch of results
+     * @param limit
+     * Maximum number of results, the search stops once it is reached. 0 for no limit
+     * @return
+     * Number of results found
+     */
+    static uint searchItems(const QString &query, const QUrl &path, const bool &hidden, const bool &onlyDirs, const QStringList &filters, const std::function<void(const FMH::FILE_LIST &batch)> &onBatch, const uint &limit = 0, const FMH::CancelToken &token = FMH::CancelToken());
+
 public slots:
     /**
      * @brief search
@@ -39,10 +82,20 @@ public slots:
      * If only searching for directories and not files
      * @param filters
      * List of filter patterns such as {"*.qml"}, it can use regular expressions
+     * @param token
+     * Token of the request, once it is cancelled the search stops and returns what it has found so far
      * @return
      * The search results are returned as a FMH::MODEL_LIST
      */
-    static FMH::MODEL_LIST search(const QString &query, const QUrl &path, const bool &hidden = false, const bool &onlyDirs = false, const QStringList &filters = QStringList());
+    static FMH::MODEL_LIST search(const QString &query, const QUrl &path, const bool &hidden = false, const bool &onlyDirs = false, const QStringList &filters = QStringList(), const FMH::CancelToken &token = FMH::CancelToken());
+
+    /**
+     * @brief mimeCacheStats
+     * Counters of the mime type cache shared by the listings, the searches and the tagging
+     * @return
+     * Map with the number of hits, misses and cached entries
+     */
+    static QVariantMap mimeCacheStats();
 
     /**
      * @brief getDevices
@@ -82,6 +135,32 @@ public slots:
      */
     static bool copy(const QList<QUrl> &urls, const QUrl &destinationDir);
 
+    /**
+     * @brief startCopy
+     * Starts copying or moving local files without KIO. This is what copy and cut use on the platforms without KIO
+     * @param urls
+     * @param destinationDir
+     * @param mode
+     * @return
+     * The running copier, to follow its progress or cancel it. It deletes itself once it succeeds. A failed or
+     * cancelled one is kept, with its errors, and listed by unfinishedCopies so it can be resumed with start
+     */
+    static FMH::FileCopier *startCopy(const QList<QUrl> &urls, const QUrl &destinationDir, const FMH::FileCopier::MODE &mode = FMH::FileCopier::MODE::COPY);
+
+    /**
+     * @brief unfinishedCopies
+     * @return
+     * The copiers started by startCopy that failed or were cancelled, oldest first
+     */
+    static QList<QObject *> unfinishedCopies();
+
+    /**
+     * @brief discardCopy
+     * Forgets an unfinished copy and deletes its copier, what it already copied stays
+     * @param copier
+     */
+    static void discardCopy(QObject *copier);
+
     /**
      * @brief cut
      * Perform a move/cut of a list of files to a destination. This function also moves the associated tags if the tags component has been enabled COMPONENT_TAGGING
@@ -106,25 +185,56 @@ public slots:
      */
     static bool cut(const QList<QUrl> &urls, const QUrl &where, const QString &name);
 
+    /**
+     * @brief cutJob
+     * Same as cut, for following the outcome of the move
+     * @param urls
+     * @param where
+     * @param name
+     * @return
+     * Id of the job in FileJobs, reported by its jobFinished signal. 0 when the move is done by KIO or the FileCopier,
+     * so the outcome can not be followed there. Without KIO the tags are moved once the rename succeeded
+     */
+    static uint cutJob(const QList<QUrl> &urls, const QUrl &where, const QString &name = QString());
+
     /**
      * @brief removeFiles
      * List of files to be removed completely. This function also removes the assciated tags to the files if the tagging component has been enabled COMPONENT_TAGGING
+     * Without KIO the files are removed in the background by the FileJobQueue, and the tags once they are gone
      * @param urls
      * @return
-     * If the operation has been sucessfull
+     * If the removal has been started
      */
     static bool removeFiles(const QList<QUrl> &urls);
 
+    /**
+     * @brief removeFilesJob
+     * Same as removeFiles, for following the outcome of the removal
+     * @param urls
+     * @return
+     * Id of the job in FileJobs, 0 when the files are removed by KIO
+     */
+    static uint removeFilesJob(const QList<QUrl> &urls);
+
     /**
      * @brief removeDir
-     * Remove a directory recursively
+     * Remove a directory recursively. It is done in the background by the FileJobQueue
      * @param path
      * Path URL to be rmeoved
      * @return
-     * If the operation has been sucessfull
+     * If the removal has been started
      */
     static bool removeDir(const QUrl &path);
 
+    /**
+     * @brief removeDirJob
+     * Same as removeDir, for following the outcome of the removal
+     * @param path
+     * @return
+     * Id of the job in FileJobs
+     */
+    static uint removeDirJob(const QUrl &path);
+
     /**
      * @brief formatSize
      * Format a file size
@@ -323,6 +433,16 @@ public slots:
      */
     static bool rename(const QUrl &url, const QString &name);
 
+    /**
+     * @brief renameJob
+     * Same as rename, for following the outcome of the rename
+     * @param url
+     * @param name
+     * @return
+     * Id of the job in FileJobs, 0 when the file is renamed by KIO
+     */
+    static uint renameJob(const QUrl &url, const QString &name);
+
     /**
      * @brief createDir
      * Creates a directory given a base path and a directory name
@@ -335,6 +455,16 @@ public slots:
      */
     static bool createDir(const QUrl &path, const QString &name);
 
+    /**
+     * @brief createDirJob
+     * Same as createDir, done in the background by the FileJobQueue when there is no KIO
+     * @param path
+     * @param name
+     * @return
+     * Id of the job in FileJobs, 0 when the directory is created by KIO
+     */
+    static uint createDirJob(const QUrl &path, const QString &name);
+
     /**
      * @brief createFile
      * Creates a file given the base directory path and a short file name
@@ -0,0 +1,264 @@
+#include "fuzzymatcher.h"
+
+#include <QFuture>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+using namespace FMH;
+
+static const int SCORE_MATCH = 16;
+static const int SCORE_GAP_START = -3;
+static const int SCORE_GAP_EXTENSION = -1;
+static const int BONUS_BOUNDARY = 8; // first character of a word
+static const int BONUS_CAMEL = 7; // camel case hump or a number after letters
+static const int BONUS_CONSECUTIVE = 4;
+static const int BONUS_FIRST_CHAR_MULTIPLIER = 2;
+
+static const int CHUNK_SIZE = 8192; // candidates matched by each task
+
+static inline quint64 charBit(const ushort &c)
+{
+    if (c >= 'a' && c <= 'z') {
+        return quint64(1) << (c - 'a');
+    }
+
+    if (c >= '0' && c <= '9') {
+        return quint64(1) << (26 + c - '0');
+    }
+
+    // the rest share the remaining bits, which can only let a few more candidates through
+    return quint64(1) << (36 + c % 28);
+}
+
+static quint64 maskOf(const ushort *text, const int &length)
+{
+    quint64 res = 0;
+    for (int i = 0; i < length; i++) {
+        res |= charBit(text[i]);
+    }
+
+    return res;
+}
+
+// appends the case folded text and the bonus of each of its characters
+static void appendText(const QString &text, QVector<ushort> &folded, QVector<quint8> &bonus)
+{
+    const auto lower = text.toCaseFolded();
+    const auto size = folded.size();
+    folded.resize(size + lower.size());
+    bonus.resize(size + lower.size());
+
+    for (int i = 0; i < lower.size(); i++) {
+        folded[size + i] = lower.at(i).unicode();
+
+        const auto current = text.at(i);
+        quint8 value = 0;
+        if (current.isLetterOrNumber()) {
+            const auto previous = i > 0 ? text.at(i - 1) : QChar();
+            if (i == 0 || !previous.isLetterOrNumber()) {
+                value = BONUS_BOUNDARY;
+            } else if ((previous.isLower() && current.isUpper()) || (!previous.isDigit() && current.isDigit())) {
+                value = BONUS_CAMEL;
+            }
+        }
+        bonus[size + i] = value;
+    }
+}
+
+/**
+ * Scores a single candidate, the same way as the first version of the fzf algorithm: the first window holding the
+ * whole pattern is found going forward, and then shrunk going backward from its end.
+ */
+static bool scoreText(const ushort *text, const quint8 *bonus, const int &length, const ushort *pattern, const int &patternLength, int *score, QVector<QPair<int, int>> *ranges)
+{
+    int p = 0;
+    int start = -1;
+    int end = -1;
+    for (int i = 0; i < length; i++) {
+        if (text[i] == pattern[p]) {
+            if (p == 0) {
+                start = i;
+            }
+
+            if (++p == patternLength) {
+                end = i + 1;
+                break;
+            }
+        }
+    }
+
+    if (end < 0) {
+        return false;
+    }
+
+    p = patternLength - 1;
+    for (int i = end - 1; i >= start; i--) {
+        if (text[i] == pattern[p] && --p < 0) {
+            start = i;
+            break;
+        }
+    }
+
+    int res = 0;
+    int consecutive = 0;
+    bool inGap = false;
+    p = 0;
+    for (int i = start; i < end && p < patternLength; i++) {
+        if (text[i] != pattern[p]) {
+            res += inGap ? SCORE_GAP_EXTENSION : SCORE_GAP_START;
+            inGap = true;
+            consecutive = 0;
+            continue;
+        }
+
+        int value = bonus[i];
+        if (consecutive > 0) {
+            value = qMax(value, BONUS_CONSECUTIVE);
+        }
+
+        res += SCORE_MATCH + (p == 0 ? value * BONUS_FIRST_CHAR_MULTIPLIER : value);
+
+        if (ranges) {
+            if (!ranges->isEmpty() && ranges->last().first + ranges->last().second == i) {
+                ranges->last().second++;
+            } else {
+                ranges->append(qMakePair(i, 1));
+            }
+        }
+
+        consecutive++;
+        inGap = false;
+        p++;
+    }
+
+    if (score) {
+        *score = res;
+    }
+
+    return true;
+}
+
+void FuzzyMatcher::append(const QString &text)
+{
+    const auto size = m_text.size();
+    appendText(text, m_text, m_bonus);
+    m_masks << maskOf(m_text.constData() + size, m_text.size() - size);
+    m_offsets << m_text.size();
+}
+
+void FuzzyMatcher::clear()
+{
+    m_text.clear();
+    m_bonus.clear();
+    m_masks.clear();
+    m_offsets = {0};
+}
+
+int FuzzyMatcher::count() const
+{
+    return m_offsets.size() - 1;
+}
+
+QVector<FuzzyMatcher::Result> FuzzyMatcher::matchRows(const QString &pattern, const int &count, const std::function<int(int)> &rowAt, const CancelToken &token) const
+{
+    QVector<Result> res;
+
+    if (pattern.isEmpty()) {
+        res.reserve(count);
+        for (int i = 0; i < count; i++) {
+            res << Result {rowAt(i), 0};
+        }
+        return res;
+    }
+
+    const auto folded = pattern.toCaseFolded();
+    const auto patternText = folded.utf16();
+    const auto patternLength = folded.size();
+    const auto patternMask = maskOf(patternText, patternLength);
+
+    const auto matchChunk = [&](const int &from, const int &to) -> QVector<Result> {
+        QVector<Result> chunk;
+        for (int i = from; i < to; i++) {
+            const auto row = rowAt(i);
+            if (row < 0 || row >= this->count() || (m_masks.at(row) & patternMask) != patternMask) {
+                continue;
+            }
+
+            const auto offset = m_offsets.at(row);
+            int score = 0;
+            if (scoreText(m_text.constData() + offset, m_bonus.constData() + offset, m_offsets.at(row + 1) - offset, patternText, patternLength, &score, nullptr)) {
+                chunk << Result {row, score};
+            }
+        }
+        return chunk;
+    };
+
+    if (count <= CHUNK_SIZE) {
+        res = matchChunk(0, count);
+    } else {
+        QVector<QFuture<QVector<Result>>> futures;
+        for (int from = 0; from < count && !token.isCancelled(); from += CHUNK_SIZE) {
+            const auto to = qMin(count, from + CHUNK_SIZE);
+            futures << QtConcurrent::run([&matchChunk, from, to, &token]() -> QVector<Result> {
+                return token.isCancelled() ? QVector<Result>() : matchChunk(from, to);
+            });
+        }
+
+        // every task has to be done before leaving, they hold references to this frame
+        for (auto &future : futures) {
+            res << future.result();
+        }
+    }
+
+    std::sort(res.begin(), res.end(), [](const Result &r1, const Result &r2) {
+        return r1.score != r2.score ? r1.score > r2.score : r1.row < r2.row;
+    });
+
+    return res;
+}
+
+QVector<FuzzyMatcher::Result> FuzzyMatcher::match(const QString &pattern, const CancelToken &token) const
+{
+    return this->matchRows(pattern, this->count(), [](int i) {
+        return i;
+    }, token);
+}
+
+QVector<FuzzyMatcher::Result> FuzzyMatcher::match(const QString &pattern, const QVector<int> &rows, const CancelToken &token) const
+{
+    return this->matchRows(pattern, rows.size(), [&rows](int i) {
+        return rows.at(i);
+    }, token);
+}
+
+QVector<QPair<int, int>> FuzzyMatcher::highlight(const QString &pattern, const int &row) const
+{
+    QVector<QPair<int, int>> res;
+    if (pattern.isEmpty() || row < 0 || row >= this->count()) {
+        return res;
+    }
+
+    const auto folded = pattern.toCaseFolded();
+    const auto offset = m_offsets.at(row);
+    scoreText(m_text.constData() + offset, m_bonus.constData() + offset, m_offsets.at(row + 1) - offset, folded.utf16(), folded.size(), nullptr, &res);
+    return res;
+}
+
+bool FuzzyMatcher::matchText(const QString &pattern, const QString &text, int *score, QVector<QPair<int, int>> *ranges)
+{
+    if (pattern.isEmpty()) {
+        if (score) {
+            *score = 0;
+        }
+        return true;
+    }
+
+    QVector<ushort> folded;
+    QVector<quint8> bonus;
+    appendText(text, folded, bonus);
+
+    const auto foldedPattern = pattern.toCaseFolded();
+    return scoreText(folded.constData(), bonus.constData(), folded.size(), foldedPattern.utf16(), foldedPattern.size(), score, ranges);
+}
@@ -0,0 +1,105 @@
+#ifndef FUZZYMATCHER_H
+#define FUZZYMATCHER_H
+
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+#include <functional>
+
+#include "fmh.h"
+#include "mauikit_export.h"
+
+namespace FMH
+{
+/**
+ * @brief The FuzzyMatcher class
+ * Fuzzy matching of a pattern against a list of candidates, in the style of fzf: a candidate matches when it holds
+ * every character of the pattern in order, ignoring the case. The score rewards the characters that start a word or a
+ * camel case hump and the ones that follow each other, and penalizes the gaps in between.
+ * Each candidate keeps a bit mask of the characters it holds, so most of them are ruled out without looking at the
+ * text. The candidates are matched in parallel chunks.
+ */
+class MAUIKIT_EXPORT FuzzyMatcher
+{
+public:
+    struct Result {
+        int row;
+        int score;
+    };
+
+    /**
+     * @brief append
+     * Adds a candidate at the end
+     * @param text
+     */
+    void append(const QString &text);
+
+    /**
+     * @brief clear
+     * Removes all the candidates
+     */
+    void clear();
+
+    /**
+     * @brief count
+     * @return
+     * Number of candidates
+     */
+    int count() const;
+
+    /**
+     * @brief match
+     * Matches the pattern against every candidate. An empty pattern matches all of them with a score of 0
+     * @param pattern
+     * @param token
+     * Once it is cancelled the matching stops, the results are then incomplete
+     * @return
+     * The matching candidates, the best scores first and then in the order they were added
+     */
+    QVector<Result> match(const QString &pattern, const CancelToken &token = CancelToken()) const;
+
+    /**
+     * @brief match
+     * Same as above, but only the given candidates are checked. Useful to refine the result of a previous match
+     * @param pattern
+     * @param rows
+     * @param token
+     * @return
+     */
+    QVector<Result> match(const QString &pattern, const QVector<int> &rows, const CancelToken &token = CancelToken()) const;
+
+    /**
+     * @brief highlight
+     * @param pattern
+     * @param row
+     * @return
+     * The ranges of the candidate text matched by the pattern, as start and length pairs. Empty if it does not match
+     */
+    QVector<QPair<int, int>> highlight(const QString &pattern, const int &row) const;
+
+    /**
+     * @brief matchText
+     * Matches the pattern against a single text
+     * @param pattern
+     * @param text
+     * @param score
+     * If given, it is set to the score of the match
+     * @param ranges
+     * If given, it is filled with the matched ranges as start and length pairs
+     * @return
+     * If the text matches
+     */
+    static bool matchText(const QString &pattern, const QString &text, int *score = nullptr, QVector<QPair<int, int>> *ranges = nullptr);
+
+private:
+    QVector<ushort> m_text; // case folded candidates one after the other
+    QVector<quint8> m_bonus; // bonus of each character of m_text for starting a word
+    QVector<int> m_offsets = {0}; // start of each candidate, the last one is the end of the buffer
+    QVector<quint64> m_masks; // characters held by each candidate
+
+    QVector<Result> matchRows(const QString &pattern, const int &count, const std::function<int(int)> &rowAt, const CancelToken &token) const;
+};
+}
+
+#endif // FUZZYMATCHER_H
@@ -0,0 +1,125 @@
+#include "mimecache.h"
+
+#include <QCache>
+#include <QFile>
+#include <QFileInfo>
+#include <QMimeDatabase>
+#include <QMutex>
+
+#include <atomic>
+
+#if defined Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+namespace FMH
+{
+static const int MAX_ENTRIES = 20000;
+static const int SNIFF_SIZE = 8 * 1024; // enough for the magic rules of the common types
+
+static QMutex mutex;
+static QCache<MimeCache::Key, MimeCache::Entry> cache(MAX_ENTRIES);
+static std::atomic<quint64> hitCount {0};
+static std::atomic<quint64> missCount {0};
+
+uint qHash(const MimeCache::Key &key, uint seed)
+{
+    return ::qHash(key.inode, seed) ^ ::qHash(key.device) ^ ::qHash(key.modified) ^ ::qHash(key.size) ^ ::qHash(key.name);
+}
+
+MimeCache::Entry MimeCache::lookup(const QString &path)
+{
+    Key key;
+
+#if defined Q_OS_UNIX
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) != 0) {
+        return detect(path);
+    }
+
+    if (S_ISDIR(st.st_mode)) {
+        return {QStringLiteral("inode/directory"), QStringLiteral("folder")};
+    }
+
+    key.device = static_cast<quint64>(st.st_dev);
+    key.inode = static_cast<quint64>(st.st_ino);
+    key.modified = st.st_mtime;
+    key.size = st.st_size;
+#else
+    if (QFileInfo(path).isDir()) {
+        return {QStringLiteral("inode/directory"), QStringLiteral("folder")};
+    }
+#endif
+
+    return lookup(path, key);
+}
+
+MimeCache::Entry MimeCache::lookup(const QString &path, const Key &key)
+{
+    if (key.inode == 0) {
+        return detect(path);
+    }
+
+    auto named = key;
+    named.name = path.mid(path.lastIndexOf(QLatin1Char('/')) + 1);
+
+    {
+        QMutexLocker locker(&mutex);
+        if (const auto entry = cache.object(named)) {
+            hitCount++;
+            return *entry;
+        }
+    }
+
+    missCount++;
+    const auto entry = detect(path);
+
+    QMutexLocker locker(&mutex);
+    cache.insert(named, new Entry(entry));
+    return entry;
+}
+
+MimeCache::Entry MimeCache::detect(const QString &path)
+{
+    const QMimeDatabase mimedb;
+    const auto name = QFileInfo(path).fileName();
+
+    // the extension is enough for most files
+    const auto types = mimedb.mimeTypesForFileName(name);
+    if (types.size() == 1) {
+        return {types.first().name(), types.first().iconName()};
+    }
+
+    // ambiguous or unknown extension, look at the first bytes only
+    QByteArray data;
+    QFile file(path);
+    if (QFileInfo(path).isFile() && file.open(QIODevice::ReadOnly)) { // never block on pipes or devices
+        data = file.read(SNIFF_SIZE);
+    }
+
+    const auto type = mimedb.mimeTypeForFileNameAndData(name, data);
+    return {type.name(), type.iconName()};
+}
+
+quint64 MimeCache::hits()
+{
+    return hitCount;
+}
+
+quint64 MimeCache::misses()
+{
+    return missCount;
+}
+
+int MimeCache::count()
+{
+    QMutexLocker locker(&mutex);
+    return cache.count();
+}
+
+void MimeCache::clear()
+{
+    QMutexLocker locker(&mutex);
+    cache.clear();
+}
+}
@@ -0,0 +1,89 @@
+#ifndef MIMECACHE_H
+#define MIMECACHE_H
+
+#include <QString>
+
+#include "mauikit_export.h"
+
+namespace FMH
+{
+/**
+ * @brief The MimeCache class
+ * Process wide cache of the mime type and icon of local files, keyed by device, inode, modification time, size and name,
+ * so a file is only looked at again once it changes or is renamed.
+ * The type is taken from the file name when it is unambiguous, otherwise only the first bytes of the file are read
+ * to match the magic rules. Directories are reported as inode/directory and not cached.
+ * It is thread safe. On systems without inodes nothing is cached, but the same detection is used.
+ */
+class MAUIKIT_EXPORT MimeCache
+{
+public:
+    struct Key {
+        quint64 device = 0;
+        quint64 inode = 0;
+        qint64 modified = 0; // seconds since epoch
+        qint64 size = 0;
+        QString name; // the type can come from the name alone, a rename keeps the inode but not the type
+
+        bool operator==(const Key &other) const
+        {
+            return inode == other.inode && device == other.device && modified == other.modified && size == other.size && name == other.name;
+        }
+    };
+
+    struct Entry {
+        QString name;
+        QString icon;
+    };
+
+    /**
+     * @brief lookup
+     * Stats the file to build its key
+     * @param path
+     * Local path of the file
+     * @return
+     */
+    static Entry lookup(const QString &path);
+
+    /**
+     * @brief lookup
+     * For callers that already stat-ed the file
+     * @param path
+     * Local path of the file
+     * @param key
+     * An empty inode skips the cache. The name is taken from the path
+     * @return
+     */
+    static Entry lookup(const QString &path, const Key &key);
+
+    /**
+     * @brief hits
+     * @return
+     * Number of lookups served from the cache
+     */
+    static quint64 hits();
+
+    /**
+     * @brief misses
+     * @return
+     * Number of lookups that had to detect the type
+     */
+    static quint64 misses();
+
+    /**
+     * @brief count
+     * @return
+     * Number of cached entries
+     */
+    static int count();
+
+    static void clear();
+
+private:
+    static Entry detect(const QString &path);
+};
+
+uint qHash(const MimeCache::Key &key, uint seed = 0);
+}
+
+#endif // MIMECACHE_H
@@ -25,18 +25,47 @@ MauiList::MauiList(QObject *parent)
 {}
 
 int MauiList::getCount() const
+{
+    return this->itemsCount();
+}
+
+int MauiList::itemsCount() const
 {
     return this->items().count();
 }
 
+FMH::MODEL MauiList::itemAt(const int &index) const
+{
+    return this->items().at(index);
+}
+
+QString MauiList::itemValue(const int &index, const FMH::MODEL_KEY &key) const
+{
+    return this->items().at(index)[key];
+}
+
+QVariant MauiList::itemData(const int &index, const FMH::MODEL_KEY &key) const
+{
+    const auto value = this->itemValue(index, key);
+
+    if (key == FMH::MODEL_KEY::ADDDATE || key == FMH::MODEL_KEY::DATE || key == FMH::MODEL_KEY::MODIFIED || key == FMH::MODEL_KEY::RELEASEDATE) {
+        const auto date = QDateTime::fromString(value, Qt::TextDate);
+        if (date.isValid()) {
+            return date;
+        }
+    }
+
+    return value;
+}
+
 QVariantMap MauiList::get(const int &index) const
 {
     if (this->m_model) {
         return this->m_model->get(index);
     }
 
-    if (index >=0 && this->items().size() > 0 && index < this->items().size()) {
-        return FMH::toMap(this->items()[index]);
+    if (index >= 0 && index < this->itemsCount()) {
+        return FMH::toMap(this->itemAt(index));
     }
 
     return QVariantMap();
@@ -48,7 +77,14 @@ FMH::MODEL_LIST MauiList::getItems() const
         return FMH::toModelList(this->m_model->getAll());
     }
 
-    return this->items();
+    FMH::MODEL_LIST res;
+    const auto count = this->itemsCount();
+    res.reserve(count);
+    for (auto i = 0; i < count; i++) {
+        res << this->itemAt(i);
+    }
+
+    return res;
 }
 
 int MauiList::mappedIndex(const int &index) const
@@ -76,11 +112,12 @@ bool MauiList::exists(const FMH::MODEL_KEY &key, const QString &value) const
 
 int MauiList::indexOf(const FMH::MODEL_KEY &key, const QString &value) const
 {
-    const auto it = std::find_if(this->items().constBegin(), this->items().constEnd(), [&](const FMH::MODEL &item) -> bool { return item[key] == value; });
-
-    if (it != this->items().constEnd()) {
-        return this->mappedIndexFromSource(std::distance(this->items().constBegin(), it));
-    } else {
-        return -1;
+    const auto count = this->itemsCount();
+    for (auto i = 0; i < count; i++) {
+        if (this->itemValue(i, key) == value) {
+            return this->mappedIndexFromSource(i);
+        }
     }
+
+    return -1;
 }
@@ -45,6 +45,40 @@ public:
     explicit MauiList(QObject *parent = nullptr);
 
     virtual const FMH::MODEL_LIST &items() const = 0;
+
+    /**
+     * @brief itemsCount
+     * Number of items in the list. Lists that do not keep their items as a FMH::MODEL_LIST should override the item accessors below
+     * @return
+     */
+    virtual int itemsCount() const;
+
+    /**
+     * @brief itemAt
+     * The item at the given index of the list
+     * @param index
+     * @return
+     */
+    virtual FMH::MODEL itemAt(const int &index) const;
+
+    /**
+     * @brief itemValue
+     * The value of a key of the item at the given index, represented as a string
+     * @param index
+     * @param key
+     * @return
+     */
+    virtual QString itemValue(const int &index, const FMH::MODEL_KEY &key) const;
+
+    /**
+     * @brief itemData
+     * The value of a key of the item at the given index, as it is exposed by the model
+     * @param index
+     * @param key
+     * @return
+     */
+    virtual QVariant itemData(const int &index, const FMH::MODEL_KEY &key) const;
+
     virtual void classBegin() override  {}
     virtual void componentComplete() override {}
     virtual void modelHooked() {};
@@ -74,9 +108,12 @@ signals:
     void preItemsAppended(uint count);
     void postItemAppended();
     void preItemAppendedAt(int index);
+    void preItemsAppendedAt(int index, uint count);
     void preItemRemoved(int index);
+    void preItemsRemoved(int index, uint count);
     void postItemRemoved();
     void updateModel(int index, QVector<int> roles);
+    void updateModelRange(int index, uint count, QVector<int> roles);
     void preListChanged();
     void postListChanged();
 
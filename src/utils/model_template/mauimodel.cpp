@@ -20,10 +20,34 @@
 #include "mauimodel.h"
 #include "mauilist.h"
 
+#include <algorithm>
+
+static const int MAX_DIRTY_ROWS = 1024;
+
 MauiModel::MauiModel(QObject *parent)
     : QSortFilterProxyModel(parent)
     , m_model(new PrivateAbstractListModel(this))
 {
+    // connected before the proxy itself, so the index is out of the way by the time the changed rows are filtered
+    connect(this->m_model, &QAbstractItemModel::rowsInserted, this, &MauiModel::invalidateIndex);
+    connect(this->m_model, &QAbstractItemModel::rowsRemoved, this, &MauiModel::invalidateIndex);
+    connect(this->m_model, &QAbstractItemModel::rowsMoved, this, &MauiModel::invalidateIndex);
+    connect(this->m_model, &QAbstractItemModel::modelReset, this, &MauiModel::invalidateIndex);
+    connect(this->m_model, &QAbstractItemModel::layoutChanged, this, &MauiModel::invalidateIndex);
+    connect(this->m_model, &QAbstractItemModel::dataChanged, this, [this](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+        if (!this->m_indexValid) {
+            return;
+        }
+
+        for (auto row = topLeft.row(); row <= bottomRight.row(); row++) {
+            this->m_dirtyRows.insert(row);
+        }
+
+        if (this->m_dirtyRows.size() > MAX_DIRTY_ROWS) {
+            this->invalidateIndex();
+        }
+    });
+
     this->setSourceModel(this->m_model);
     this->setDynamicSortFilter(true);
 }
@@ -31,7 +55,9 @@ MauiModel::MauiModel(QObject *parent)
 void MauiModel::setFilterString(const QString &string)
 {
     this->setFilterCaseSensitivity(Qt::CaseInsensitive);
+    this->matchFilter(string);
     this->setFilterFixedString(string);
+    this->applyRanking();
 }
 
 void MauiModel::setSortOrder(const int &sortOrder)
@@ -72,7 +98,170 @@ void MauiModel::setFilter(const QString &filter)
 
     this->m_filter = filter;
     emit this->filterChanged(this->m_filter);
+
+    this->matchFilter(this->m_filter);
     this->setFilterFixedString(this->m_filter);
+    this->applyRanking();
+}
+
+MauiModel::FILTER_MODE MauiModel::getFilterMode() const
+{
+    return this->m_filterMode;
+}
+
+void MauiModel::setFilterMode(const MauiModel::FILTER_MODE &mode)
+{
+    if (this->m_filterMode == mode) {
+        return;
+    }
+
+    this->m_filterMode = mode;
+    emit this->filterModeChanged();
+
+    this->matchFilter(this->m_filter);
+    this->invalidateFilter();
+    this->applyRanking();
+}
+
+void MauiModel::invalidateIndex()
+{
+    this->m_indexValid = false;
+    this->m_acceptedValid = false;
+    this->m_dirtyRows.clear();
+    this->m_matchedFilter.clear();
+    this->m_matchedRows.clear();
+}
+
+QStringList MauiModel::rowText(const int &row) const
+{
+    const auto list = this->getList();
+
+    if (this->filterRole() != Qt::DisplayRole) {
+        return {list->itemValue(row, static_cast<FMH::MODEL_KEY>(this->filterRole()))};
+    }
+
+    static const auto keys = FMH::MODEL_NAME.keys();
+
+    QStringList res;
+    for (const auto &key : keys) {
+        const auto value = list->itemValue(row, key);
+        if (!value.isEmpty()) {
+            res << value;
+        }
+    }
+
+    return res;
+}
+
+QString MauiModel::fuzzyText(const int &row) const
+{
+    const auto key = this->filterRole() != Qt::DisplayRole ? static_cast<FMH::MODEL_KEY>(this->filterRole()) : FMH::MODEL_KEY::LABEL;
+    return this->getList()->itemValue(row, key);
+}
+
+bool MauiModel::isRanked() const
+{
+    return this->m_filterMode == FILTER_MODE::FUZZY && this->m_acceptedValid && this->m_indexMode == FILTER_MODE::FUZZY && !this->m_matchedFilter.isEmpty();
+}
+
+void MauiModel::applyRanking()
+{
+    if (this->m_filterMode != FILTER_MODE::FUZZY) {
+        return;
+    }
+
+    // without a filter the rows go back to the sorting picked by the user, or to the order of the list
+    if (this->isRanked() || !this->m_sort.isEmpty()) {
+        this->sort(0, this->sortOrder());
+    } else {
+        this->sort(-1);
+    }
+}
+
+void MauiModel::buildIndex()
+{
+    this->invalidateIndex();
+    this->m_index.clear();
+    this->m_fuzzyIndex.clear();
+
+    const auto count = this->getList()->itemsCount();
+    for (auto row = 0; row < count; row++) {
+        if (this->m_filterMode == FILTER_MODE::FUZZY) {
+            this->m_fuzzyIndex.append(this->fuzzyText(row));
+        } else {
+            this->m_index.append(this->rowText(row));
+        }
+    }
+
+    this->m_indexValid = true;
+    this->m_indexRole = this->filterRole();
+    this->m_indexMode = this->m_filterMode;
+}
+
+void MauiModel::matchFilter(const QString &filter)
+{
+    this->m_acceptedValid = false;
+
+    if (!this->getList() || filter.isEmpty()) {
+        this->m_matchedFilter.clear();
+        return;
+    }
+
+    const auto indexCount = this->m_indexMode == FILTER_MODE::FUZZY ? this->m_fuzzyIndex.count() : this->m_index.count();
+    if (!this->m_indexValid || this->m_indexRole != this->filterRole() || this->m_indexMode != this->m_filterMode || indexCount != this->getList()->itemsCount()) {
+        this->buildIndex();
+    }
+
+    if (this->m_filterMode == FILTER_MODE::FUZZY) {
+        this->matchFuzzyFilter(filter);
+        return;
+    }
+
+    // a filter that extends the previous one can only accept rows that were already accepted
+    const auto sensitivity = this->filterCaseSensitivity();
+    const bool refine = !this->m_matchedFilter.isEmpty() && filter.contains(this->m_matchedFilter, sensitivity);
+    auto rows = refine ? this->m_index.match(filter, this->m_matchedRows) : this->m_index.match(filter);
+
+    // the index ignores the case, so a case sensitive filter checks the candidates again
+    if (sensitivity == Qt::CaseSensitive) {
+        rows.erase(std::remove_if(rows.begin(), rows.end(), [this, &filter](const int &row) {
+            const auto fields = this->rowText(row);
+            return std::none_of(fields.constBegin(), fields.constEnd(), [&filter](const QString &field) {
+                return field.contains(filter, Qt::CaseSensitive);
+            });
+        }), rows.end());
+    }
+
+    this->m_accepted.fill(false, this->m_index.count());
+    for (const auto &row : qAsConst(rows)) {
+        this->m_accepted.setBit(row);
+    }
+
+    this->m_matchedFilter = filter;
+    this->m_matchedRows = rows;
+    this->m_acceptedValid = true;
+}
+
+void MauiModel::matchFuzzyFilter(const QString &filter)
+{
+    // the characters of the previous filter are still there in order, so only its matches can match again
+    const bool refine = !this->m_matchedFilter.isEmpty() && filter.contains(this->m_matchedFilter, Qt::CaseInsensitive);
+    const auto results = refine ? this->m_fuzzyIndex.match(filter, this->m_matchedRows) : this->m_fuzzyIndex.match(filter);
+
+    const auto count = this->m_fuzzyIndex.count();
+    this->m_accepted.fill(false, count);
+    this->m_scores.fill(0, count);
+    this->m_matchedRows.clear();
+    this->m_matchedRows.reserve(results.size());
+
+    for (const auto &result : results) {
+        this->m_accepted.setBit(result.row);
+        this->m_scores[result.row] = result.score;
+        this->m_matchedRows << result.row;
+    }
+
+    this->m_matchedFilter = filter;
+    this->m_acceptedValid = true;
 }
 
 const QString MauiModel::getFilter() const
@@ -123,8 +312,37 @@ int MauiModel::mappedToSource(const int &index) const
     return this->mapToSource(this->index(index, 0)).row();
 }
 
+QVariantList MauiModel::highlights(const int &index) const
+{
+    QVariantList res;
+    if (this->m_filterMode != FILTER_MODE::FUZZY || this->m_matchedFilter.isEmpty() || index >= this->rowCount() || index < 0) {
+        return res;
+    }
+
+    QVector<QPair<int, int>> ranges;
+    FMH::FuzzyMatcher::matchText(this->m_matchedFilter, this->fuzzyText(this->mappedToSource(index)), nullptr, &ranges);
+
+    for (const auto &range : qAsConst(ranges)) {
+        res << QVariant(QVariantList {range.first, range.second});
+    }
+
+    return res;
+}
+
 bool MauiModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
 {
+    if (this->m_acceptedValid && this->m_indexRole == this->filterRole() && this->m_indexMode == this->m_filterMode && sourceRow < this->m_accepted.size() && !this->m_dirtyRows.contains(sourceRow)) {
+        return this->m_accepted.testBit(sourceRow);
+    }
+
+    if (this->filterRegExp().isEmpty()) {
+        return true;
+    }
+
+    if (this->m_filterMode == FILTER_MODE::FUZZY && this->getList()) {
+        return FMH::FuzzyMatcher::matchText(this->m_matchedFilter.isEmpty() ? this->m_filter : this->m_matchedFilter, this->fuzzyText(sourceRow));
+    }
+
     if (this->filterRole() != Qt::DisplayRole) {
         QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
         const auto data = this->sourceModel()->data(index, this->filterRole()).toString();
@@ -145,6 +363,24 @@ bool MauiModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent)
     return false;
 }
 
+bool MauiModel::lessThan(const QModelIndex &sourceLeft, const QModelIndex &sourceRight) const
+{
+    // the best matches go first whatever the order, the sorting only breaks the ties
+    if (this->isRanked()) {
+        const auto left = this->m_scores.value(sourceLeft.row());
+        const auto right = this->m_scores.value(sourceRight.row());
+        if (left != right) {
+            return this->sortOrder() == Qt::AscendingOrder ? left > right : left < right;
+        }
+
+        if (this->m_sort.isEmpty()) {
+            return this->sortOrder() == Qt::AscendingOrder ? sourceLeft.row() < sourceRight.row() : sourceLeft.row() > sourceRight.row();
+        }
+    }
+
+    return QSortFilterProxyModel::lessThan(sourceLeft, sourceRight);
+}
+
 MauiList *MauiModel::getList() const
 {
     return this->m_model->getList();
@@ -170,13 +406,17 @@ void MauiModel::PrivateAbstractListModel::setList(MauiList *value)
             beginInsertRows(QModelIndex(), index, index);
         },  Qt::DirectConnection);
 
+        connect(this->list, &MauiList::preItemsAppendedAt, this, [=](int index, uint count) {
+            beginInsertRows(QModelIndex(), index, index+count-1);
+        },  Qt::DirectConnection);
+
         connect(this->list, &MauiList::preItemAppended, this, [=]() {
-            const int index = this->list->items().size();
+            const int index = this->list->itemsCount();
             beginInsertRows(QModelIndex(), index, index);
         },  Qt::DirectConnection);
 
         connect(this->list, &MauiList::preItemsAppended, this, [=](uint count) {
-            const int index = this->list->items().size();
+            const int index = this->list->itemsCount();
             beginInsertRows(QModelIndex(), index, index+count-1);
         }, Qt::DirectConnection);
 
@@ -188,6 +428,10 @@ void MauiModel::PrivateAbstractListModel::setList(MauiList *value)
             beginRemoveRows(QModelIndex(), index, index);
         }, Qt::DirectConnection);
 
+        connect(this->list, &MauiList::preItemsRemoved, this, [=](int index, uint count) {
+            beginRemoveRows(QModelIndex(), index, index+count-1);
+        }, Qt::DirectConnection);
+
         connect(this->list, &MauiList::postItemRemoved, this, [=]() {
             endRemoveRows();
         }, Qt::DirectConnection);
@@ -196,6 +440,10 @@ void MauiModel::PrivateAbstractListModel::setList(MauiList *value)
             emit this->dataChanged(this->index(index), this->index(index), roles);
         }, Qt::DirectConnection);
 
+        connect(this->list, &MauiList::updateModelRange, this, [=](int index, uint count, QVector<int> roles) {
+            emit this->dataChanged(this->index(index), this->index(index+count-1), roles);
+        }, Qt::DirectConnection);
+
         connect(this->list, &MauiList::preListChanged, this, [=]() {
             beginResetModel();
         }, Qt::DirectConnection);
@@ -240,7 +488,7 @@ int MauiModel::PrivateAbstractListModel::rowCount(const QModelIndex &parent) con
         return 0;
     }
 
-    return list->items().size();
+    return list->itemsCount();
 }
 
 QVariant MauiModel::PrivateAbstractListModel::data(const QModelIndex &index, int role) const
@@ -249,16 +497,7 @@ QVariant MauiModel::PrivateAbstractListModel::data(const QModelIndex &index, int
         return QVariant();
     }
 
-    auto value = list->items().at(index.row())[static_cast<FMH::MODEL_KEY>(role)];
-
-    if (role == FMH::MODEL_KEY::ADDDATE || role == FMH::MODEL_KEY::DATE || role == FMH::MODEL_KEY::MODIFIED || role == FMH::MODEL_KEY::RELEASEDATE) {
-        const auto date = QDateTime::fromString(value, Qt::TextDate);
-        if (date.isValid()) {
-            return date;
-        }
-    }
-
-    return value;
+    return list->itemData(index.row(), static_cast<FMH::MODEL_KEY>(role));
 }
 
 bool MauiModel::PrivateAbstractListModel::setData(const QModelIndex &index, const QVariant &value, int role)
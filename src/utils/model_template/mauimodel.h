@@ -21,11 +21,15 @@
 #define MAUIMODEL_H
 
 #include <QAbstractListModel>
+#include <QBitArray>
 #include <QList>
 #include <QObject>
+#include <QSet>
 #include <QSortFilterProxyModel>
 
+#include "fuzzymatcher.h"
 #include "mauikit_export.h"
+#include "textfilter.h"
 
 class MauiList;
 
@@ -42,8 +46,15 @@ class MAUIKIT_EXPORT MauiModel : public QSortFilterProxyModel
     Q_PROPERTY(QString filter READ getFilter WRITE setFilter NOTIFY filterChanged)
     Q_PROPERTY(Qt::SortOrder sortOrder READ getSortOrder WRITE setSortOrder NOTIFY sortOrderChanged)
     Q_PROPERTY(QString sort READ getSort WRITE setSort NOTIFY sortChanged)
+    Q_PROPERTY(MauiModel::FILTER_MODE filterMode READ getFilterMode WRITE setFilterMode NOTIFY filterModeChanged)
 
 public:
+    enum FILTER_MODE : uint_fast8_t {
+        SUBSTRING, // rows holding the filter text
+        FUZZY // rows holding the filter characters in order, ranked by how well they match
+    };
+    Q_ENUM(FILTER_MODE)
+
     MauiModel(QObject *parent = nullptr);
 
     /**
@@ -81,8 +92,24 @@ public:
      */
     const QString getFilter() const;
 
+    /**
+     * @brief getFilterMode
+     * How the filter is matched
+     * @return
+     */
+    MauiModel::FILTER_MODE getFilterMode() const;
+
+    /**
+     * @brief setFilterMode
+     * The fuzzy mode matches the filter role, or the label when there is none, and while there is a filter the rows
+     * are sorted by how well they match
+     * @param mode
+     */
+    void setFilterMode(const MauiModel::FILTER_MODE &mode);
+
 protected:
     bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+    bool lessThan(const QModelIndex &sourceLeft, const QModelIndex &sourceRight) const override;
 
 private:
     class PrivateAbstractListModel;
@@ -90,6 +117,29 @@ private:
     QString m_filter;
     Qt::SortOrder m_sortOrder;
     QString m_sort;
+    MauiModel::FILTER_MODE m_filterMode = FILTER_MODE::SUBSTRING;
+
+    FMH::TextFilter m_index; // searchable text of every row, built on the first filter after a change
+    FMH::FuzzyMatcher m_fuzzyIndex; // the same for the fuzzy mode
+    bool m_indexValid = false;
+    int m_indexRole = Qt::DisplayRole;
+    MauiModel::FILTER_MODE m_indexMode = FILTER_MODE::SUBSTRING;
+    QSet<int> m_dirtyRows; // rows changed since the index was built, they are checked one by one
+
+    QString m_matchedFilter; // filter the accepted rows were matched against
+    QVector<int> m_matchedRows;
+    QBitArray m_accepted;
+    QVector<int> m_scores; // fuzzy score of every accepted row
+    bool m_acceptedValid = false;
+
+    void invalidateIndex();
+    void buildIndex();
+    void matchFilter(const QString &filter);
+    void matchFuzzyFilter(const QString &filter);
+    QStringList rowText(const int &row) const;
+    QString fuzzyText(const int &row) const;
+    bool isRanked() const;
+    void applyRanking();
 
     [[deprecated]]
     void setFilterString(const QString &string);
@@ -152,11 +202,22 @@ public slots:
      * @return
      */
     int mappedToSource(const int &index) const;
+
+    /**
+     * @brief highlights
+     * Parts of the text matched by the fuzzy filter, to be highlighted in the view
+     * @param index
+     * Index of the item in the model
+     * @return
+     * List of pairs of start and length, empty if the mode is not fuzzy or there is no filter
+     */
+    QVariantList highlights(const int &index) const;
 signals:
     void listChanged();
     void filterChanged(QString filter);
     void sortOrderChanged(Qt::SortOrder sortOrder);
     void sortChanged(QString sort);
+    void filterModeChanged();
 };
 
 class MauiModel::PrivateAbstractListModel : public QAbstractListModel
@@ -19,10 +19,19 @@
  */
 
 #include "tagging.h"
-#include <QMimeDatabase>
 #include <QNetworkInterface>
 #include <QCoreApplication>
 #include "utils.h"
+#include "mimecache.h"
+
+/**
+ * The tagged urls can be either local paths or file urls
+ */
+static QString mimeName(const QString &url)
+{
+    const QUrl path(url);
+    return FMH::MimeCache::lookup(path.isLocalFile() ? path.toLocalFile() : url).name;
+}
 
 Tagging::Tagging() : TAGDB()
 {
@@ -117,13 +126,10 @@ bool Tagging::tagUrl(const QString &url, const QString &tag, const QString &colo
 
     this->tag(myTag, color, comment);
 
-    QMimeDatabase mimedb;
-    auto mime = mimedb.mimeTypeForFile(url);
-
     QVariantMap tag_url_map {{FMH::MODEL_NAME[FMH::MODEL_KEY::URL], url},
         {FMH::MODEL_NAME[FMH::MODEL_KEY::TAG], myTag},
         {FMH::MODEL_NAME[FMH::MODEL_KEY::TITLE], QFileInfo(url).baseName()},
-        {FMH::MODEL_NAME[FMH::MODEL_KEY::MIME], mime.name()},
+        {FMH::MODEL_NAME[FMH::MODEL_KEY::MIME], mimeName(url)},
         {FMH::MODEL_NAME[FMH::MODEL_KEY::ADDDATE], QDateTime::currentDateTime()},
         {FMH::MODEL_NAME[FMH::MODEL_KEY::COMMENT], comment}};
 
@@ -137,15 +143,13 @@ bool Tagging::addUrlTags(const QList<QString> &urls, const QString &tag)
 
     this->tag(myTag, "", "");
 
-    QMimeDatabase mimedb;
     QList<QHash<QString,QString>> datas;
     foreach (QString url, urls) {
         QHash<QString,QString> data;
-        auto mime = mimedb.mimeTypeForFile(url);
         data.insert(FMH::MODEL_NAME[FMH::MODEL_KEY::URL],url);
         data.insert(FMH::MODEL_NAME[FMH::MODEL_KEY::TAG],myTag);
         data.insert(FMH::MODEL_NAME[FMH::MODEL_KEY::TITLE], QFileInfo(url).baseName());
-        data.insert(FMH::MODEL_NAME[FMH::MODEL_KEY::MIME], mime.name());
+        data.insert(FMH::MODEL_NAME[FMH::MODEL_KEY::MIME], mimeName(url));
         data.insert(FMH::MODEL_NAME[FMH::MODEL_KEY::ADDDATE], QDateTime::currentDateTime().toString());
         data.insert(FMH::MODEL_NAME[FMH::MODEL_KEY::COMMENT], comment);
         datas.append(data);
@@ -0,0 +1,207 @@
+#include "textfilter.h"
+
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define TEXTFILTER_AVX2
+#endif
+
+using namespace FMH;
+
+typedef int (*FindFunction)(const ushort *text, int from, int to, const ushort *query, int length);
+
+static inline bool equalsAt(const ushort *text, const ushort *query, const int &length)
+{
+    return memcmp(text, query, static_cast<size_t>(length) * sizeof(ushort)) == 0;
+}
+
+// first position in [from, to) where the whole query fits and matches, or -1
+static int findScalar(const ushort *text, int from, int to, const ushort *query, int length)
+{
+    for (int i = from; i <= to - length; i++) {
+        if (text[i] == query[0] && equalsAt(text + i, query, length)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * The SIMD versions compare a block of positions against the first and the last character of the query at once, and
+ * only the positions matching both are compared in full. The tail that does not fill a block goes through the scalar
+ * version.
+ */
+#if defined(__SSE2__)
+static int findSse2(const ushort *text, int from, int to, const ushort *query, int length)
+{
+    const auto first = _mm_set1_epi16(static_cast<short>(query[0]));
+    const auto last = _mm_set1_epi16(static_cast<short>(query[length - 1]));
+
+    int i = from;
+    for (; i + length - 1 + 8 <= to; i += 8) {
+        const auto head = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+        const auto tail = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i + length - 1));
+
+        // two bits per character
+        auto mask = static_cast<uint>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi16(head, first), _mm_cmpeq_epi16(tail, last))));
+        while (mask) {
+            const auto bit = qCountTrailingZeroBits(mask);
+            if (equalsAt(text + i + bit / 2, query, length)) {
+                return i + static_cast<int>(bit / 2);
+            }
+            mask &= ~(3u << bit);
+        }
+    }
+
+    return findScalar(text, i, to, query, length);
+}
+#endif
+
+#if defined(TEXTFILTER_AVX2)
+__attribute__((target("avx2"))) static int findAvx2(const ushort *text, int from, int to, const ushort *query, int length)
+{
+    const auto first = _mm256_set1_epi16(static_cast<short>(query[0]));
+    const auto last = _mm256_set1_epi16(static_cast<short>(query[length - 1]));
+
+    int i = from;
+    for (; i + length - 1 + 16 <= to; i += 16) {
+        const auto head = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i));
+        const auto tail = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i + length - 1));
+
+        auto mask = static_cast<uint>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi16(head, first), _mm256_cmpeq_epi16(tail, last))));
+        while (mask) {
+            const auto bit = qCountTrailingZeroBits(mask);
+            if (equalsAt(text + i + bit / 2, query, length)) {
+                return i + static_cast<int>(bit / 2);
+            }
+            mask &= ~(3u << bit);
+        }
+    }
+
+    return findScalar(text, i, to, query, length);
+}
+#endif
+
+static FindFunction findFunction()
+{
+#if defined(TEXTFILTER_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return findAvx2;
+    }
+#endif
+
+#if defined(__SSE2__)
+    return findSse2;
+#else
+    return findScalar;
+#endif
+}
+
+static int find(const ushort *text, int from, int to, const ushort *query, int length)
+{
+    static const FindFunction function = findFunction();
+    return function(text, from, to, query, length);
+}
+
+void TextFilter::append(const QStringList &fields)
+{
+    for (const auto &field : fields) {
+        const auto folded = field.toCaseFolded();
+        const auto size = m_text.size();
+        m_text.resize(size + folded.size() + 1);
+        memcpy(m_text.data() + size, folded.utf16(), static_cast<size_t>(folded.size()) * sizeof(ushort));
+        m_text[size + folded.size()] = 0;
+    }
+
+    m_offsets << m_text.size();
+}
+
+void TextFilter::clear()
+{
+    m_text.clear();
+    m_offsets = {0};
+}
+
+int TextFilter::count() const
+{
+    return m_offsets.size() - 1;
+}
+
+int TextFilter::rowAt(const int &position) const
+{
+    return static_cast<int>(std::upper_bound(m_offsets.constBegin(), m_offsets.constEnd(), position) - m_offsets.constBegin()) - 1;
+}
+
+QVector<int> TextFilter::match(const QString &text, const CancelToken &token) const
+{
+    QVector<int> res;
+
+    if (text.isEmpty()) {
+        res.resize(this->count());
+        std::iota(res.begin(), res.end(), 0);
+        return res;
+    }
+
+    const auto query = text.toCaseFolded();
+    const auto data = m_text.constData();
+    const auto end = m_text.size();
+
+    int position = 0;
+    int checks = 0;
+    while (position < end) {
+        if (++checks % 1024 == 0 && token.isCancelled()) {
+            break;
+        }
+
+        const auto found = find(data, position, end, query.utf16(), query.size());
+        if (found < 0) {
+            break;
+        }
+
+        // the rest of the row does not matter anymore
+        const auto row = this->rowAt(found);
+        res << row;
+        position = m_offsets.at(row + 1);
+    }
+
+    return res;
+}
+
+QVector<int> TextFilter::match(const QString &text, const QVector<int> &rows, const CancelToken &token) const
+{
+    if (text.isEmpty()) {
+        return rows;
+    }
+
+    QVector<int> res;
+    const auto query = text.toCaseFolded();
+    const auto data = m_text.constData();
+
+    for (int i = 0; i < rows.size(); i++) {
+        if (i % 1024 == 0 && token.isCancelled()) {
+            break;
+        }
+
+        const auto row = rows.at(i);
+        if (row < 0 || row >= this->count()) {
+            continue;
+        }
+
+        if (find(data, m_offsets.at(row), m_offsets.at(row + 1), query.utf16(), query.size()) >= 0) {
+            res << row;
+        }
+    }
+
+    return res;
+}
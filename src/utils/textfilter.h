@@ -0,0 +1,74 @@
+#ifndef TEXTFILTER_H
+#define TEXTFILTER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "fmh.h"
+#include "mauikit_export.h"
+
+namespace FMH
+{
+/**
+ * @brief The TextFilter class
+ * Case insensitive substring filter over the searchable fields of a list of rows.
+ * The fields are case folded once and kept together in a single UTF-16 buffer, separated so a match never spans two
+ * of them. The buffer is scanned with SSE2 or AVX2 instructions when the processor has them, and with plain code
+ * otherwise. The matches are returned as row numbers, so the rows themselves are never copied.
+ */
+class MAUIKIT_EXPORT TextFilter
+{
+public:
+    /**
+     * @brief append
+     * Adds a row at the end
+     * @param fields
+     * Searchable fields of the row
+     */
+    void append(const QStringList &fields);
+
+    /**
+     * @brief clear
+     * Removes all the rows
+     */
+    void clear();
+
+    /**
+     * @brief count
+     * @return
+     * Number of rows
+     */
+    int count() const;
+
+    /**
+     * @brief match
+     * Finds the rows with a field containing the given text, ignoring the case. An empty text matches every row
+     * @param text
+     * @param token
+     * Once it is cancelled the matching stops and returns what it found so far
+     * @return
+     * Numbers of the matching rows, in ascending order
+     */
+    QVector<int> match(const QString &text, const CancelToken &token = CancelToken()) const;
+
+    /**
+     * @brief match
+     * Same as above, but only the given rows are checked. Useful to refine the result of a previous match
+     * @param text
+     * @param rows
+     * Row numbers, in ascending order
+     * @param token
+     * @return
+     */
+    QVector<int> match(const QString &text, const QVector<int> &rows, const CancelToken &token = CancelToken()) const;
+
+private:
+    QVector<ushort> m_text; // case folded fields, each one followed by a null character
+    QVector<int> m_offsets = {0}; // start of each row in the buffer, the last one is the end of the buffer
+
+    int rowAt(const int &position) const;
+};
+}
+
+#endif // TEXTFILTER_H